@@ -0,0 +1,32 @@
+# - Find zstd
+# Find the native zstd includes and library
+#
+#  ZSTD_INCLUDE_DIR - where to find zstd.h, etc.
+#  ZSTD_LIBRARIES   - List of libraries when using zstd.
+#  ZSTD_FOUND       - True if zstd found.
+
+find_path(ZSTD_INCLUDE_DIR zstd.h)
+
+find_library(ZSTD_LIBRARY NAMES zstd)
+
+if (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+  set(ZSTD_FOUND TRUE)
+  set( ZSTD_LIBRARIES ${ZSTD_LIBRARY} )
+else ()
+  set(ZSTD_FOUND FALSE)
+  set( ZSTD_LIBRARIES )
+endif ()
+
+if (ZSTD_FOUND)
+  message(STATUS "Found zstd: ${ZSTD_LIBRARY}")
+else ()
+  message(STATUS "Not Found zstd")
+  if (ZSTD_FIND_REQUIRED)
+    message(FATAL_ERROR "Could NOT find zstd library")
+  endif ()
+endif ()
+
+mark_as_advanced(
+  ZSTD_LIBRARY
+  ZSTD_INCLUDE_DIR
+  )
@@ -135,6 +135,11 @@ void ConfigParser::addOptionsGeneral(cli::CLIWrapper& cli) {
     "Seed for all random number generators. 0 means initialize randomly");
   cli.add<float>("--clip-gemm",
     "If not 0 clip GEMM input values to +/- arg");
+  cli.add<bool>("--profile-ops",
+    "Log the time, call count, estimated FLOP/s and bandwidth per operator and shape, during training "
+    "with the progress display and in total at the end. Synchronizes the device after each operator");
+  cli.add<std::string>("--profile-ops-trace",
+    "Write every profiled operator to file  arg  in Chrome trace format (chrome://tracing), implies --profile-ops");
   cli.add<bool>("--interpolate-env-vars",
     "allow the use of environment variables in paths, of the form ${VAR_NAME}");
   cli.add<bool>("--relative-paths",
@@ -355,6 +360,12 @@ void ConfigParser::addOptionsTraining(cli::CLIWrapper& cli) {
       "Maximum lines to train SentencePiece vocabulary, selected with sampling from all data. "
       "When set to 0 all lines are going to be used.",
       10000000);
+  cli.add<size_t>("--sentencepiece-cache-size",
+      "Cache SentencePiece encodings of up to  arg  most recently used words or lines, 0 disables the cache");
+  cli.add<std::string>("--sentencepiece-cache-mode",
+      "Cache SentencePiece encodings per whitespace-delimited word or per full line: words, lines. "
+      "Falls back to lines for models that do not encode lines word by word",
+      "words");
 #endif
   // scheduling options
   cli.add<size_t>("--after-epochs,-e",
@@ -368,11 +379,22 @@ void ConfigParser::addOptionsTraining(cli::CLIWrapper& cli) {
       "Display information for the first  arg  updates");
   cli.add<bool>("--disp-label-counts",
       "Display label counts when logging loss progress");
+  cli.add<bool>("--phase-timers",
+      "Display the time spent in data loading, forward, backward, communication, optimizer update, "
+      "validation and saving, summed over all threads, with the training progress");
+  cli.add<std::string>("--phase-trace",
+      "Write the timed phases to file  arg  in Chrome trace format (chrome://tracing), implies --phase-timers. "
+      "With MPI, the rank is appended to the file name");
 //   cli.add<int>("--disp-label-index",
 //       "Display label counts based on i-th input stream (-1 is last)", -1);
   cli.add<std::string/*SchedulerPeriod*/>("--save-freq",
       "Save model file every  arg  updates (append 't' for every  arg  target labels)",
       "10000u");
+  cli.add<size_t>("--save-async",
+      "Copy model and optimizer state to CPU memory when saving and write the files in the background "
+      "while training continues, with at most  arg  checkpoints in flight. 0 means save synchronously. "
+      "Shards of --sharded-checkpoints are still written synchronously. Only used by synchronous SGD",
+      0)->implicit_val("1");
 
   addSuboptionsInputLength(cli);
 
@@ -412,6 +434,21 @@ void ConfigParser::addOptionsTraining(cli::CLIWrapper& cli) {
 
   cli.add<bool>("--sync-sgd",
      "Use synchronous SGD instead of asynchronous for multi-gpu training");
+  cli.add<size_t>("--gradient-bucket-mb",
+     "Synchronous SGD: reduce gradients in buckets of  arg  MB, each as soon as the backward pass has "
+     "completed it on all devices, overlapping communication with computation. 0 means reduce after "
+     "the backward pass. Not supported with NCCL or MPI",
+     0)->implicit_val("25");
+  cli.add<bool>("--sharded-checkpoints",
+     "Synchronous SGD: each MPI process saves and loads only its own shard of the optimizer state and "
+     "smoothed parameters, to model.npz.optimizer.shard<rank>.npz with manifest model.npz.optimizer.shards.yml");
+  cli.add<bool>("--async-compress-gradients",
+     "Asynchronous SGD: send gradients to the parameter shards as float16, halving the transfer volume. "
+     "Gradients are scaled dynamically, updates with overflows are skipped");
+  cli.add<std::vector<std::string>>("--async-compress-scaling",
+     "Dynamic scaling of the float16 gradients of --async-compress-gradients: "
+     "power of 2, scaling window, scaling factor",
+     {"7", "2000", "2"});
 
   // learning rate options
   cli.add<float>("--learn-rate,-l",
@@ -581,6 +618,11 @@ void ConfigParser::addOptionsValidation(cli::CLIWrapper& cli) {
       "Keep best model for each validation metric");
   cli.add<std::string>("--valid-log",
      "Log validation scores to file given by  arg");
+  cli.add<size_t>("--valid-async",
+     "Validate on a copy of the parameters in  arg  CPU graphs in a background thread while training "
+     "continues. Results are applied when they arrive, at most one validation is in flight. "
+     "Each graph holds a copy of the model. 0 means validate on the training graphs",
+     0)->implicit_val("1");
   cli.switchGroup(previous_group);
   // clang-format on
 }
@@ -621,6 +663,12 @@ void ConfigParser::addOptionsTranslation(cli::CLIWrapper& cli) {
 #ifdef USE_SENTENCEPIECE
   cli.add<bool>("--no-spm-decode",
       "Keep the output segmented into SentencePiece subwords");
+  cli.add<size_t>("--sentencepiece-cache-size",
+      "Cache SentencePiece encodings of up to  arg  most recently used words or lines, 0 disables the cache");
+  cli.add<std::string>("--sentencepiece-cache-mode",
+      "Cache SentencePiece encodings per whitespace-delimited word or per full line: words, lines. "
+      "Falls back to lines for models that do not encode lines word by word",
+      "words");
 #endif
 
   addSuboptionsDevices(cli);
@@ -631,6 +679,11 @@ void ConfigParser::addOptionsTranslation(cli::CLIWrapper& cli) {
       "Optimize speed aggressively sacrificing memory or precision");
   cli.add<bool>("--skip-cost",
       "Ignore model cost during translation, not recommended for beam-size > 1");
+  cli.add<bool>("--memory-planning",
+      "Place the intermediate values of repeated forward passes with the same operations at offsets planned "
+      "from their lifetimes, instead of allocating each value separately");
+  cli.add<bool>("--fuse-elementwise",
+      "Compute chains of element-wise operations, e.g. a * b + c or sigmoid(x) * y, with one kernel per chain");
   cli.add<bool>("--fp16",
       "Shortcut for mixed precision inference with float16, corresponds to: --precision float16");
   cli.add<std::vector<std::string>>("--precision",
@@ -747,8 +800,17 @@ void ConfigParser::addSuboptionsBatching(cli::CLIWrapper& cli) {
     cli.add<size_t>("--mini-batch-fit-step",
       "Step size for mini-batch-fit statistics",
       10);
+    cli.add<std::string>("--mini-batch-fit-cache",
+      "Save mini-batch-fit statistics next to the model and reuse them when restarting with the same "
+      "configuration: none, reuse, validate (reuse after checking that the largest cached batches still fit)",
+      "none")
+      ->implicit_val("validate");
     cli.add<bool>("--gradient-checkpointing",
       "Enable gradient-checkpointing to minimize memory usage");
+    cli.add<size_t>("--gradient-checkpointing-budget",
+      "Select checkpoints automatically such that the activations kept for the backward pass fit "
+      "into  arg  MB per device, recomputing as little as possible. Implies --gradient-checkpointing",
+      0);
   }
 
   cli.add<int>("--maxi-batch",
@@ -757,10 +819,20 @@ void ConfigParser::addSuboptionsBatching(cli::CLIWrapper& cli) {
   cli.add<std::string>("--maxi-batch-sort",
       "Sorting strategy for maxi-batch: none, src, trg (not available for decoder)",
       defaultMaxiBatchSort);
+  if(mode_ == cli::mode::translation) {
+    cli.add<size_t>("--maxi-batch-timeout",
+      "Translate a partial maxi-batch if no more input arrived within  arg  milliseconds after its "
+      "first line, e.g. when reading from a pipe. 0 means always wait for a full maxi-batch",
+      0);
+  }
 
   if(mode_ == cli::mode::training) {
     cli.add<bool>("--shuffle-in-ram",
         "Keep shuffled corpus in RAM, do not write to temp file");
+    cli.add<size_t>("--shuffle-shards",
+        "Shuffle corpus on disk with bounded memory: randomly partition it into  arg  temporary shards "
+        "which are shuffled in RAM one at a time while reading. 0 means read the full corpus into RAM for shuffling",
+        0);
     // @TODO: Consider making the next two options options of the vocab instead, to make it more local in scope.
     cli.add<size_t>("--all-caps-every",
         "When forming minibatches, preprocess every Nth line on the fly to all-caps. Assumes UTF-8");
@@ -123,6 +123,9 @@ void ConfigValidator::validateOptionsTraining() const {
                && get<std::vector<size_t>>("lr-decay-start").size() != 1,
            "Single decay strategies require only one value specified with --lr-decay-start option");
 
+  ABORT_IF(get<bool>("shuffle-in-ram") && get<size_t>("shuffle-shards") > 0,
+           "Options --shuffle-in-ram and --shuffle-shards are mutually exclusive");
+
   // validate ULR options
   ABORT_IF((has("ulr") && get<bool>("ulr") && (get<std::string>("ulr-query-vectors") == ""
                                                || get<std::string>("ulr-keys-vectors") == "")),
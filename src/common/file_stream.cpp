@@ -1,8 +1,16 @@
 #include "common/file_stream.h"
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
 #include <streambuf>
 #include <string>
+#include <thread>
 #include <vector>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 #ifdef _MSC_VER
 #include <io.h>
 #include <windows.h>
@@ -16,6 +24,233 @@
 namespace marian {
 namespace io {
 
+namespace {
+
+#ifdef USE_ZSTD
+// Decompresses a stream of one or more zstd frames read from another stream buffer.
+class ZstdInputStreamBuf : public std::streambuf {
+private:
+  std::streambuf* source_;
+  ZSTD_DStream* stream_;
+  std::vector<char> in_;
+  std::vector<char> out_;
+  ZSTD_inBuffer input_{nullptr, 0, 0};
+  size_t frameRemaining_{0}; // 0 at the end of a frame, so that truncated files can be detected
+  bool pending_{false};      // the decoder may hold more output without further input
+
+public:
+  ZstdInputStreamBuf(std::streambuf* source)
+      : source_(source), stream_(ZSTD_createDStream()), in_(ZSTD_DStreamInSize()), out_(ZSTD_DStreamOutSize()) {
+    ABORT_IF(!stream_, "Cannot create zstd decompression stream");
+    ZSTD_initDStream(stream_);
+    setg(out_.data(), out_.data(), out_.data());
+  }
+
+  ~ZstdInputStreamBuf() { ZSTD_freeDStream(stream_); }
+
+  int_type underflow() override {
+    if(gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+    for(;;) {
+      if(input_.pos == input_.size && !pending_) {
+        std::streamsize n = source_->sgetn(in_.data(), in_.size());
+        if(n <= 0) {
+          ABORT_IF(frameRemaining_ != 0, "Truncated zstd stream");
+          return traits_type::eof();
+        }
+        input_ = {in_.data(), (size_t)n, 0};
+      }
+      ZSTD_outBuffer output = {out_.data(), out_.size(), 0};
+      frameRemaining_ = ZSTD_decompressStream(stream_, &output, &input_);
+      ABORT_IF(ZSTD_isError(frameRemaining_), "zstd decompression failed: {}", ZSTD_getErrorName(frameRemaining_));
+      pending_ = output.pos == output.size;
+      if(output.pos > 0) {
+        setg(out_.data(), out_.data(), out_.data() + output.pos);
+        return traits_type::to_int_type(*gptr());
+      }
+    }
+  }
+};
+
+// Compresses into another stream buffer. Every sync() ends the current zstd frame and flushes the
+// target, so that everything written so far can be read back; the next write starts a new frame.
+class ZstdOutputStreamBuf : public std::streambuf {
+private:
+  std::streambuf* sink_;
+  ZSTD_CCtx* stream_;
+  std::vector<char> in_;
+  std::vector<char> out_;
+  bool frameOpen_{false};
+
+  bool compress(ZSTD_EndDirective mode) {
+    ZSTD_inBuffer input = {pbase(), (size_t)(pptr() - pbase()), 0};
+    frameOpen_ |= input.size > 0;
+    for(;;) {
+      ZSTD_outBuffer output = {out_.data(), out_.size(), 0};
+      size_t remaining = ZSTD_compressStream2(stream_, &output, &input, mode);
+      ABORT_IF(ZSTD_isError(remaining), "zstd compression failed: {}", ZSTD_getErrorName(remaining));
+      if(sink_->sputn(out_.data(), output.pos) != (std::streamsize)output.pos)
+        return false;
+      if(mode == ZSTD_e_continue ? input.pos == input.size : remaining == 0)
+        break;
+    }
+    setp(in_.data(), in_.data() + in_.size());
+    return true;
+  }
+
+public:
+  ZstdOutputStreamBuf(std::streambuf* sink, int level, int workers)
+      : sink_(sink), stream_(ZSTD_createCCtx()), in_(ZSTD_CStreamInSize()), out_(ZSTD_CStreamOutSize()) {
+    ABORT_IF(!stream_, "Cannot create zstd compression stream");
+    ZSTD_CCtx_setParameter(stream_, ZSTD_c_compressionLevel, level);
+    // compress on worker threads if the library supports it, otherwise this fails and is ignored
+    if(workers > 0)
+      ZSTD_CCtx_setParameter(stream_, ZSTD_c_nbWorkers, workers);
+    setp(in_.data(), in_.data() + in_.size());
+  }
+
+  ~ZstdOutputStreamBuf() {
+    sync(); // errors are ignored, as in std::filebuf
+    ZSTD_freeCCtx(stream_);
+  }
+
+  int_type overflow(int_type c) override {
+    if(!compress(ZSTD_e_continue))
+      return traits_type::eof();
+    if(!traits_type::eq_int_type(c, traits_type::eof()))
+      return sputc(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+  }
+
+  int sync() override {
+    if(pptr() == pbase() && !frameOpen_)
+      return sink_->pubsync();
+    if(!compress(ZSTD_e_end))
+      return -1;
+    frameOpen_ = false;
+    return sink_->pubsync();
+  }
+};
+#endif
+
+// Reads blocks from another stream buffer on a background thread and hands them to the consumer,
+// so that decompression runs in parallel to whatever processes the decompressed data. The thread
+// is started on the first read, as temporary files are opened for reading before they are written.
+class ReadAheadStreamBuf : public std::streambuf {
+private:
+  const size_t BLOCK_SIZE = 4 << 20;
+  const size_t MAX_BLOCKS = 4; // decoded blocks waiting for the consumer
+
+  std::streambuf* source_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::vector<char>> blocks_; // decoded, not consumed yet
+  std::vector<std::vector<char>> spare_; // consumed blocks, to be refilled
+  std::vector<char> current_;            // the get area
+  std::exception_ptr error_;
+  bool eof_{false};
+  bool stop_{false};
+
+  void readLoop() {
+    try {
+      for(;;) {
+        std::vector<char> block;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cv_.wait(lock, [this]() { return stop_ || blocks_.size() < MAX_BLOCKS; });
+          if(stop_)
+            return;
+          if(!spare_.empty()) {
+            block = std::move(spare_.back());
+            spare_.pop_back();
+          }
+        }
+        block.resize(BLOCK_SIZE);
+        std::streamsize n = source_->sgetn(block.data(), block.size());
+        block.resize(n > 0 ? (size_t)n : 0);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        eof_ = block.size() < BLOCK_SIZE;
+        if(!block.empty())
+          blocks_.push_back(std::move(block));
+        cv_.notify_all();
+        if(eof_)
+          return;
+      }
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+      eof_ = true;
+      cv_.notify_all();
+    }
+  }
+
+public:
+  ReadAheadStreamBuf(std::streambuf* source) : source_(source) {}
+
+  ~ReadAheadStreamBuf() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    if(thread_.joinable())
+      thread_.join();
+  }
+
+  int_type underflow() override {
+    if(gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+    if(!thread_.joinable() && !eof_)
+      thread_ = std::thread([this]() { readLoop(); });
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(!current_.empty()) {
+      spare_.push_back(std::move(current_));
+      current_.clear();
+    }
+    cv_.wait(lock, [this]() { return !blocks_.empty() || eof_; });
+    if(blocks_.empty()) {
+      setg(nullptr, nullptr, nullptr);
+      if(error_)
+        std::rethrow_exception(error_);
+      return traits_type::eof();
+    }
+    current_ = std::move(blocks_.front());
+    blocks_.pop_front();
+    cv_.notify_all();
+    setg(current_.data(), current_.data(), current_.data() + current_.size());
+    return traits_type::to_int_type(*gptr());
+  }
+};
+
+// compression levels and worker threads of files with .zst extension. Temporary files, e.g. the
+// shards of the corpus shuffle, are written many at a time and compressed on the writing thread.
+const int ZSTD_OUTPUT_LEVEL = 3;
+const int ZSTD_OUTPUT_WORKERS = 4;
+const int ZSTD_TEMP_LEVEL = 1;
+const int ZSTD_TEMP_WORKERS = 0;
+
+// Returns a compressing stream buffer for the extension of the file name, or nullptr for
+// uncompressed files.
+std::streambuf* newCompressor(const marian::filesystem::Path& file, std::streambuf* sink, int zstdLevel, int zstdWorkers) {
+  if(file.extension() == marian::filesystem::Path(".gz"))
+    return new zstr::ostreambuf(sink);
+  if(file.extension() == marian::filesystem::Path(".zst")) {
+#ifdef USE_ZSTD
+    return new ZstdOutputStreamBuf(sink, zstdLevel, std::min(zstdWorkers, (int)std::thread::hardware_concurrency()));
+#else
+    (void)zstdLevel;
+    (void)zstdWorkers;
+    ABORT("Cannot write '{}': Marian was compiled without zstd support (USE_ZSTD)", file.string());
+#endif
+  }
+  return nullptr;
+}
+
+}  // namespace
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 InputFileStream::InputFileStream(const std::string &file)
     : std::istream(NULL), file_(file) {
@@ -28,7 +263,17 @@ InputFileStream::InputFileStream(const std::string &file)
 
   if(file_.extension() == marian::filesystem::Path(".gz")) {
     streamBuf2_.reset(new zstr::istreambuf(streamBuf1_.get()));
-    this->init(streamBuf2_.get());
+  } else if(file_.extension() == marian::filesystem::Path(".zst")) {
+#ifdef USE_ZSTD
+    streamBuf2_.reset(new ZstdInputStreamBuf(streamBuf1_.get()));
+#else
+    ABORT("Cannot read '{}': Marian was compiled without zstd support (USE_ZSTD)", file);
+#endif
+  }
+
+  if(streamBuf2_) { // decompress on a separate thread
+    streamBuf3_.reset(new ReadAheadStreamBuf(streamBuf2_.get()));
+    this->init(streamBuf3_.get());
   } else {
     this->init(streamBuf1_.get());
   }
@@ -69,12 +314,8 @@ OutputFileStream::OutputFileStream(const std::string &file)
   ABORT_IF(!ret, "File cannot be opened", file);
   ABORT_IF(ret != streamBuf1_.get(), "Return value is not equal to streambuf pointer, that is weird");
 
-  if(file_.extension() == marian::filesystem::Path(".gz")) {
-    streamBuf2_.reset(new zstr::ostreambuf(streamBuf1_.get()));
-    this->init(streamBuf2_.get());
-  } else {
-    this->init(streamBuf1_.get());
-  }
+  streamBuf2_.reset(newCompressor(file_, streamBuf1_.get(), ZSTD_OUTPUT_LEVEL, ZSTD_OUTPUT_WORKERS));
+  this->init(streamBuf2_ ? streamBuf2_.get() : streamBuf1_.get());
 }
 
 OutputFileStream::OutputFileStream()
@@ -85,11 +326,11 @@ OutputFileStream::~OutputFileStream() {
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
-TemporaryFile::TemporaryFile(const std::string &base, bool earlyUnlink)
+TemporaryFile::TemporaryFile(const std::string &base, bool earlyUnlink, bool compressed)
     : OutputFileStream(), unlink_(earlyUnlink) {
   std::string baseTemp(base);
   NormalizeTempPrefix(baseTemp);
-  MakeTemp(baseTemp);
+  MakeTemp(baseTemp, compressed);
 
   inSteam_ = UPtr<io::InputFileStream>(new io::InputFileStream(file_.string()));
   if(unlink_) {
@@ -121,8 +362,10 @@ void TemporaryFile::NormalizeTempPrefix(std::string &base) const {
     base += '/';
 #endif
 }
-void TemporaryFile::MakeTemp(const std::string &base) {
+void TemporaryFile::MakeTemp(const std::string &base, bool compressed) {
 #ifdef _MSC_VER
+  (void)compressed; // temporary files are not compressed on Windows
+
   char *name = tempnam(base.c_str(), "marian.");
   ABORT_IF(name == NULL, "Error while making a temporary based on '{}'", base);
 
@@ -134,12 +377,20 @@ void TemporaryFile::MakeTemp(const std::string &base) {
   ABORT_IF(fd == -1, "Error while making a temporary based on '{}'", base);
 
 #else
-  // create temp file
+  // create temp file, the extension selects the compression when it is written and read back
+  std::string suffix;
+#ifdef USE_ZSTD
+  if(compressed)
+    suffix = ".zst";
+#else
+  (void)compressed; // only with zstd, gzip costs more time than it saves in I/O
+#endif
   std::string name(base);
-  name += "marian.XXXXXX";
+  name += "marian.XXXXXX" + suffix;
   name.push_back(0);
-  int fd = mkstemp(&name[0]);
+  int fd = mkstemps(&name[0], (int)suffix.size());
   ABORT_IF(fd == -1, "Error creating temp file {}", name);
+  name.pop_back();
 
   file_ = name;
 #endif
@@ -150,7 +401,8 @@ void TemporaryFile::MakeTemp(const std::string &base) {
   ABORT_IF(!streamBuf1_, "File cannot be temp opened", name);
   ABORT_IF(ret != streamBuf1_.get(), "Return value is not equal to streambuf pointer, that is weird");
 
-  this->init(streamBuf1_.get());
+  streamBuf2_.reset(newCompressor(file_, streamBuf1_.get(), ZSTD_TEMP_LEVEL, ZSTD_TEMP_WORKERS));
+  this->init(streamBuf2_ ? streamBuf2_.get() : streamBuf1_.get());
 
   // close original file descriptor
   ABORT_IF(close(fd), "Can't close file descriptor", name);
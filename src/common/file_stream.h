@@ -38,6 +38,8 @@ namespace marian {
 namespace io {
 
 //////////////////////////////////////////////////////////////////////////////////////////////
+// Files ending in .gz and .zst (if compiled with USE_ZSTD) are decompressed on a background
+// thread that reads ahead of the consumer.
 class InputFileStream : public std::istream {
 public:
   explicit InputFileStream(const std::string& file);
@@ -49,14 +51,16 @@ public:
 
 protected:
   marian::filesystem::Path file_;
-  std::unique_ptr<std::streambuf> streamBuf1_;
-  std::unique_ptr<std::streambuf> streamBuf2_;
+  std::unique_ptr<std::streambuf> streamBuf1_; // file
+  std::unique_ptr<std::streambuf> streamBuf2_; // decompression, if compressed
+  std::unique_ptr<std::streambuf> streamBuf3_; // read-ahead thread over streamBuf2_
   std::vector<char> readBuf_;
 };
 
 std::istream& getline(std::istream& in, std::string& line);
 
 //////////////////////////////////////////////////////////////////////////////////////////////
+// Files ending in .gz and .zst (if compiled with USE_ZSTD) are compressed.
 class OutputFileStream : public std::ostream {
 public:
   explicit OutputFileStream(const std::string& file);
@@ -81,7 +85,8 @@ protected:
 ///////////////////////////////////////////////////////////////////////////////////////////////
 class TemporaryFile : public OutputFileStream {
 public:
-  TemporaryFile(const std::string& base = "/tmp/", bool earlyUnlink = true);
+  // compressed temporary files are written with fast zstd compression if available
+  TemporaryFile(const std::string& base = "/tmp/", bool earlyUnlink = true, bool compressed = false);
   virtual ~TemporaryFile();
 
   UPtr<InputFileStream> getInputStream();
@@ -92,7 +97,7 @@ protected:
   UPtr<InputFileStream> inSteam_;
 
   void NormalizeTempPrefix(std::string& base) const;
-  void MakeTemp(const std::string& base);
+  void MakeTemp(const std::string& base, bool compressed);
 
 };
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <string>
 
 namespace marian {
 namespace util {
@@ -17,5 +19,16 @@ inline void hash_combine(std::size_t& seed, T const& v) {
     seed ^= hasher(v) + 0x9e3779b9 + (seed<<6) + (seed>>2);
 }
 
+// 64-bit FNV-1a hash. Unlike std::hash, the result is the same for every compiler and build,
+// so it can be used for keys that are written to files.
+inline uint64_t fnv1a64(const std::string& data) {
+  uint64_t hash = 14695981039346656037ull;
+  for(unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
 }
 }
\ No newline at end of file
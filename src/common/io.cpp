@@ -5,8 +5,11 @@
 #include "common/types.h"
 
 #include "common/binary.h"
+#include "common/npz.h"
 #include "common/io_item.h"
 
+#include <cstdio>
+
 namespace marian {
 namespace io {
 
@@ -23,9 +26,9 @@ bool isBin(const std::string& fileName) {
 void getYamlFromNpz(YAML::Node& yaml,
                     const std::string& varName,
                     const std::string& fileName) {
-  auto item = cnpy::npz_load(fileName, varName);
-  if(item->size() > 0)
-    yaml = YAML::Load(item->data());
+  auto item = npz::getItem(fileName, varName);
+  if(item.bytes.size() > 0)
+    yaml = YAML::Load(item.data());
 }
 
 void getYamlFromBin(YAML::Node& yaml,
@@ -76,25 +79,7 @@ void addMetaToItems(const std::string& meta,
 }
 
 void loadItemsFromNpz(const std::string& fileName, std::vector<Item>& items) {
-  auto numpy = cnpy::npz_load(fileName);
-  for(auto it : numpy) {
-    Shape shape;
-    if(it.second->shape.size() == 1) {
-      shape.resize(2);
-      shape.set(0, 1);
-      shape.set(1, (size_t)it.second->shape[0]);
-    } else {
-      shape.resize(it.second->shape.size());
-      for(size_t i = 0; i < it.second->shape.size(); ++i)
-        shape.set(i, (size_t)it.second->shape[i]);
-    }
-
-    Item item;
-    item.name = it.first;
-    item.shape = shape;
-    item.bytes.swap(it.second->bytes);
-    items.emplace_back(std::move(item));
-  }
+  npz::loadItems(fileName, items);
 }
 
 std::vector<Item> loadItems(const std::string& fileName) {
@@ -145,13 +130,21 @@ void saveItemsNpz(const std::string& fileName, const std::vector<Item>& items) {
 }
 
 void saveItems(const std::string& fileName, const std::vector<Item>& items) {
+  // Write to a temporary file next to the target and rename it once complete, so that an
+  // interrupted save (or a reader running concurrently) never sees a partially written file.
+  std::string tempName = fileName + ".tmp";
   if(isNpz(fileName)) {
-    saveItemsNpz(fileName, items);
+    saveItemsNpz(tempName, items);
   } else if(isBin(fileName)) {
-    binary::saveItems(fileName, items);
+    binary::saveItems(tempName, items);
   } else {
     ABORT("Unknown file format for file {}", fileName);
   }
+#ifdef _WIN32
+  std::remove(fileName.c_str()); // rename() does not replace existing files on Windows
+#endif
+  ABORT_IF(std::rename(tempName.c_str(), fileName.c_str()) != 0,
+           "Could not rename {} to {}", tempName, fileName);
 }
 
 }  // namespace io
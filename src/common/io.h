@@ -31,6 +31,7 @@ std::vector<Item> loadItems(const void* ptr);
 
 std::vector<Item> mmapItems(const void* ptr);
 
+// Items are written to fileName + ".tmp" which is then renamed to fileName
 void saveItems(const std::string& fileName, const std::vector<Item>& items);
 
 }  // namespace io
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace marian {
+
+/**
+ * Bounded, thread-safe cache that evicts the least-recently-used entry once it
+ * holds capacity entries. Counts hits and misses of get() for diagnostics.
+ */
+template <class Key, class Value, class Hash = std::hash<Key>>
+class LRUCache {
+private:
+  typedef std::list<std::pair<Key, Value>> Items;
+
+  size_t capacity_;
+  Items items_; // most recently used first
+  std::unordered_map<Key, typename Items::iterator, Hash> index_;
+  mutable std::mutex mutex_;
+
+  size_t hits_{0};
+  size_t misses_{0};
+
+public:
+  explicit LRUCache(size_t capacity) : capacity_(capacity) {
+    index_.reserve(capacity);
+  }
+
+  // copy the cached value for key into value and mark it as most recently used;
+  // returns false if key is not in the cache
+  bool get(const Key& key, Value& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if(it == index_.end()) {
+      misses_++;
+      return false;
+    }
+    hits_++;
+    items_.splice(items_.begin(), items_, it->second);
+    value = it->second->second;
+    return true;
+  }
+
+  void put(const Key& key, const Value& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(capacity_ == 0)
+      return;
+    auto it = index_.find(key);
+    if(it != index_.end()) { // (another thread may have inserted it meanwhile)
+      it->second->second = value;
+      items_.splice(items_.begin(), items_, it->second);
+      return;
+    }
+    if(items_.size() >= capacity_) {
+      index_.erase(items_.back().first);
+      items_.pop_back();
+    }
+    items_.emplace_front(key, value);
+    index_[key] = items_.begin();
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+  }
+
+  size_t hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+  }
+
+  size_t misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
+
+  double hitRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = hits_ + misses_;
+    return total == 0 ? 0. : (double)hits_ / (double)total;
+  }
+};
+
+}  // namespace marian
@@ -0,0 +1,291 @@
+#include "common/npz.h"
+#include "3rd_party/threadpool.h"
+#include "common/logging.h"
+#include "common/types.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace marian {
+namespace io {
+namespace npz {
+
+namespace {
+
+// little-endian fields of zip headers
+uint16_t get16(const char* p) { return (uint16_t)((uint8_t)p[0] | (uint8_t)p[1] << 8); }
+uint32_t get32(const char* p) { return (uint32_t)get16(p) | (uint32_t)get16(p + 2) << 16; }
+uint64_t get64(const char* p) { return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32; }
+
+const uint16_t STORED = 0;
+const uint16_t DEFLATED = 8;
+
+// an archive member as described by the central directory
+struct Member {
+  std::string name;
+  uint16_t method;
+  uint64_t compressedSize;
+  uint64_t size;
+  uint64_t headerOffset;
+};
+
+void readAt(std::ifstream& file, uint64_t offset, char* out, size_t bytes, const std::string& fileName) {
+  file.seekg(offset);
+  file.read(out, bytes);
+  ABORT_IF((size_t)file.gcount() != bytes, "Unexpected end of npz file {}", fileName);
+}
+
+std::vector<Member> readDirectory(const std::string& fileName) {
+  std::ifstream file(fileName, std::ios::binary);
+  ABORT_IF(!file, "Cannot open npz file {}", fileName);
+  file.seekg(0, std::ios::end);
+  uint64_t fileSize = file.tellg();
+
+  // the end of central directory record is followed by a comment of at most 64KB
+  size_t tail = (size_t)std::min<uint64_t>(fileSize, 22 + 65535);
+  std::vector<char> buffer(tail);
+  readAt(file, fileSize - tail, buffer.data(), tail, fileName);
+  const char* eocd = nullptr;
+  for(size_t i = tail - 22 + 1; i-- > 0;) {
+    if(get32(&buffer[i]) == 0x06054b50) {
+      eocd = &buffer[i];
+      break;
+    }
+  }
+  ABORT_IF(!eocd, "{} is not an npz (zip) file", fileName);
+  uint64_t numMembers = get16(eocd + 10);
+  uint64_t directorySize = get32(eocd + 12);
+  uint64_t directoryOffset = get32(eocd + 16);
+  ABORT_IF(numMembers == 0xFFFF || directoryOffset == 0xFFFFFFFF,
+           "Zip64 archives with more than 65535 members or a directory beyond 4GB are not supported: {}",
+           fileName);
+
+  std::vector<char> directory(directorySize);
+  readAt(file, directoryOffset, directory.data(), directorySize, fileName);
+
+  std::vector<Member> members;
+  const char* p = directory.data();
+  for(uint64_t i = 0; i < numMembers; ++i) {
+    ABORT_IF(p + 46 > directory.data() + directorySize || get32(p) != 0x02014b50,
+             "Corrupt central directory in npz file {}", fileName);
+    Member m;
+    m.method = get16(p + 10);
+    m.compressedSize = get32(p + 20);
+    m.size = get32(p + 24);
+    uint16_t nameLength = get16(p + 28), extraLength = get16(p + 30), commentLength = get16(p + 32);
+    m.headerOffset = get32(p + 42);
+    m.name.assign(p + 46, nameLength);
+
+    // zip64 extended information replaces the fields that are set to 0xFFFFFFFF, in this order
+    const char* extra = p + 46 + nameLength;
+    for(const char* e = extra; e + 4 <= extra + extraLength; e += 4 + get16(e + 2)) {
+      if(get16(e) != 0x0001)
+        continue;
+      const char* field = e + 4;
+      if(m.size == 0xFFFFFFFF)           { m.size = get64(field);           field += 8; }
+      if(m.compressedSize == 0xFFFFFFFF) { m.compressedSize = get64(field); field += 8; }
+      if(m.headerOffset == 0xFFFFFFFF)   { m.headerOffset = get64(field); }
+    }
+
+    ABORT_IF(m.method != STORED && m.method != DEFLATED,
+             "Member {} of npz file {} uses unsupported compression method {}", m.name, fileName, m.method);
+    members.push_back(m);
+    p += 46 + nameLength + extraLength + commentLength;
+  }
+  return members;
+}
+
+// Sequential reader for the uncompressed contents of one member.
+class MemberReader {
+private:
+  const std::string& fileName_;
+  const Member& member_;
+  std::ifstream file_;
+  uint64_t remaining_; // bytes of the member data not read from the file yet
+
+  z_stream stream_;
+  std::vector<char> chunk_;
+
+public:
+  MemberReader(const std::string& fileName, const Member& member)
+      : fileName_(fileName), member_(member), file_(fileName, std::ios::binary) {
+    ABORT_IF(!file_, "Cannot open npz file {}", fileName);
+    char header[30];
+    readAt(file_, member.headerOffset, header, sizeof(header), fileName);
+    ABORT_IF(get32(header) != 0x04034b50, "Corrupt local header of {} in npz file {}", member.name, fileName);
+    // the local extra field may differ from the one in the central directory
+    file_.seekg(member.headerOffset + 30 + get16(header + 26) + get16(header + 28));
+    remaining_ = member.compressedSize;
+
+    if(member.method == DEFLATED) {
+      std::memset(&stream_, 0, sizeof(stream_));
+      ABORT_IF(inflateInit2(&stream_, -MAX_WBITS) != Z_OK, "Cannot initialize zlib"); // raw deflate stream
+      chunk_.resize(1 << 20);
+    }
+  }
+
+  ~MemberReader() {
+    if(member_.method == DEFLATED)
+      inflateEnd(&stream_);
+  }
+
+  // reads exactly the given number of uncompressed bytes into out
+  void read(char* out, size_t bytes) {
+    if(member_.method == STORED) {
+      ABORT_IF(bytes > remaining_, "Unexpected end of {} in npz file {}", member_.name, fileName_);
+      file_.read(out, bytes);
+      ABORT_IF((size_t)file_.gcount() != bytes, "Unexpected end of npz file {}", fileName_);
+      remaining_ -= bytes;
+      return;
+    }
+
+    while(bytes > 0) {
+      if(stream_.avail_in == 0) {
+        ABORT_IF(remaining_ == 0, "Unexpected end of {} in npz file {}", member_.name, fileName_);
+        size_t n = (size_t)std::min<uint64_t>(remaining_, chunk_.size());
+        file_.read(chunk_.data(), n);
+        ABORT_IF((size_t)file_.gcount() != n, "Unexpected end of npz file {}", fileName_);
+        remaining_ -= n;
+        stream_.next_in = (Bytef*)chunk_.data();
+        stream_.avail_in = (uInt)n;
+      }
+      // avail_out is 32 bits wide
+      uInt n = (uInt)std::min<size_t>(bytes, 1u << 30);
+      stream_.next_out = (Bytef*)out;
+      stream_.avail_out = n;
+      int ret = inflate(&stream_, Z_NO_FLUSH);
+      ABORT_IF(ret != Z_OK && ret != Z_STREAM_END, "Cannot inflate {} in npz file {}: {}",
+               member_.name, fileName_, stream_.msg ? stream_.msg : "zlib error");
+      size_t produced = n - stream_.avail_out;
+      ABORT_IF(ret == Z_STREAM_END && produced < bytes,
+               "Unexpected end of {} in npz file {}", member_.name, fileName_);
+      out += produced;
+      bytes -= produced;
+    }
+  }
+};
+
+Type typeFromDescr(const std::string& descr, const std::string& name) {
+  ABORT_IF(descr.size() < 3 || descr[0] == '>', "Unsupported dtype '{}' of {}", descr, name);
+  char kind = descr[1];
+  int size = std::atoi(descr.c_str() + 2);
+  if(kind == 'f' && size == 2) return Type::float16;
+  if(kind == 'f' && size == 4) return Type::float32;
+  if(kind == 'f' && size == 8) return Type::float64;
+  if(kind == 'i' || kind == 'u') {
+    bool isSigned = kind == 'i';
+    switch(size) {
+      case 1: return isSigned ? Type::int8  : Type::uint8;
+      case 2: return isSigned ? Type::int16 : Type::uint16;
+      case 4: return isSigned ? Type::int32 : Type::uint32;
+      case 8: return isSigned ? Type::int64 : Type::uint64;
+    }
+  }
+  if(size == 1) // bool, byte strings
+    return Type::int8;
+  ABORT("Unsupported dtype '{}' of {}", descr, name);
+}
+
+// value of key in the python dict literal of an npy header
+std::string headerValue(const std::string& header, const std::string& key) {
+  size_t pos = header.find("'" + key + "'");
+  ABORT_IF(pos == std::string::npos, "No {} in npy header {}", key, header);
+  pos = header.find(':', pos) + 1;
+  while(header[pos] == ' ')
+    ++pos;
+  size_t end = header[pos] == '(' ? header.find(')', pos) + 1 : header.find_first_of(",}", pos);
+  return header.substr(pos, end - pos);
+}
+
+io::Item readMember(const std::string& fileName, const Member& member) {
+  MemberReader reader(fileName, member);
+
+  char magic[10];
+  reader.read(magic, sizeof(magic));
+  ABORT_IF(std::memcmp(magic, "\x93NUMPY", 6) != 0, "Member {} of {} is not an npy array", member.name, fileName);
+  size_t headerLength = get16(magic + 8);
+  std::string header;
+  if(magic[6] == 1) { // version 1.0 has a 2-byte header length, later versions 4 bytes
+    header.resize(headerLength);
+  } else {
+    char more[2];
+    reader.read(more, 2);
+    header.resize(headerLength | (size_t)get16(more) << 16);
+  }
+  reader.read(&header[0], header.size());
+
+  io::Item item;
+  item.name = member.name.substr(0, member.name.size() - 4); // strip .npy
+  std::string descr = headerValue(header, "descr");
+  item.type = typeFromDescr(descr.substr(1, descr.size() - 2), item.name);
+
+  std::string shapeString = headerValue(header, "shape");
+  std::vector<int> dims;
+  for(size_t pos = 1; pos < shapeString.size();) {
+    size_t end = shapeString.find_first_of(",)", pos);
+    std::string dim = shapeString.substr(pos, end - pos);
+    if(dim.find_first_not_of(' ') != std::string::npos)
+      dims.push_back(std::stoi(dim));
+    pos = end + 1;
+  }
+  if(dims.size() == 1) // vectors are loaded as rows
+    dims.insert(dims.begin(), 1);
+  item.shape.resize(dims.size());
+  for(size_t i = 0; i < dims.size(); ++i)
+    item.shape.set(i, dims[i]);
+
+  size_t elements = 1;
+  for(auto d : dims)
+    elements *= d;
+  item.bytes.resize(elements * sizeOf(item.type));
+  reader.read(item.bytes.data(), item.bytes.size());
+  return item;
+}
+
+}  // namespace
+
+void loadItems(const std::string& fileName, std::vector<io::Item>& items, size_t numThreads) {
+  auto members = readDirectory(fileName);
+  if(members.empty())
+    return;
+
+  if(numThreads == 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  numThreads = std::min(numThreads, members.size());
+
+  // the largest members first, so that they do not end up last on one thread
+  std::vector<size_t> order(members.size());
+  for(size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return members[a].size > members[b].size; });
+
+  size_t first = items.size();
+  items.resize(first + members.size());
+  if(numThreads == 1 || getThrowExceptionOnAbort()) { // the thread pool does not pass on exceptions
+    for(auto i : order)
+      items[first + i] = readMember(fileName, members[i]);
+  } else {
+    ThreadPool pool(numThreads, numThreads);
+    for(auto i : order)
+      pool.enqueue([&, i]() { items[first + i] = readMember(fileName, members[i]); });
+  } // waits for all members
+
+  // same order as the previous loader based on cnpy::npz_load
+  std::sort(items.begin() + first, items.end(), [](const io::Item& a, const io::Item& b) { return a.name < b.name; });
+}
+
+io::Item getItem(const std::string& fileName, const std::string& varName) {
+  for(const auto& member : readDirectory(fileName))
+    if(member.name == varName + ".npy")
+      return readMember(fileName, member);
+  return io::Item();
+}
+
+}  // namespace npz
+}  // namespace io
+}  // namespace marian
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "common/io_item.h"
+
+#include <string>
+#include <vector>
+
+namespace marian {
+namespace io {
+namespace npz {
+
+// Reads the arrays of a numpy .npz archive into items. Members are read by up to numThreads threads
+// in parallel, each directly into the bytes of its item: stored members are read from the file,
+// deflated members (numpy.savez_compressed) are inflated while reading. 0 threads means one per
+// hardware thread.
+void loadItems(const std::string& fileName, std::vector<io::Item>& items, size_t numThreads = 0);
+
+io::Item getItem(const std::string& fileName, const std::string& varName);
+
+}  // namespace npz
+}  // namespace io
+}  // namespace marian
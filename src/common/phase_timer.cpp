@@ -0,0 +1,74 @@
+#include "common/phase_timer.h"
+#include "common/logging.h"
+#include "common/trace_writer.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace marian {
+namespace timer {
+
+namespace {
+
+std::atomic<uint64_t> phaseNanoseconds[(size_t)Phase::count];
+
+TraceWriter trace;
+
+thread_local size_t depth = 0; // number of open intervals on this thread
+
+}  // namespace
+
+std::atomic<bool> PhaseTimers::enabled_{false};
+
+const char* PhaseTimers::name(Phase phase) {
+  switch(phase) {
+    case Phase::data:          return "data";
+    case Phase::forward:       return "forward";
+    case Phase::backward:      return "backward";
+    case Phase::communication: return "communication";
+    case Phase::update:        return "update";
+    case Phase::validation:    return "validation";
+    case Phase::save:          return "save";
+    default: ABORT("Unknown phase {}", (size_t)phase);
+  }
+}
+
+void PhaseTimers::enable(const std::string& traceFileName) {
+  for(auto& ns : phaseNanoseconds)
+    ns = 0;
+  if(!traceFileName.empty() && !trace.isOpen()) {
+    trace.open(traceFileName);
+    LOG(info, "[training] Writing phase trace to {}", traceFileName);
+  }
+  enabled_ = true;
+}
+
+void PhaseTimers::disable() {
+  enabled_ = false;
+  trace.close();
+}
+
+bool PhaseTimers::enter() {
+  return depth++ > 0;
+}
+
+void PhaseTimers::leave(Phase phase, bool nested, clock::time_point begin, clock::time_point end) {
+  --depth;
+  if(!nested)
+    phaseNanoseconds[(size_t)phase]
+        += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  trace.add(name(phase), begin, end);
+}
+
+std::string PhaseTimers::report() {
+  std::stringstream ss;
+  for(size_t i = 0; i < (size_t)Phase::count; ++i) {
+    double seconds = phaseNanoseconds[i].exchange(0) * 1e-9;
+    ss << (i > 0 ? " : " : "") << name((Phase)i) << " " << std::fixed << std::setprecision(2) << seconds << "s";
+  }
+  trace.flush();
+  return ss.str();
+}
+
+}  // namespace timer
+}  // namespace marian
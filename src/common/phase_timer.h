@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace marian {
+namespace timer {
+
+// Phases of a training update that are timed separately (--phase-timers)
+enum class Phase : size_t {
+  data,           // waiting for the next batch
+  forward,        // ExpressionGraph::forward()
+  backward,       // ExpressionGraph::backward()
+  communication,  // ICommunicator reductions and gathers
+  update,         // OptimizerBase::update()
+  validation,     // Scheduler::validate()
+  save,           // saving models and checkpoints
+  count
+};
+
+// Accumulates the wall-clock time spent in each phase across all threads, for a breakdown per
+// display period, and optionally writes every timed interval to a trace file in the Chrome
+// trace event format (chrome://tracing, Perfetto).
+//
+// Intervals nested in an interval of the same thread (e.g. forward passes during validation)
+// only appear in the trace, so the per-phase sums do not count time twice. Phases on different
+// threads may overlap, e.g. the bucketed gradient reduction with the backward pass, hence the
+// sums can exceed the wall-clock time of a display period.
+class PhaseTimers {
+public:
+  using clock = std::chrono::steady_clock;
+
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // start timing; if traceFile is not empty, trace events are written to that file
+  static void enable(const std::string& traceFile = "");
+  // flush and close the trace file and stop timing
+  static void disable();
+
+  // enter() returns true if the calling thread is already inside a timed interval
+  static bool enter();
+  static void leave(Phase phase, bool nested, clock::time_point begin, clock::time_point end);
+
+  // e.g. "data 0.12s : forward 3.40s : ... : update 0.31s", then resets the sums for the next
+  // display period and appends the buffered events to the trace file
+  static std::string report();
+
+  static const char* name(Phase phase);
+
+private:
+  static std::atomic<bool> enabled_;
+};
+
+// Times the enclosing scope as the given phase. Does not read the clock if timing is disabled.
+class ScopedPhase {
+private:
+  Phase phase_;
+  bool active_;
+  bool nested_{false};
+  PhaseTimers::clock::time_point begin_;
+
+public:
+  ScopedPhase(Phase phase) : phase_(phase), active_(PhaseTimers::enabled()) {
+    if(active_) {
+      nested_ = PhaseTimers::enter();
+      begin_ = PhaseTimers::clock::now();
+    }
+  }
+
+  ~ScopedPhase() {
+    if(active_)
+      PhaseTimers::leave(phase_, nested_, begin_, PhaseTimers::clock::now());
+  }
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+};
+
+}  // namespace timer
+}  // namespace marian
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "common/logging.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace marian {
+namespace timer {
+
+// Writes timed intervals to a file in the Chrome trace event format (chrome://tracing, Perfetto).
+// Events are buffered and appended to the file by flush(); add() may be called from any thread.
+class TraceWriter {
+public:
+  using clock = std::chrono::steady_clock;
+
+private:
+  struct Event {
+    std::string name;
+    std::string args; // JSON object members, may be empty
+    size_t thread;
+    clock::time_point begin, end;
+  };
+
+  std::atomic<bool> open_{false};
+  std::mutex mutex_;
+  std::unique_ptr<std::ofstream> file_;
+  std::vector<Event> events_;
+  clock::time_point start_;
+
+  // caller holds mutex_
+  void write() {
+    using namespace std::chrono;
+    for(const auto& e : events_) {
+      *file_ << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread
+             << ",\"ts\":" << duration_cast<microseconds>(e.begin - start_).count()
+             << ",\"dur\":" << duration_cast<microseconds>(e.end - e.begin).count();
+      if(!e.args.empty())
+        *file_ << ",\"args\":{" << e.args << "}";
+      *file_ << "},\n";
+    }
+    file_->flush();
+    events_.clear();
+  }
+
+public:
+  ~TraceWriter() { close(); }
+
+  bool isOpen() const { return open_.load(std::memory_order_relaxed); }
+
+  void open(const std::string& fileName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(file_)
+      return;
+    file_.reset(new std::ofstream(fileName));
+    ABORT_IF(!*file_, "Cannot write trace file {}", fileName);
+    *file_ << "[\n";
+    start_ = clock::now();
+    open_ = true;
+  }
+
+  void add(const std::string& name, clock::time_point begin, clock::time_point end, const std::string& args = "") {
+    if(!isOpen())
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(file_)
+      events_.push_back({name, args, threadIndex(), begin, end});
+  }
+
+  void flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(file_)
+      write();
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(!file_)
+      return;
+    open_ = false;
+    write();
+    // closing the array makes it valid JSON; the metadata event avoids a trailing comma
+    *file_ << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"marian\"}}\n]\n";
+    file_.reset();
+  }
+
+  // small numbers for the "tid" of trace events
+  static size_t threadIndex() {
+    static std::atomic<size_t> numThreads{0};
+    thread_local size_t index = numThreads++;
+    return index;
+  }
+};
+
+}  // namespace timer
+}  // namespace marian
@@ -6,12 +6,15 @@
 #include "training/training_state.h"
 #include "data/iterator_facade.h"
 #include "3rd_party/threadpool.h"
+#include "common/phase_timer.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <mutex>
 #include <queue>
+#include <thread>
 
 namespace marian {
 namespace data {
@@ -87,6 +90,99 @@ private:
   mutable ThreadPool threadPool_; // (we only use one thread, but keep it around)
   std::future<std::deque<BatchPtr>> futureBufferedBatches_; // next swath of batches is returned via this
 
+  // variables for time-based flushing of partial maxi-batches (--maxi-batch-timeout)
+  // In this mode, a dedicated reader thread moves samples from data_ into the reader queue,
+  // so that fetchBatches() can stop waiting for more input once the timeout has passed.
+  typedef std::chrono::steady_clock Clock;
+  std::chrono::milliseconds maxiBatchTimeout_{0};
+
+  // State shared with the reader thread. The thread holds its own references to it and to the
+  // data, so that it can be detached while it is blocked in reading, e.g. a line from stdin.
+  struct ReaderState {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::pair<Sample, Clock::time_point>> queue; // samples with their time of arrival
+    size_t bound{0};
+    bool done{false};
+    bool stop{false};    // set by stopReader() to end readSamples() early
+    bool reading{false}; // the reader is waiting for the data set to return the next sample
+  };
+  Ptr<ReaderState> reader_;
+  std::thread readerThread_;
+
+  // this runs on readerThread_
+  static void readSamples(Ptr<DataSet> data, Ptr<ReaderState> reader) {
+    auto setReading = [&](bool reading) {
+      std::unique_lock<std::mutex> lock(reader->mutex);
+      reader->reading = reading;
+    };
+    setReading(true);
+    auto it = data->begin();
+    setReading(false);
+    while(it != data->end()) {
+      {
+        std::unique_lock<std::mutex> lock(reader->mutex);
+        reader->condition.wait(lock, [&]() { return reader->queue.size() < reader->bound || reader->stop; });
+        if(reader->stop)
+          break;
+        reader->queue.emplace_back(*it, Clock::now());
+        reader->reading = true;
+        reader->condition.notify_all();
+      }
+      ++it; // this actually reads the next line and may block, e.g. on stdin
+      setReading(false);
+    }
+    std::unique_lock<std::mutex> lock(reader->mutex);
+    reader->done = true;
+    reader->condition.notify_all();
+  }
+
+  // Ends the reader thread, which may be waiting for space in a full reader queue if the consumer
+  // stopped early, e.g. when prepare() is called again or on destruction. If it is blocked in
+  // reading and detachIfReading is set, it is detached and ends once the read returns; otherwise
+  // it is joined. A restart must join, as the next reader uses the same data set.
+  void stopReader(bool detachIfReading) {
+    if(!readerThread_.joinable())
+      return;
+    bool reading;
+    {
+      std::unique_lock<std::mutex> lock(reader_->mutex);
+      reader_->stop = true;
+      reading = reader_->reading;
+      reader_->condition.notify_all();
+    }
+    if(reading && detachIfReading)
+      readerThread_.detach();
+    else
+      readerThread_.join();
+  }
+
+  // Fill maxiBatch with up to maxSize samples from the reader queue. Blocks until the first sample
+  // is available, then returns as soon as maxSize is reached, the data is exhausted, or the
+  // timeout has passed since the first sample arrived. Returns the number of streams.
+  template <class SampleQueue>
+  size_t fetchSamplesWithTimeout(SampleQueue& maxiBatch, size_t maxSize) {
+    size_t sets = 0;
+    auto reader = reader_;
+    std::unique_lock<std::mutex> lock(reader->mutex);
+    auto ready = [&]() { return !reader->queue.empty() || reader->done || reader->stop; };
+    reader->condition.wait(lock, ready);
+    if(reader->queue.empty())
+      return sets;
+    auto deadline = reader->queue.front().second + maxiBatchTimeout_;
+    while(maxiBatch.size() < maxSize) {
+      if(reader->queue.empty() && (reader->done || reader->stop || !reader->condition.wait_until(lock, deadline, ready)))
+        break;
+      if(reader->queue.empty()) // reader finished or was stopped while we were waiting
+        break;
+      sets = reader->queue.front().first.size();
+      maxiBatch.push(std::move(reader->queue.front().first));
+      reader->queue.pop_front();
+      reader->condition.notify_all(); // there is space for the reader again
+    }
+    return sets;
+  }
+
   // this runs on a bg thread; sequencing is handled by caller, but locking is done in here
   std::deque<BatchPtr> fetchBatches() {
     typedef typename Sample::value_type Item;
@@ -125,22 +221,33 @@ private:
 
     // consume data from corpus into maxi-batch (single sentences)
     // sorted into specified order (due to queue)
-    if(newlyPrepared_) {
-      current_ = data_->begin();
-      newlyPrepared_ = false;
-    } else {
-      if(current_ != data_->end())
-        ++current_;
-    }
     size_t sets = 0;
-    while(current_ != data_->end() && maxiBatch->size() < maxSize) { // loop over data
-      maxiBatch->push(*current_);
-      sets = current_->size();
-      // do not consume more than required for the maxi batch as this causes
-      // that line-by-line translation is delayed by one sentence
-      bool last = maxiBatch->size() == maxSize;
-      if(!last)
-        ++current_; // this actually reads the next line and pre-processes it
+    if(maxiBatchTimeout_.count() > 0) {
+      if(newlyPrepared_) {
+        stopReader(/*detachIfReading=*/false);
+        reader_ = New<ReaderState>();
+        reader_->bound = maxSize;
+        readerThread_ = std::thread(readSamples, data_, reader_);
+        newlyPrepared_ = false;
+      }
+      sets = fetchSamplesWithTimeout(*maxiBatch, maxSize);
+    } else {
+      if(newlyPrepared_) {
+        current_ = data_->begin();
+        newlyPrepared_ = false;
+      } else {
+        if(current_ != data_->end())
+          ++current_;
+      }
+      while(current_ != data_->end() && maxiBatch->size() < maxSize) { // loop over data
+        maxiBatch->push(*current_);
+        sets = current_->size();
+        // do not consume more than required for the maxi batch as this causes
+        // that line-by-line translation is delayed by one sentence
+        bool last = maxiBatch->size() == maxSize;
+        if(!last)
+          ++current_; // this actually reads the next line and pre-processes it
+      }
     }
     size_t numSentencesRead = maxiBatch->size();
 
@@ -236,6 +343,7 @@ private:
   }
 
   BatchPtr next() {
+    timer::ScopedPhase phase(timer::Phase::data);
     if(bufferedBatches_.empty()) {
       // out of data: need to get next batch from background thread
       // We only get here if the future has been scheduled to run; it must be valid.
@@ -264,11 +372,18 @@ public:
     auto shuffle = options_->get<std::string>("shuffle");
     shuffleData_ = shuffle == "data";
     shuffleBatches_ = shuffleData_ || shuffle == "batches";
+    maxiBatchTimeout_ = std::chrono::milliseconds(options_->get<size_t>("maxi-batch-timeout", 0));
   }
 
   ~BatchGenerator() {
+    if(reader_) {                       // wake up a bg thread waiting for the reader thread,
+      std::unique_lock<std::mutex> lock(reader_->mutex); // which may be blocked in reading
+      reader_->stop = true;
+      reader_->condition.notify_all();
+    }
     if (futureBufferedBatches_.valid()) // bg thread holds a reference to 'this',
       futureBufferedBatches_.get();     // so must wait for it to complete
+    stopReader(/*detachIfReading=*/true);
   }
 
   iterator begin() {
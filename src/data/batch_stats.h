@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdio>
 #include <deque>
 #include <queue>
+#include <random>
 
+#include "common/filesystem.h"
 #include "data/corpus.h"
 #include "data/vocab.h"
 
@@ -18,6 +21,7 @@ public:
 
   typedef std::map<std::vector<size_t>, size_t>::const_iterator const_iterator;
   const_iterator begin() const { return map_.begin(); }
+  const_iterator end() const { return map_.end(); }
   const_iterator lower_bound(const std::vector<size_t>& lengths) const { return map_.lower_bound(lengths); }
 
   size_t findBatchSize(const std::vector<size_t>& lengths, const_iterator& it) const {
@@ -99,6 +103,39 @@ public:
     //dump();
   }
 
+  // persist the statistics to a YAML file, together with a key that identifies
+  // everything the statistics depend on (model config, workspace, devices)
+  void save(const std::string& fileName, const std::string& key) const {
+    YAML::Node yaml;
+    yaml["key"] = key;
+    yaml["stats"] = flatten();
+
+    // write to a temporary file first and then rename, so that concurrent
+    // writers (e.g. multiple nodes on a shared file system) never leave a partial file
+    std::string tempName = fileName + ".tmp" + std::to_string(std::random_device()());
+    {
+      std::ofstream fout(tempName);
+      fout << yaml;
+      ABORT_IF(!fout, "Error writing batch statistics to '{}'", tempName);
+    }
+    ABORT_IF(std::rename(tempName.c_str(), fileName.c_str()) != 0,
+             "Error renaming '{}' to '{}'", tempName, fileName);
+  }
+
+  // load statistics saved with save(); returns nullptr if the file does not exist
+  // or was created for a different key
+  static Ptr<BatchStats> load(const std::string& fileName, const std::string& key) {
+    if(!filesystem::exists(fileName))
+      return nullptr;
+    auto yaml = YAML::LoadFile(fileName);
+    if(!yaml["key"] || yaml["key"].as<std::string>() != key)
+      return nullptr;
+    auto stats = New<BatchStats>(yaml["stats"].as<std::vector<size_t>>());
+    if(stats->map_.empty())
+      return nullptr;
+    return stats;
+  }
+
   void dump() { // (for debugging)
     for (const auto& entry : map_) {
       for (auto streamLen : entry.first)
@@ -14,6 +14,7 @@ namespace data {
 Corpus::Corpus(Ptr<Options> options, bool translate /*= false*/)
     : CorpusBase(options, translate),
         shuffleInRAM_(options_->get<bool>("shuffle-in-ram", false)),
+        numShards_(options_->get<size_t>("shuffle-shards", 0)),
         allCapsEvery_(options_->get<size_t>("all-caps-every", 0)),
         titleCaseEvery_(options_->get<size_t>("english-title-case-every", 0)) {}
 
@@ -22,6 +23,7 @@ Corpus::Corpus(std::vector<std::string> paths,
                Ptr<Options> options)
     : CorpusBase(paths, vocabs, options),
         shuffleInRAM_(options_->get<bool>("shuffle-in-ram", false)),
+        numShards_(options_->get<size_t>("shuffle-shards", 0)),
         allCapsEvery_(options_->get<size_t>("all-caps-every", 0)),
         titleCaseEvery_(options_->get<size_t>("english-title-case-every", 0)) {}
 
@@ -52,17 +54,28 @@ SentenceTuple Corpus::next() {
     // if corpus has been shuffled, ids_ contains sentence indexes
     if(pos_ < ids_.size())
       curId = ids_[pos_];
+    // if corpus has been shuffled on disk, the current shard holds the sentences and their ids
+    bool fromShard = !shardFiles_.empty();
+    if(fromShard) {
+      if(!nextShardLine())
+        return SentenceTuple(0);
+      curId = currentShard_.ids[shardPos_];
+    }
     pos_++;
 
     // fill up the sentence tuple with sentences from all input files
     SentenceTuple tup(curId);
     size_t eofsHit = 0;
-    size_t numStreams = corpusInRAM_.empty() ? files_.size() : corpusInRAM_.size();
+    size_t numStreams = fromShard ? currentShard_.lines.size()
+                                  : corpusInRAM_.empty() ? files_.size() : corpusInRAM_.size();
     for(size_t i = 0; i < numStreams; ++i) {
       std::string line;
 
-      // fetch line, from cached copy in RAM or actual file
-      if (!corpusInRAM_.empty()) {
+      // fetch line, from current shard, cached copy in RAM or actual file
+      if (fromShard) {
+        line = std::move(currentShard_.lines[i][shardPos_]);
+      }
+      else if (!corpusInRAM_.empty()) {
         if (curId < corpusInRAM_[i].size())
           line = corpusInRAM_[i][curId];
         else {
@@ -88,6 +101,9 @@ SentenceTuple Corpus::next() {
       }
     }
 
+    if (fromShard)
+      shardPos_++;
+
     if (eofsHit == numStreams)
       return SentenceTuple(0);
     ABORT_IF(eofsHit != 0, "not all input files have the same number of lines");
@@ -107,7 +123,10 @@ SentenceTuple Corpus::next() {
 // Call either reset() or shuffle().
 // @TODO: merge with reset() below to clarify mutual exclusiveness with reset()
 void Corpus::shuffle() {
-  shuffleData(paths_);
+  if(numShards_ > 0)
+    shuffleDataOnDisk(paths_);
+  else
+    shuffleData(paths_);
 }
 
 // reset to regular, non-shuffled reading
@@ -116,6 +135,7 @@ void Corpus::shuffle() {
 void Corpus::reset() {
   corpusInRAM_.clear();
   ids_.clear();
+  clearShards();
   if (pos_ == 0) // no data read yet
     return;
   pos_ = 0;
@@ -193,12 +213,13 @@ void Corpus::shuffleData(const std::vector<std::string>& paths) {
     // create temp files that contain the data in randomized order
     tempFiles_.resize(numStreams);
     for(size_t i = 0; i < numStreams; ++i) {
-      tempFiles_[i].reset(new io::TemporaryFile(options_->get<std::string>("tempdir")));
+      tempFiles_[i].reset(new io::TemporaryFile(options_->get<std::string>("tempdir"), /*earlyUnlink=*/true, /*compressed=*/true));
       io::TemporaryFile &out = *tempFiles_[i];
       const auto& corpusStream = corpus[i];
       for(auto id : ids_) {
-        out << corpusStream[id] << std::endl;
+        out << corpusStream[id] << '\n';
       }
+      out.flush();
     }
 
     // replace files_[] by the tempfiles we just created
@@ -213,6 +234,165 @@ void Corpus::shuffleData(const std::vector<std::string>& paths) {
   pos_ = 0;
 }
 
+// Bounded-memory shuffling for corpora that do not fit into RAM. In a single streaming pass,
+// each sentence tuple is assigned to a random shard and appended to that shard's temp file.
+// The shards are later read back one at a time, shuffled in RAM (see loadShard()), and
+// consumed in order. Memory use is bounded by the write buffers and two loaded shards.
+// All randomness is drawn from eng_ within this function, so that restoring eng_ via
+// restore() reproduces the same order after resuming training.
+void Corpus::shuffleDataOnDisk(const std::vector<std::string>& paths) {
+  LOG(info, "[data] Shuffling data on disk into {} shards", numShards_);
+
+  clearShards();
+  corpusInRAM_.clear();
+  ids_.clear();
+
+  size_t numStreams = paths.size();
+  files_.resize(numStreams);
+  for(size_t i = 0; i < numStreams; ++i) {
+    UPtr<io::InputFileStream> strm(new io::InputFileStream(paths[i]));
+    strm->setbufsize(10000000);  // huge read-ahead buffer to avoid network round-trips
+    files_[i] = std::move(strm);
+  }
+
+  shardFiles_.resize(numShards_);
+  for(size_t k = 0; k < numShards_; ++k)
+    shardFiles_[k].reset(new io::TemporaryFile(options_->get<std::string>("tempdir"), /*earlyUnlink=*/true, /*compressed=*/true));
+
+  // Lines are collected in per-shard buffers and flushed to disk on background threads while
+  // we keep reading. Each shard has at most one pending write, so its records stay in order.
+  const size_t bufferSize = 1 << 20; // flush a shard buffer when it exceeds 1MB
+  size_t numThreads = std::min(numShards_, (size_t)std::max(1u, std::min(8u, std::thread::hardware_concurrency())));
+  ThreadPool writers(numThreads, numThreads);
+  std::vector<std::string> buffers(numShards_);
+  std::vector<std::future<void>> pendingWrites(numShards_);
+  auto flush = [&](size_t k) {
+    if(pendingWrites[k].valid())
+      pendingWrites[k].get();
+    auto buffer = New<std::string>();
+    buffer->swap(buffers[k]);
+    io::TemporaryFile* out = shardFiles_[k].get();
+    pendingWrites[k] = writers.enqueue([out, buffer]() { out->write(buffer->data(), buffer->size()); });
+  };
+
+  // each record consists of the original sentence id followed by one line per stream
+  std::string lineBuf;
+  size_t numSentences = 0;
+  std::uniform_int_distribution<size_t> randomShard(0, numShards_ - 1);
+  for(;;) {
+    size_t k = randomShard(eng_);
+    std::string& buffer = buffers[k];
+    size_t recordStart = buffer.size();
+    buffer += std::to_string(numSentences);
+    buffer += '\n';
+    size_t eofsHit = 0;
+    for(size_t i = 0; i < numStreams; ++i) {
+      bool gotLine = io::getline(*files_[i], lineBuf).good();
+      if(gotLine) {
+        buffer += lineBuf;
+        buffer += '\n';
+      } else
+        eofsHit++;
+    }
+    if(eofsHit == numStreams) {
+      buffer.resize(recordStart); // drop the id of the non-existing record
+      break;
+    }
+    ABORT_IF(eofsHit != 0, "Not all input files have the same number of lines");
+    numSentences++;
+    if(buffer.size() > bufferSize)
+      flush(k);
+  }
+  files_.clear();
+
+  for(size_t k = 0; k < numShards_; ++k)
+    if(!buffers[k].empty())
+      flush(k);
+  for(auto& pendingWrite : pendingWrites)
+    if(pendingWrite.valid())
+      pendingWrite.get();
+  for(auto& shardFile : shardFiles_)
+    shardFile->flush();
+
+  // seeds for shuffling inside of each shard; drawn now so that the order does not depend
+  // on when shards are loaded
+  shardSeeds_.resize(numShards_);
+  for(auto& seed : shardSeeds_)
+    seed = eng_();
+
+  if(!shardLoader_)
+    shardLoader_.reset(new ThreadPool(1));
+  loadShardAsync();
+
+  LOG(info, "[data] Done partitioning {} sentences into {} shards", numSentences, numShards_);
+  pos_ = 0;
+}
+
+Corpus::Shard Corpus::loadShard(size_t shardId) const {
+  size_t numStreams = paths_.size();
+  Shard shard;
+  shard.lines.resize(numStreams);
+
+  auto in = shardFiles_[shardId]->getInputStream();
+  in->setbufsize(10000000);
+  std::vector<size_t> ids;
+  std::vector<std::vector<std::string>> lines(numStreams);
+  std::string lineBuf;
+  while(io::getline(*in, lineBuf)) {
+    ids.push_back(std::stoull(lineBuf));
+    for(size_t i = 0; i < numStreams; ++i) {
+      ABORT_IF(!io::getline(*in, lineBuf), "Truncated record in temporary shard file");
+      lines[i].push_back(std::move(lineBuf));
+    }
+  }
+
+  std::vector<size_t> order(ids.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 shardEng(shardSeeds_[shardId]);
+  std::shuffle(order.begin(), order.end(), shardEng);
+
+  shard.ids.reserve(order.size());
+  for(auto j : order)
+    shard.ids.push_back(ids[j]);
+  for(size_t i = 0; i < numStreams; ++i) {
+    shard.lines[i].reserve(order.size());
+    for(auto j : order)
+      shard.lines[i].push_back(std::move(lines[i][j]));
+  }
+  return shard;
+}
+
+// this starts loading and shuffling the next shard as a background operation
+void Corpus::loadShardAsync() {
+  if(nextShard_ >= shardFiles_.size())
+    return;
+  size_t shardId = nextShard_++;
+  futureShard_ = shardLoader_->enqueue([this, shardId]() { return loadShard(shardId); });
+}
+
+// make sure currentShard_ has a line at shardPos_; returns false when all shards are consumed
+bool Corpus::nextShardLine() {
+  while(shardPos_ >= currentShard_.ids.size()) {
+    if(!futureShard_.valid())
+      return false;
+    currentShard_ = futureShard_.get();
+    shardPos_ = 0;
+    shardFiles_[nextShard_ - 1].reset(); // consumed, remove from disk
+    loadShardAsync();
+  }
+  return true;
+}
+
+void Corpus::clearShards() {
+  if(futureShard_.valid()) // bg thread reads from shardFiles_, must complete first
+    futureShard_.get();
+  shardFiles_.clear();
+  shardSeeds_.clear();
+  nextShard_ = 0;
+  currentShard_ = Shard();
+  shardPos_ = 0;
+}
+
 CorpusBase::batch_ptr Corpus::toBatch(const std::vector<Sample>& batchVector) {
   size_t batchSize = batchVector.size();
 
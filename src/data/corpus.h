@@ -12,6 +12,7 @@
 #include "data/corpus_base.h"
 #include "data/dataset.h"
 #include "data/vocab.h"
+#include "3rd_party/threadpool.h"
 
 namespace marian {
 namespace data {
@@ -25,7 +26,27 @@ private:
   bool shuffleInRAM_{false};
   std::vector<std::vector<std::string>> corpusInRAM_; // // [stream][id] full copy of all data files
 
+  // for shuffle-on-disk: the corpus is randomly partitioned into temporary shards,
+  // each of which is read back and shuffled in RAM only when it is consumed
+  struct Shard {
+    std::vector<size_t> ids;                      // [id] original sentence ids in shuffled order
+    std::vector<std::vector<std::string>> lines;  // [stream][id] lines in shuffled order
+  };
+  size_t numShards_{0};
+  std::vector<UPtr<io::TemporaryFile>> shardFiles_;
+  std::vector<std::mt19937::result_type> shardSeeds_; // per-shard seeds, drawn from eng_ during partitioning
+  size_t nextShard_{0};   // index of the next shard to be loaded
+  Shard currentShard_;
+  size_t shardPos_{0};    // read position inside currentShard_
+  std::future<Shard> futureShard_;
+  UPtr<ThreadPool> shardLoader_; // (we only use one thread to pre-load and shuffle the next shard)
+
   void shuffleData(const std::vector<std::string>& paths);
+  void shuffleDataOnDisk(const std::vector<std::string>& paths);
+  Shard loadShard(size_t shardId) const;
+  void loadShardAsync();
+  bool nextShardLine();
+  void clearShards();
 
   // for pre-processing
   size_t allCapsEvery_{0};   // if set, convert every N-th input sentence (after randomization) to all-caps (source and target)
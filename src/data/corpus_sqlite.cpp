@@ -1,19 +1,22 @@
+#include <algorithm>
+#include <numeric>
 #include <random>
 
+#include "3rd_party/threadpool.h"
 #include "data/corpus_sqlite.h"
 
 namespace marian {
 namespace data {
 
 CorpusSQLite::CorpusSQLite(Ptr<Options> options, bool translate /*= false*/)
-    : CorpusBase(options, translate), seed_(Config::seed) {
+    : CorpusBase(options, translate) {
   fillSQLite();
 }
 
 CorpusSQLite::CorpusSQLite(const std::vector<std::string>& paths,
                            const std::vector<Ptr<Vocab>>& vocabs,
                            Ptr<Options> options)
-    : CorpusBase(paths, vocabs, options), seed_(Config::seed) {
+    : CorpusBase(paths, vocabs, options) {
   fillSQLite();
 }
 
@@ -53,66 +56,175 @@ void CorpusSQLite::fillSQLite() {
     }
   }
 
+  // write-ahead logging lets readers proceed during large transactions, and since a failed
+  // import is simply repeated, we do not need to sync every commit to disk
+  db_->exec("PRAGMA journal_mode = WAL;");
+  db_->exec("PRAGMA synchronous = OFF;");
+  db_->exec("PRAGMA cache_size = -262144;"); // 256MB page cache
+
   // populate tables with lines from text files
-  if(fill) {
-    std::string createStr = "create table lines (_id integer";
-    std::string insertStr = "insert into lines values (?";
-    for(size_t i = 0; i < files_.size(); ++i) {
-      createStr += ", line" + std::to_string(i) + " text";
-      insertStr += ", ?";
-    }
-    createStr += ");";
-    insertStr += ");";
+  if(fill)
+    insertLines();
+
+  // prepare statement for reading pages of rows by id in shuffled order
+  std::string selectStr = "select * from lines where _id in (?";
+  for(size_t i = 1; i < pageSize_; ++i)
+    selectStr += ", ?";
+  selectStr += ");";
+  selectPage_.reset(new SQLite::Statement(*db_, selectStr));
+}
 
-    db_->exec(createStr);
+// Import lines from files_ into the database. Reading (and decompressing) the input
+// files happens on a background thread in chunks, while this thread inserts the previous
+// chunk with multi-row prepared statements inside large transactions. '_id' is the
+// primary key (an alias for the SQLite rowid), so no separate index needs to be built.
+void CorpusSQLite::insertLines() {
+  size_t numStreams = files_.size();
+  std::string createStr = "create table lines (_id integer primary key";
+  for(size_t i = 0; i < numStreams; ++i)
+    createStr += ", line" + std::to_string(i) + " text";
+  createStr += ");";
+  db_->exec(createStr);
 
-    SQLite::Statement ps(*db_, insertStr);
+  // SQLite limits the number of variables per statement to 999 by default
+  size_t numColumns = numStreams + 1;
+  size_t rowsPerInsert = std::max((size_t)1, std::min((size_t)64, 999 / numColumns));
+  auto makeInsert = [&](size_t rows) {
+    std::string row = "(?";
+    for(size_t i = 0; i < numStreams; ++i)
+      row += ", ?";
+    row += ")";
+    std::string insertStr = "insert into lines values " + row;
+    for(size_t r = 1; r < rows; ++r)
+      insertStr += ", " + row;
+    insertStr += ";";
+    return New<SQLite::Statement>(*db_, insertStr);
+  };
+  auto insertMany = makeInsert(rowsPerInsert);
+  auto insertOne = makeInsert(1);
 
-    int lines = 0;
-    int report = 1000000;
-    bool cont = true;
+  typedef std::vector<std::vector<std::string>> Chunk; // [row][stream]
+  const size_t chunkSize = 100000;
+  auto readChunk = [this, numStreams, chunkSize]() {
+    Chunk chunk;
+    chunk.reserve(chunkSize);
+    std::vector<std::string> row(numStreams);
+    while(chunk.size() < chunkSize) {
+      size_t eofsHit = 0;
+      for(size_t i = 0; i < numStreams; ++i)
+        if(!io::getline(*files_[i], row[i]))
+          eofsHit++;
+      if(eofsHit == numStreams)
+        break;
+      ABORT_IF(eofsHit != 0, "Not all input files have the same number of lines");
+      chunk.push_back(row);
+    }
+    return chunk;
+  };
 
-    db_->exec("begin;");
-    while(cont) {
-      ps.bind(1, (int)lines);
+  ThreadPool reader(1);
+  auto futureChunk = reader.enqueue(readChunk);
 
-      std::string line;
-      for(size_t i = 0; i < files_.size(); ++i) {
-        cont = cont && io::getline(*files_[i], line);
-        if(cont)
-          ps.bind((int)(i + 2), line);
-      }
+  const size_t commitEvery = 1000000;
+  size_t lines = 0;
+  size_t report = 1000000;
+  db_->exec("begin;");
+  for(;;) {
+    Chunk chunk = futureChunk.get();
+    if(chunk.empty())
+      break;
+    futureChunk = reader.enqueue(readChunk); // read the next chunk while inserting this one
 
-      if(cont) {
-        ps.exec();
-        ps.reset();
+    size_t r = 0;
+    while(r < chunk.size()) {
+      size_t rows = chunk.size() - r >= rowsPerInsert ? rowsPerInsert : 1;
+      auto& ps = rows > 1 ? *insertMany : *insertOne;
+      int col = 1;
+      for(size_t k = 0; k < rows; ++k, ++r) {
+        ps.bind(col++, (long long)(lines + k));
+        for(size_t i = 0; i < numStreams; ++i)
+          ps.bindNoCopy(col++, chunk[r][i]);
       }
-      lines++;
+      ps.exec();
+      ps.reset();
 
-      if(lines % report == 0) {
-        LOG(info, "[sqlite] Inserted {} lines", lines);
+      size_t prevLines = lines;
+      lines += rows;
+      if(lines / commitEvery != prevLines / commitEvery) {
         db_->exec("commit;");
         db_->exec("begin;");
+      }
+      if(lines >= report) {
+        LOG(info, "[sqlite] Inserted {} lines", lines);
         report *= 2;
       }
     }
-    db_->exec("commit;");
-    LOG(info, "[sqlite] Inserted {} lines", lines - 1);
-    LOG(info, "[sqlite] Creating primary index");
-    db_->exec("create unique index idx_line on lines (_id);");
   }
+  db_->exec("commit;");
+  LOG(info, "[sqlite] Inserted {} lines", lines);
+}
+
+// read the next page of rows in the order given by ids_
+bool CorpusSQLite::fetchPage() {
+  size_t begin = pos_;
+  if(begin >= ids_.size())
+    return false;
+  size_t end = std::min(begin + pageSize_, ids_.size());
+  pos_ = end;
+
+  pageIds_.assign(ids_.begin() + begin, ids_.begin() + end);
+  pageRows_.assign(pageIds_.size(), std::vector<std::string>());
+
+  // rows are returned in the order of the index, so we remember where each id goes
+  std::vector<std::pair<size_t, size_t>> positions; // (id, position in page)
+  for(size_t k = 0; k < pageIds_.size(); ++k)
+    positions.emplace_back(pageIds_[k], k);
+  std::sort(positions.begin(), positions.end());
+
+  for(size_t k = 0; k < pageSize_; ++k) // unused slots match no row
+    selectPage_->bind((int)(k + 1), k < pageIds_.size() ? (long long)pageIds_[k] : (long long)-1);
 
-  createRandomFunction();
+  size_t numStreams = files_.size();
+  while(selectPage_->executeStep()) {
+    size_t id = (size_t)selectPage_->getColumn(0).getInt64();
+    auto it = std::lower_bound(positions.begin(), positions.end(), std::make_pair(id, (size_t)0));
+    ABORT_IF(it == positions.end() || it->first != id, "Unexpected row id {} in sqlite page", id);
+    auto& row = pageRows_[it->second];
+    row.resize(numStreams);
+    for(size_t i = 0; i < numStreams; ++i)
+      row[i] = selectPage_->getColumn((int)(i + 1)).getText();
+  }
+  selectPage_->reset();
+  pagePos_ = 0;
+  return true;
 }
 
 SentenceTuple CorpusSQLite::next() {
-  while(select_->executeStep()) {
+  std::vector<std::string> lines(files_.size());
+  for(;;) {
+    // fetch the next row, either from the current page in shuffled order or from select_
+    size_t curId;
+    if(!ids_.empty()) {
+      if(pagePos_ >= pageIds_.size() && !fetchPage())
+        return SentenceTuple(0);
+      curId = pageIds_[pagePos_];
+      lines.swap(pageRows_[pagePos_]);
+      pagePos_++;
+      if(lines.size() != files_.size()) // id not found in the database
+        continue;
+    } else {
+      if(!select_->executeStep())
+        return SentenceTuple(0);
+      curId = select_->getColumn(0).getInt();
+      for(size_t i = 0; i < files_.size(); ++i)
+        lines[i] = select_->getColumn((int)(i + 1)).getText();
+    }
+
     // fill up the sentence tuple with sentences from all input files
-    size_t curId = select_->getColumn(0).getInt();
     SentenceTuple tup(curId);
 
     for(size_t i = 0; i < files_.size(); ++i) {
-      auto line = select_->getColumn((int)(i + 1));
+      const auto& line = lines[i];
 
       if(i > 0 && i == alignFileIdx_) {
         addAlignmentToSentenceTuple(line, tup);
@@ -128,27 +240,34 @@ SentenceTuple CorpusSQLite::next() {
        }))
       return tup;
   }
-  return SentenceTuple(0);
 }
 
+// Shuffling draws a random permutation of all row ids from eng_, so that each epoch
+// has a different order which can be restored with restore(). Rows are then read in
+// pages by primary key instead of sorting the full table by a random function.
 void CorpusSQLite::shuffle() {
   LOG(info, "[sqlite] Selecting shuffled data");
-  select_.reset(new SQLite::Statement(
-      *db_, "select * from lines order by random_seed(" + std::to_string(seed_) + ");"));
+  size_t numLines = (size_t)db_->execAndGet("select count(*) from lines;").getInt64();
+  ids_.resize(numLines);
+  std::iota(ids_.begin(), ids_.end(), 0);
+  std::shuffle(ids_.begin(), ids_.end(), eng_);
+  pos_ = 0;
+  pageIds_.clear();
+  pageRows_.clear();
+  pagePos_ = 0;
 }
 
 void CorpusSQLite::reset() {
+  ids_.clear();
+  pageIds_.clear();
+  pageRows_.clear();
+  pagePos_ = 0;
   select_.reset(
       new SQLite::Statement(*db_, "select * from lines order by _id;"));
 }
 
 void CorpusSQLite::restore(Ptr<TrainingState> ts) {
-  for(size_t i = 0; i < ts->epochs - 1; ++i) {
-    select_.reset(new SQLite::Statement(
-        *db_, "select _id from lines order by random_seed(" + std::to_string(seed_) + ");"));
-    select_->executeStep();
-    reset();
-  }
+  setRNGState(ts->seedCorpus);
 }
 }  // namespace data
 }  // namespace marian
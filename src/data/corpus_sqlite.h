@@ -14,21 +14,6 @@
 #include "data/vocab.h"
 
 #include <SQLiteCpp/SQLiteCpp.h>
-#include <SQLiteCpp/sqlite3/sqlite3.h>
-
-static void SQLiteRandomSeed(sqlite3_context* context,
-                             int argc,
-                             sqlite3_value** argv) {
-  if(argc == 1 && sqlite3_value_type(argv[0]) == SQLITE_INTEGER) {
-    const int seed = sqlite3_value_int(argv[0]);
-    static std::default_random_engine eng(seed);
-    std::uniform_int_distribution<> unif;
-    const int result = unif(eng);
-    sqlite3_result_int(context, result);
-  } else {
-    sqlite3_result_error(context, "Invalid", 0);
-  }
-}
 
 namespace marian {
 namespace data {
@@ -38,9 +23,18 @@ private:
   UPtr<SQLite::Database> db_;
   UPtr<SQLite::Statement> select_;
 
-  void fillSQLite();
+  // for shuffled reading: a random permutation of row ids drawn from eng_ per epoch,
+  // rows are looked up by id in pages of pageSize_ rows
+  static const size_t pageSize_ = 256;
+  std::vector<size_t> ids_;
+  UPtr<SQLite::Statement> selectPage_;
+  std::vector<size_t> pageIds_;                    // [row] ids of the current page in shuffled order
+  std::vector<std::vector<std::string>> pageRows_; // [row][stream]
+  size_t pagePos_{0};
 
-  size_t seed_;
+  void fillSQLite();
+  void insertLines();
+  bool fetchPage();
 
 public:
   // @TODO: check if translate can be replaced by an option in options
@@ -109,18 +103,6 @@ public:
 
     return batch;
   }
-
-private:
-  void createRandomFunction() {
-    sqlite3_create_function(db_->getHandle(),
-                            "random_seed",
-                            1,
-                            SQLITE_UTF8,
-                            NULL,
-                            &SQLiteRandomSeed,
-                            NULL,
-                            NULL);
-  }
 };
 }  // namespace data
 }  // namespace marian
@@ -447,6 +447,20 @@ bool FactoredVocab::tryGetFactor(const std::string& factorName, size_t& groupInd
 }
 
 // extract the factor index of a given factor type from the 'Word' representation
+// return a vector of 1 or 0 indicating for each lemma whether it has a specific factor
+// If 'indices' is given, then return the masks for the indices (a shortlist); otherwise for all lemmas
+std::vector<float> FactoredVocab::getFactorMasks(size_t factorGroup, const std::vector<WordIndex>& indices) const {
+  auto lemmaBegin = groupRanges_[0].first;
+  size_t n = indices.empty() ? (groupRanges_[0].second - lemmaBegin) : indices.size();
+  std::vector<float> res;
+  res.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    auto lemma = indices.empty() ? i : (indices[i] - lemmaBegin);
+    res.push_back((float)lemmaHasFactorGroup(lemma, factorGroup));
+  }
+  return res;
+}
+
 size_t FactoredVocab::getFactor(Word word, size_t groupIndex) const {
   size_t index = word.toWordIndex();
   size_t factor0Index = index / factorStrides_[0];
@@ -9,6 +9,7 @@
 #include "common/options.h"
 #include "common/logging.h"
 #include "common/filesystem.h"
+#include "common/lru_cache.h"
 #include "common/regex.h"
 
 #include <sstream>
@@ -39,6 +40,58 @@ private:
   // Keeps sentences segmented into subword units
   bool keepEncoded_{false};
 
+  // Optional cache for deterministic encoding, from whitespace-delimited words or,
+  // if cacheLines_ is set, from full lines to SentencePiece ids
+  UPtr<LRUCache<std::string, std::vector<int>>> cache_;
+  bool cacheLines_{false};
+
+  // Encode without sampling, through the cache if enabled. Encoding word by word gives
+  // the same result as encoding the full line only for some models, see encodesWordByWord().
+  void encodeCached(const std::string& line, std::vector<int>& spmIds) const {
+    if(!cache_) {
+      spm_->Encode(line, &spmIds);
+    } else if(cacheLines_) {
+      if(!cache_->get(line, spmIds)) {
+        spm_->Encode(line, &spmIds);
+        cache_->put(line, spmIds);
+      }
+    } else {
+      std::vector<int> wordIds;
+      for(const auto& word : utils::split(line, " ")) {
+        if(!cache_->get(word, wordIds)) {
+          spm_->Encode(word, &wordIds);
+          cache_->put(word, wordIds);
+        }
+        spmIds.insert(spmIds.end(), wordIds.begin(), wordIds.end());
+      }
+    }
+  }
+
+  // Whether the model encodes a line as the concatenation of its space-delimited words. This holds
+  // for SentencePiece's defaults: pieces do not cross whitespace (--split_by_whitespace) and start
+  // with it (no --treat_whitespace_as_suffix), and the normalizer adds the whitespace in front of
+  // the first word (--add_dummy_prefix) and collapses repeated whitespace (--remove_extra_whitespaces).
+  // The training and normalizer specs are not part of SentencePiece's public interface, so the
+  // vocabulary and the encoding of a few lines are checked instead.
+  bool encodesWordByWord() const {
+    const std::string whitespace = "\xe2\x96\x81"; // U+2581, SentencePiece's whitespace symbol
+    for(int id = 0; id < spm_->GetPieceSize(); ++id)
+      if(spm_->IdToPiece(id).find(whitespace, 1) != std::string::npos)
+        return false;
+
+    for(const std::string line : {"a b", "a  b", " a b ", "a\tb"}) {
+      std::vector<int> lineIds, wordsIds, wordIds;
+      spm_->Encode(line, &lineIds);
+      for(const auto& word : utils::split(line, " ")) {
+        spm_->Encode(word, &wordIds);
+        wordsIds.insert(wordsIds.end(), wordIds.begin(), wordIds.end());
+      }
+      if(lineIds != wordsIds)
+        return false;
+    }
+    return true;
+  }
+
   // Sample from one file, based on first algorithm from:
   // https://en.wikipedia.org/wiki/Reservoir_sampling
   void reservoirSampling(std::vector<std::string>& sample, size_t& seenLines,
@@ -127,6 +180,22 @@ public:
             alpha_,
             batchIndex_);
     }
+
+    size_t cacheSize = options_->get<size_t>("sentencepiece-cache-size", 0);
+    if(cacheSize > 0) {
+      cacheLines_ = options_->get<std::string>("sentencepiece-cache-mode", "words") == "lines";
+      cache_.reset(new LRUCache<std::string, std::vector<int>>(cacheSize));
+    }
+  }
+
+  ~SentencePieceVocab() {
+    if(cache_ && cache_->hits() + cache_->misses() > 0)
+      LOG(info,
+          "[SentencePiece] Encoding cache for input {}: {} hits, {} misses, hit rate {:.2f}%",
+          batchIndex_,
+          cache_->hits(),
+          cache_->misses(),
+          100. * cache_->hitRate());
   }
 
   virtual const std::string& canonicalExtension() const override { return suffixes_[0]; }
@@ -209,7 +278,7 @@ public:
   Words encode(const std::string& line, bool addEOS, bool inference) const override {
     std::vector<int> spmIds;
     if(inference || alpha_ == 0)
-      spm_->Encode(line, &spmIds);
+      encodeCached(line, spmIds);
     else
       spm_->SampleEncode(line, -1, alpha_, &spmIds);
 
@@ -262,6 +331,13 @@ public:
              "SentencePiece vocabulary error: {}",
              status.ToString());
 
+    if(cache_ && !cacheLines_ && !encodesWordByWord()) {
+      LOG(warn,
+          "[SentencePiece] Vocabulary {} does not encode lines word by word, caching encodings per line",
+          vocabPath);
+      cacheLines_ = true;
+    }
+
     return spm_->GetPieceSize();
   }
 
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "functional/defs.h"
+#include "functional/operators.h"
+
+#include <cstdint>
+#include <string>
+
+namespace marian {
+namespace functional {
+
+// Operations of an element-wise program, one per element-wise graph node type. The scalar of a
+// ProgramStep is used by the operations that take a constant.
+enum class ProgramOp : uint8_t {
+  add, sub, mul, div, max, min, logaddexp,                                     // binary
+  neg, addScalar, mulScalar, clip, sigmoid, tanh, relu, swish, exp, log, sqrt, square // unary
+};
+
+struct ProgramStep {
+  ProgramOp op{ProgramOp::add};
+  uint8_t a{0}, b{0}; // operand registers
+  float scalar{0};
+};
+
+// A straight-line program evaluated per element, so that a chain of element-wise graph nodes can be
+// computed by a single Element() call without compiling a functor for each possible chain.
+// Registers 0 to MAX_INPUTS-1 hold the input tensors, step i writes register MAX_INPUTS+i and the
+// result of the program is the register of the last step. Called like the functor `_1 = f(_2, ...)`,
+// with the output element first.
+struct Program {
+  static const int MAX_INPUTS = 4;
+  static const int MAX_STEPS = 12;
+
+  int numSteps{0};
+  ProgramStep steps[MAX_STEPS];
+
+  template <typename T, typename... Args>
+  HOST_DEVICE_INLINE T operator()(const T& /*out*/, const Args&... args) const {
+    const T inputs[] = {args...};
+    T regs[MAX_INPUTS + MAX_STEPS];
+    for(int i = 0; i < (int)sizeof...(args); ++i)
+      regs[i] = inputs[i];
+    for(int i = 0; i < numSteps; ++i)
+      regs[MAX_INPUTS + i] = apply(steps[i], regs[steps[i].a], regs[steps[i].b]);
+    return regs[MAX_INPUTS + numSteps - 1];
+  }
+
+  template <typename T>
+  HOST_DEVICE_INLINE static T apply(const ProgramStep& step, const T& x, const T& y) {
+    typedef Ops<T> O;
+    switch(step.op) {
+      case ProgramOp::add:       return O::add(x, y);
+      case ProgramOp::sub:       return O::sub(x, y);
+      case ProgramOp::mul:       return O::mul(x, y);
+      case ProgramOp::div:       return O::div(x, y);
+      case ProgramOp::max:       return O::max(x, y);
+      case ProgramOp::min:       return O::min(x, y);
+      case ProgramOp::logaddexp: return O::logaddexp(x, y);
+      case ProgramOp::neg:       return O::neg(x);
+      case ProgramOp::addScalar: return O::add(x, T(step.scalar));
+      case ProgramOp::mulScalar: return O::mul(T(step.scalar), x);
+      case ProgramOp::clip:      return O::clip(x, T(step.scalar));
+      case ProgramOp::sigmoid:   return O::sigmoid(x);
+      case ProgramOp::tanh:      return O::tanh(x);
+      case ProgramOp::relu:      return O::relu(x);
+      case ProgramOp::swish:     return O::mul(x, O::sigmoid(O::mul(T(step.scalar), x)));
+      case ProgramOp::exp:       return O::exp(x);
+      case ProgramOp::log:       return O::log(x);
+      case ProgramOp::sqrt:      return O::sqrt(O::add(x, T(step.scalar)));
+      case ProgramOp::square:    return O::mul(x, x);
+      default:                   return x;
+    }
+  }
+
+  std::string to_string() const { return "program"; }
+};
+
+}  // namespace functional
+}  // namespace marian
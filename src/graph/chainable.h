@@ -13,6 +13,11 @@ typedef std::vector<std::function<void()>> NodeOps;
 
 class AutoTunerRecorder;
 
+namespace functional {
+struct ProgramStep;
+struct Program;
+}
+
 template <class DataType>
 class Chainable;
 /**
@@ -112,5 +117,9 @@ public:
   virtual bool isCheckpoint() const = 0;
   virtual void setSubtape(Ptr<std::list<Expr>>) = 0;
   virtual Ptr<std::list<Expr>> getSubtape() = 0;
+
+  // element-wise operator fusion, see ExpressionGraph::fuseElementwise()
+  virtual bool elementStep(functional::ProgramStep&) = 0;
+  virtual void fuse(const std::vector<Expr>&, const functional::Program&) = 0;
 };
 }  // namespace marian
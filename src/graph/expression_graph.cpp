@@ -1,6 +1,12 @@
 #include "graph/expression_graph.h"
 #include "tensors/tensor_operators.h"
+#include "common/phase_timer.h"
+#include "graph/op_profiler.h"
 
+#include <atomic>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
 #include <sstream>
 
 namespace marian {
@@ -20,6 +26,14 @@ void ExpressionGraph::setDevice(DeviceId deviceId, Ptr<Device> device) {
       tensors_ = New<Tensors>(backend_, device);
     else
       tensors_ = New<Tensors>(backend_);
+
+    // for benchmarks of the allocator, e.g. test_allocator, with the allocations of a real model
+    if(const char* trace = getenv("MARIAN_ALLOCATOR_TRACE")) {
+      static std::atomic<size_t> graphs{0};
+      std::string fileName = std::string(trace) + "." + std::to_string(graphs++);
+      LOG(info, "[memory] Recording the allocations of the graph on device {} to {}", deviceId, fileName);
+      tensors_->recordTrace(fileName);
+    }
   }
 }
 
@@ -70,11 +84,219 @@ void createSubtape(Expr node) {
   node->setSubtape(subtape);
 }
 
+// Rough number of operations for computing a node, used to compare recomputation costs.
+static double forwardCost(Expr node) {
+  const auto& type = node->type();
+  if(type == "dot" || type == "bdot" || type == "affine") // 2 * m * k * n
+    return 2. * node->child(0)->shape().elements() * node->shape()[-1];
+  return (double)node->shape().elements() * std::max((size_t)1, node->children().size());
+}
+
+// Chooses checkpoints greedily along the forward tape (Chen et al. 2016, "Training deep nets with
+// sublinear memory cost"): a segment of nodes that are freed after the forward pass and recomputed
+// in the backward pass ends with a new checkpoint once its size would exceed a segment limit.
+// The peak is estimated as the kept activations plus the largest recomputed segment. All segment
+// limits between the smallest node and the total size are evaluated and the one with the least
+// recomputation whose peak fits into the budget is applied. If none fits, the one with the
+// smallest peak is used.
+void ExpressionGraph::planCheckpoints() {
+  struct Candidate { Expr node; size_t bytes; double cost; bool fixed; };
+  std::vector<Candidate> candidates;
+  size_t totalBytes = 0, minBytes = std::numeric_limits<size_t>::max();
+  double totalCost = 0;
+  for(auto v : nodesForward_) {
+    if(v->type() == "param") // stored with the parameters
+      continue;
+    size_t bytes = v->shape().elements() * sizeOf(v->value_type());
+    candidates.push_back({v, bytes, forwardCost(v), v->isCheckpoint() || topNodes_.count(v) > 0});
+    totalBytes += bytes;
+    minBytes = std::min(minBytes, std::max(bytes, (size_t)1));
+    totalCost += candidates.back().cost;
+  }
+  if(candidates.empty())
+    return;
+
+  struct Plan { size_t limit, keptBytes, peakBytes, kept; double recomputeCost; };
+  auto simulate = [&](size_t limit, bool mark) {
+    Plan plan{limit, 0, 0, 0, 0.};
+    size_t segment = 0, maxSegment = 0;
+    for(auto& c : candidates) {
+      if(c.fixed || segment + c.bytes > limit) {
+        if(mark && !c.fixed)
+          c.node->markCheckpoint();
+        plan.keptBytes += c.bytes;
+        plan.kept++;
+        segment = 0;
+      } else {
+        segment += c.bytes;
+        maxSegment = std::max(maxSegment, segment);
+        plan.recomputeCost += c.cost;
+      }
+    }
+    plan.peakBytes = plan.keptBytes + maxSegment;
+    return plan;
+  };
+
+  Plan best = simulate(totalBytes, /*mark=*/false);
+  bool fits = best.peakBytes <= checkpointingBudget_;
+  for(size_t limit = totalBytes / 2; limit >= minBytes && limit > 0; limit = limit * 3 / 4) {
+    Plan plan = simulate(limit, /*mark=*/false);
+    bool planFits = plan.peakBytes <= checkpointingBudget_;
+    if(planFits ? (!fits || plan.recomputeCost < best.recomputeCost)
+                : (!fits && plan.peakBytes < best.peakBytes)) {
+      best = plan;
+      fits = planFits;
+    }
+  }
+  simulate(best.limit, /*mark=*/true);
+
+  if(!checkpointPlanLogged_) {
+    LOG(info,
+        "[memory] Checkpointing keeps {} of {} activations ({:.1f} of {:.1f} MB), estimated peak {:.1f} MB "
+        "for a budget of {:.1f} MB{}, recomputing {:.1f}% of the forward pass",
+        best.kept, candidates.size(),
+        best.keptBytes / 1048576., totalBytes / 1048576.,
+        best.peakBytes / 1048576., checkpointingBudget_ / 1048576., fits ? "" : " (exceeded)",
+        totalCost > 0 ? 100. * best.recomputeCost / totalCost : 0.);
+    checkpointPlanLogged_ = true;
+  }
+}
+
+// Absorbs element-wise nodes into their consumer if the consumer is element-wise as well, has the
+// same shape and is the only node referring to them, so that each chain of element-wise nodes is
+// computed by one kernel from the inputs of the chain (see functional::Program) and the values in
+// between are neither written nor allocated. Nodes that are memoized, computed already or referred
+// to from outside of the tape, e.g. states kept for the next decoding step, are not absorbed.
+void ExpressionGraph::fuseElementwise() {
+  using functional::Program;
+  using functional::ProgramStep;
+  typedef Chainable<Tensor>* NodePtr;
+
+  // a program computing one node from its inputs, registers as in functional::Program
+  struct Fragment {
+    std::vector<NodePtr> inputs;
+    std::vector<ProgramStep> steps;
+  };
+
+  // register of the input in f, -1 if there are too many inputs
+  auto inputRegister = [](Fragment& f, NodePtr input) {
+    for(size_t i = 0; i < f.inputs.size(); ++i)
+      if(f.inputs[i] == input)
+        return (int)i;
+    if(f.inputs.size() == Program::MAX_INPUTS)
+      return -1;
+    f.inputs.push_back(input);
+    return (int)f.inputs.size() - 1;
+  };
+
+  // appends the steps of g to f and returns the register of the result of g, -1 if f would exceed
+  // the limits of a program; one step is left for the consumer
+  auto append = [&](Fragment& f, const Fragment& g) {
+    Fragment merged = f;
+    int inputMap[Program::MAX_INPUTS];
+    for(size_t i = 0; i < g.inputs.size(); ++i)
+      if((inputMap[i] = inputRegister(merged, g.inputs[i])) < 0)
+        return -1;
+    if(merged.steps.size() + g.steps.size() >= Program::MAX_STEPS)
+      return -1;
+    int offset = (int)merged.steps.size();
+    auto map = [&](uint8_t r) { return (uint8_t)(r < Program::MAX_INPUTS ? inputMap[r] : r + offset); };
+    for(auto step : g.steps) {
+      step.a = map(step.a);
+      step.b = map(step.b);
+      merged.steps.push_back(step);
+    }
+    f = merged;
+    return Program::MAX_INPUTS + (int)f.steps.size() - 1;
+  };
+
+  numFused_ = 0;
+  std::unordered_map<NodePtr, size_t> consumers;
+  for(auto& v : nodesForward_)
+    for(auto& child : v->children())
+      consumers[child.get()]++;
+
+  std::unordered_map<NodePtr, Fragment> fragments; // element-wise nodes on the tape
+  std::unordered_set<NodePtr> absorbed;
+  for(auto& v : nodesForward_) {
+    auto& children = v->children();
+    ProgramStep step;
+    if(v->val() || v->memoize() || v->marked_for_debug() || v->value_type() != Type::float32
+       || children.empty() || children.size() > 2 || !v->elementStep(step))
+      continue;
+
+    Fragment f;
+    std::vector<NodePtr> merged;
+    int operands[2] = {-1, -1};
+    for(size_t i = 0; i < children.size(); ++i) {
+      auto& child = children[i];
+      auto it = fragments.find(child.get());
+      if(it != fragments.end() && consumers[child.get()] == 1 && child->shape() == v->shape()
+         && child.useCount() == 2) { // referred to by the tape and v only
+        operands[i] = append(f, it->second);
+        if(operands[i] >= 0)
+          merged.push_back(child.get());
+      }
+      if(operands[i] < 0)
+        operands[i] = inputRegister(f, child.get());
+    }
+    if(operands[0] < 0 || (children.size() > 1 && operands[1] < 0)) { // out of inputs, do not fuse
+      f = Fragment();
+      merged.clear();
+      for(size_t i = 0; i < children.size(); ++i)
+        operands[i] = inputRegister(f, children[i].get());
+    }
+
+    step.a = (uint8_t)operands[0];
+    step.b = (uint8_t)operands[children.size() > 1 ? 1 : 0];
+    f.steps.push_back(step);
+    absorbed.insert(merged.begin(), merged.end());
+    fragments[v.get()] = f;
+  }
+
+  numFused_ = absorbed.size();
+  if(absorbed.empty())
+    return;
+
+  size_t tapeSize = nodesForward_.size(), numFused = 0;
+  for(auto it = nodesForward_.begin(); it != nodesForward_.end();) {
+    NodePtr v = it->get();
+    if(absorbed.count(v)) {
+      it = nodesForward_.erase(it);
+      continue;
+    }
+    auto found = fragments.find(v);
+    if(found != fragments.end() && found->second.steps.size() > 1) {
+      const auto& f = found->second;
+      Program program;
+      program.numSteps = (int)f.steps.size();
+      std::copy(f.steps.begin(), f.steps.end(), program.steps);
+      v->fuse(std::vector<Expr>(f.inputs.begin(), f.inputs.end()), program);
+      numFused++;
+    }
+    ++it;
+  }
+
+  if(!fusionLogged_) {
+    LOG(info, "[graph] Fused {} element-wise nodes into {} nodes in a forward pass of {} nodes",
+        absorbed.size() + numFused, numFused, tapeSize);
+    fusionLogged_ = true;
+  } else {
+    LOG(debug, "[graph] Fused {} element-wise nodes into {} nodes in a forward pass of {} nodes",
+        absorbed.size() + numFused, numFused, tapeSize);
+  }
+}
+
 void ExpressionGraph::forwardNext() {
+  timer::ScopedPhase phase(timer::Phase::forward);
+
   // @TODO: check if allocation works properly
   tensors_->clearShorttermMemory();
 
   if(checkpointing_) {
+    if(checkpointingBudget_ > 0)
+      planCheckpoints();
+
     for(auto top : topNodes_)
       top->markCheckpoint();
 
@@ -98,7 +320,12 @@ void ExpressionGraph::forwardNext() {
     }
   }
 
+  if(fusion_ && inferenceOnly_ && !checkpointing_)
+    fuseElementwise();
+
+  tensors_->beginForward(nodesForward_);
   forward(nodesForward_, /*finalPass=*/!checkpointing_); // if checkPointing, this is not final
+  tensors_->endForward();
 }
 
 void ExpressionGraph::forward(std::list<Expr>& forwardTape, bool finalPass) {
@@ -111,7 +338,10 @@ void ExpressionGraph::forward(std::list<Expr>& forwardTape, bool finalPass) {
     for(auto& child : v->children())
       ABORT_IF(!child->val(), "De-allocated child {} {} of {} {}", child->getId(), child->type(), v->getId(), v->type());
 
-    v->forward();
+    {
+      ScopedOp op(v.get(), /*backward=*/false);
+      v->forward();
+    }
 
     if(v->trainable() && throwNaN_) {
       bool isNaN = false, isInf = false;
@@ -157,6 +387,8 @@ void ExpressionGraph::forward(std::list<Expr>& forwardTape, bool finalPass) {
 }
 
 void ExpressionGraph::backward(bool reset, float clipValue) {
+  timer::ScopedPhase phase(timer::Phase::backward);
+
   if(topNodes_.size() > 1) {
     LOG(critical, "There are more ({}) than one top most nodes for backward pass:", topNodes_.size());
     for(auto node : topNodes_) {
@@ -207,8 +439,13 @@ void ExpressionGraph::backward(bool reset, float clipValue) {
       Element(_1 = clip(_1, clipValue), v->grad());
     }
 
-    if(v->trainable())
+    if(v->trainable()) {
+      ScopedOp op(v.get(), /*backward=*/true);
       v->backward();
+    }
+
+    if(paramGradientCallback_ && v->type() == "param")
+      paramGradientCallback_(v);
 
     if(throwNaN_ && firstNaN) {
       for(auto&& child : v->children()) {
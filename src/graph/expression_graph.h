@@ -10,6 +10,7 @@
 #include "graph/node_initializers.h"
 #include "graph/node_operators.h"
 #include "graph/parameters.h"
+#include "graph/memory_planner.h"
 
 #include <map>
 #include <unordered_set>
@@ -30,6 +31,8 @@ private:
   Ptr<WeakMemory> shortterm_;
   Ptr<Memory> longterm_;
 
+  UPtr<MemoryPlanner> planner_; // null unless memory planning is enabled
+
 public:
   Tensors(Ptr<Backend> backend)
       : tensors_(New<TensorAllocator>(backend)),
@@ -49,10 +52,28 @@ public:
     tensors_->throwAtReallocation(throwAtRealloc);
   }
 
+  void recordTrace(const std::string& fileName) { tensors_->recordTrace(fileName); }
+
+  void setMemoryPlanning(bool planning) {
+    planner_.reset(planning ? new MemoryPlanner(tensors_) : nullptr);
+  }
+
+  void beginForward(const std::list<Expr>& tape) {
+    if(planner_)
+      planner_->begin(tape);
+  }
+
+  void endForward() {
+    if(planner_)
+      planner_->end();
+  }
+
   void allocateForward(Expr node) {
     if(!node->val()) {
       if(node->memoize())
         cache_->allocate(node->val(), node->shape(), node->value_type());
+      else if(planner_)
+        planner_->allocate(node);
       else
         tensors_->allocate(node->val(), node->shape(), node->value_type());
     }
@@ -63,7 +84,10 @@ public:
       tensors_->allocate(node->grad(), node->shape(), node->value_type());
   }
 
-  void free(const Tensor& tensor) { tensors_->free(tensor); }
+  void free(const Tensor& tensor) {
+    if(!planner_ || !planner_->free(tensor))
+      tensors_->free(tensor);
+  }
 
   // @TODO: get rid of this, not really used or can be done better
   Ptr<Allocator> allocator() { return tensors_->allocator(); }
@@ -101,6 +125,8 @@ public:
   }
 
   void clear() {
+    if(planner_)
+      planner_->clear();
     tensors_->clear();
     shortterm_->clear();
   }
@@ -131,11 +157,20 @@ class ExpressionGraph : public std::enable_shared_from_this<ExpressionGraph> {
   bool inferenceOnly_{false};
 
   bool checkpointing_{false}; // use gradient checkpointing if true
+  size_t checkpointingBudget_{0}; // memory budget in bytes for kept activations, 0 = manual checkpoints only
+  bool checkpointPlanLogged_{false};
+
+  bool fusion_{false}; // fuse chains of element-wise nodes before each forward pass (inference only)
+  bool fusionLogged_{false};
+  size_t numFused_{0}; // element-wise nodes absorbed by the last fuseElementwise()
 
   bool reloaded_{false};
 
   bool throwNaN_{false};
 
+  // called by backward() for each parameter whose gradient is complete, see setParamGradientCallback()
+  std::function<void(Expr)> paramGradientCallback_;
+
 protected:
   // Delete, copy and move constructors
   ExpressionGraph(const ExpressionGraph&) = delete;
@@ -178,6 +213,14 @@ public:
   void setCheckpointing(bool checkpointing) { checkpointing_ = checkpointing; }
   bool isCheckpointing() { return checkpointing_; }
 
+  // Automatically select checkpoints such that the activations kept after the forward pass fit
+  // into the given budget, with as little recomputation as possible. Implies checkpointing.
+  void setCheckpointingBudgetMB(size_t budgetMB) {
+    checkpointingBudget_ = budgetMB * 1024 * 1024;
+    if(checkpointingBudget_ > 0)
+      checkpointing_ = true;
+  }
+
   void switchParams(const std::string& newNamespace) {
     namespace_ = newNamespace;
   }
@@ -193,6 +236,15 @@ public:
     tensors_->reserve(bytes);
   }
 
+  // Place the values of repeated forward passes with the same operations at offsets planned from
+  // their lifetimes, see MemoryPlanner. Useful for inference, where values are freed during the pass.
+  void setMemoryPlanning(bool planning) { tensors_->setMemoryPlanning(planning); }
+
+  // Compute chains of element-wise nodes with one kernel per chain, see fuseElementwise(). Only
+  // applied in inference mode, because the absorbed nodes have no values for the backward pass.
+  void setElementwiseFusion(bool fusion) { fusion_ = fusion; }
+  size_t getNumFusedNodes() const { return numFused_; }
+
   void reuseWorkspace(Ptr<ExpressionGraph> graph) {
     tensors_ = graph->tensors_;
   }
@@ -234,6 +286,13 @@ public:
 
   void backward(bool reset = true, float clipValue = 0.f);
 
+  // Register a function that backward() calls with each parameter as soon as its gradient is
+  // complete, i.e. when the backward tape reaches the parameter node after all of its consumers.
+  // Parameters that are not used by the current graph are not reported. Pass nullptr to remove.
+  void setParamGradientCallback(const std::function<void(Expr)>& callback) {
+    paramGradientCallback_ = callback;
+  }
+
   std::string graphviz() {
     std::stringstream ss;
     ss << "digraph ExpressionGraph {" << std::endl;
@@ -259,6 +318,12 @@ public:
 
 private:
 
+  // marks additional checkpoints on the forward tape to meet checkpointingBudget_
+  void planCheckpoints();
+
+  // replaces chains of element-wise nodes on the forward tape by their last node computing a program
+  void fuseElementwise();
+
   // Find the named parameter and its typed parent parameter object (params) and return both.
   // If the parameter is not found return the parent parameter object that the parameter should be added to.
   // Return [nullptr, nullptr] if no matching parent parameter object exists. 
@@ -485,6 +550,27 @@ public:
 public:
   // loading from array of io::Items
   void load(std::vector<io::Item>& ioItems, bool markReloaded = true) {
+    loadParams(ioItems, markReloaded, /*moveItems=*/false);
+  }
+
+  // as above, but the parameters take over the bytes of the items, so that each one is held in
+  // memory once until the parameters are initialized
+  void load(std::vector<io::Item>&& ioItems, bool markReloaded = true) {
+    loadParams(ioItems, markReloaded, /*moveItems=*/true);
+  }
+
+  void load(const std::string& name, bool markReloaded = true) {
+    LOG(info, "Loading model from {}", name);
+    load(io::loadItems(name), markReloaded);
+  }
+
+  void load(const void* ptr, bool markReloaded = true) {
+    LOG(info, "Loading model from buffer at {}", ptr);
+    load(io::loadItems(ptr), markReloaded);
+  }
+
+private:
+  void loadParams(std::vector<io::Item>& ioItems, bool markReloaded, bool moveItems) {
     setReloaded(false);
     for(auto& item : ioItems) {
       std::string pName = item.name;
@@ -496,23 +582,14 @@ public:
       // otherwise keep the loaded type. This is used when e.g. loading a float32 model as a float16 model as both
       // have type class TypeClass::float_type.
       auto loadElementType = isSameTypeClass(item.type, defaultElementType_) ? defaultElementType_ : item.type;
-      param(pName, item.shape, inits::fromItem(item), loadElementType, /*fixed=*/false);
+      auto shape = item.shape;
+      param(pName, shape, moveItems ? inits::fromItem(std::move(item)) : inits::fromItem(item), loadElementType, /*fixed=*/false);
     }
     if(markReloaded)
       setReloaded(true);
   }
 
-  void load(const std::string& name, bool markReloaded = true) {
-    LOG(info, "Loading model from {}", name);
-    auto items = io::loadItems(name);
-    load(items, markReloaded);
-  }
-
-  void load(const void* ptr, bool markReloaded = true) {
-    LOG(info, "Loading model from buffer at {}", ptr);
-    auto items = io::loadItems(ptr);
-    load(items, markReloaded);
-  }
+public:
 
   void mmap(const void* ptr, bool markReloaded = true) {
     ABORT_IF(backend_->getDeviceId().type != DeviceType::cpu || !inferenceOnly_,
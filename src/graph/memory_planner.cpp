@@ -0,0 +1,243 @@
+#include "graph/memory_planner.h"
+#include "common/hash.h"
+
+#include <algorithm>
+
+namespace marian {
+
+constexpr size_t MemoryPlanner::NONE;
+
+size_t MemoryPlanner::signature(const std::list<Expr>& tape) {
+  size_t seed = tape.size();
+  for(const auto& node : tape) {
+    util::hash_combine(seed, node->type());
+    util::hash_combine(seed, (size_t)node->value_type());
+  }
+  return seed;
+}
+
+void MemoryPlanner::begin(const std::list<Expr>& tape) {
+  signature_ = signature(tape);
+  time_ = 0;
+  tape_.clear();
+  for(const auto& node : tape)
+    tape_.push_back(node.get());
+
+  auto it = plans_.find(signature_);
+  // values still placed from an earlier pass would be overwritten
+  if(it != plans_.end() && placed_.empty()) {
+    Plan& plan = it->second;
+    std::vector<size_t> bytes(plan.nodes.size());
+    for(size_t k = 0; k < bytes.size(); ++k) {
+      auto node = tape_[plan.nodes[k]];
+      bytes[k] = tensors_->capacity(node->shape(), node->value_type());
+    }
+    if(bytes != plan.bytes) // other shapes than in the last pass
+      pack(plan, bytes);
+
+    plan_ = &plan;
+    if(!arena_ || arena_->size() < plan_->arenaBytes) {
+      size_t arenaBytes = plan_->arenaBytes;
+      for(const auto& kv : plans_)
+        arenaBytes = std::max(arenaBytes, kv.second.arenaBytes);
+      if(arena_)
+        tensors_->freeBytes(arena_);
+      arena_ = tensors_->allocateBytes(arenaBytes);
+    }
+    next_ = 0;
+    states_.assign(plan_->bytes.size(), State::unused);
+    mode_ = Mode::replay;
+  } else {
+    recNodes_.clear();
+    recBytes_.clear();
+    recBegin_.clear();
+    recEnd_.clear();
+    positions_.clear();
+    for(size_t i = 0; i < tape_.size(); ++i)
+      positions_[tape_[i]] = i;
+    recAllocatorBytes_ = tensors_->size(Type::uint8);
+    spanBegin_ = spanEnd_ = nullptr;
+    mode_ = Mode::record;
+  }
+}
+
+void MemoryPlanner::end() {
+  if(mode_ == Mode::record)
+    createPlan();
+  recording_.clear();
+  positions_.clear();
+  tape_.clear();
+  plan_ = nullptr;
+  mode_ = Mode::idle;
+}
+
+void MemoryPlanner::allocate(Expr node) {
+  Tensor& t = node->val();
+  Shape shape = node->shape();
+  Type type = node->value_type();
+
+  if(mode_ == Mode::replay) {
+    if(next_ >= plan_->nodes.size() || tape_[plan_->nodes[next_]] != node.get()) { // should not happen, same signature
+      mode_ = Mode::idle;
+    } else {
+      size_t k = next_++;
+      bool place = plan_->offsets[k] != NONE;
+      for(auto j : plan_->shares[k])
+        place = place && states_[j] != State::live;
+      if(place) {
+        tensors_->allocateView(t, arena_, plan_->offsets[k], shape, type);
+        states_[k] = State::live;
+        placed_[t->memory().get()] = k;
+        return;
+      }
+    }
+  }
+
+  tensors_->allocate(t, shape, type);
+
+  if(mode_ == Mode::record) {
+    auto position = positions_.find(node.get());
+    if(position == positions_.end() || tensors_->size(Type::uint8) != recAllocatorBytes_) {
+      // not on the tape, or the allocator has grown and moved the recorded values; the next pass
+      // with this signature records again
+      LOG(debug, "[memory] Recording of the memory plan aborted, the allocator has grown");
+      recording_.clear();
+      mode_ = Mode::idle;
+      return;
+    }
+    recording_[t->memory().get()] = recBytes_.size();
+    recNodes_.push_back(position->second);
+    recBytes_.push_back(tensors_->capacity(shape, type));
+    recBegin_.push_back(time_++);
+    recEnd_.push_back(NONE);
+    uint8_t* data = t->memory()->data();
+    spanBegin_ = spanBegin_ ? std::min(spanBegin_, data) : data;
+    spanEnd_ = std::max(spanEnd_, data + recBytes_.back());
+  }
+}
+
+bool MemoryPlanner::free(const Tensor& t) {
+  auto mem = t->memory().get();
+
+  auto it = placed_.find(mem);
+  if(it != placed_.end()) {
+    if(mode_ == Mode::replay)
+      states_[it->second] = State::freed;
+    tensors_->freeView(t);
+    placed_.erase(it);
+    return true;
+  }
+
+  if(mode_ == Mode::record) {
+    auto rec = recording_.find(mem);
+    if(rec != recording_.end()) {
+      recEnd_[rec->second] = time_++;
+      recording_.erase(rec);
+    }
+  }
+  return false;
+}
+
+void MemoryPlanner::clear() {
+  placed_.clear();
+  arena_ = nullptr;
+  if(mode_ == Mode::replay)
+    mode_ = Mode::idle;
+}
+
+// Best-fit packing of the values freed within the pass: largest first, each value goes into the
+// smallest gap between values with overlapping lifetimes that fits, or above all of them.
+void MemoryPlanner::pack(Plan& plan, const std::vector<size_t>& bytes) {
+  size_t n = bytes.size();
+  std::vector<size_t> order;
+  for(size_t i = 0; i < n; ++i)
+    if(plan.ends[i] != NONE)
+      order.push_back(i);
+
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return bytes[a] > bytes[b] || (bytes[a] == bytes[b] && plan.begins[a] < plan.begins[b]);
+  });
+
+  plan.bytes = bytes;
+  plan.offsets.assign(n, NONE);
+  plan.shares.assign(n, std::vector<size_t>());
+  plan.arenaBytes = 0;
+
+  std::vector<bool> packed(n, false);
+  std::vector<std::pair<size_t, size_t>> taken; // [offset, end) of packed values alive at the same time
+  for(auto i : order) {
+    taken.clear();
+    for(auto j : plan.overlaps[i])
+      if(packed[j])
+        taken.push_back({plan.offsets[j], plan.offsets[j] + bytes[j]});
+    std::sort(taken.begin(), taken.end());
+
+    size_t best = NONE, bestGap = NONE, top = 0;
+    for(const auto& range : taken) {
+      if(range.first > top) {
+        size_t gap = range.first - top;
+        if(gap >= bytes[i] && gap < bestGap) {
+          best = top;
+          bestGap = gap;
+        }
+      }
+      top = std::max(top, range.second);
+    }
+    plan.offsets[i] = best != NONE ? best : top;
+    plan.arenaBytes = std::max(plan.arenaBytes, plan.offsets[i] + bytes[i]);
+    packed[i] = true;
+  }
+
+  // values planned into the same memory, checked before placing the later one
+  for(auto i : order)
+    for(auto j : order)
+      if(j < i && plan.offsets[j] < plan.offsets[i] + bytes[i]
+         && plan.offsets[i] < plan.offsets[j] + bytes[j])
+        plan.shares[i].push_back(j);
+}
+
+void MemoryPlanner::createPlan() {
+  size_t n = recBytes_.size();
+  std::vector<size_t> freed;
+  for(size_t i = 0; i < n; ++i)
+    if(recEnd_[i] != NONE)
+      freed.push_back(i);
+  if(freed.empty())
+    return;
+
+  Plan plan;
+  plan.nodes = recNodes_;
+  plan.begins = recBegin_;
+  plan.ends = recEnd_;
+  plan.overlaps.resize(n);
+  for(auto i : freed)
+    for(auto j : freed)
+      if(i != j && recBegin_[i] < recEnd_[j] && recBegin_[j] < recEnd_[i])
+        plan.overlaps[i].push_back(j);
+  pack(plan, recBytes_);
+
+  // lower bound for any placement: the largest sum of simultaneously live values
+  std::vector<std::pair<size_t, long long>> events;
+  for(auto i : freed) {
+    events.push_back({recBegin_[i], (long long)recBytes_[i]});
+    events.push_back({recEnd_[i], -(long long)recBytes_[i]});
+  }
+  std::sort(events.begin(), events.end());
+  long long liveBytes = 0, peakLiveBytes = 0;
+  for(const auto& e : events) {
+    liveBytes += e.second;
+    peakLiveBytes = std::max(peakLiveBytes, liveBytes);
+  }
+
+  LOG_ONCE(info,
+           "[memory] Planned {:.2f} MB for {} of {} values of a forward pass (live peak {:.2f} MB, "
+           "allocated on the fly: {:.2f} MB)",
+           plan.arenaBytes / 1048576., freed.size(), n, peakLiveBytes / 1048576.,
+           (spanEnd_ - spanBegin_) / 1048576.);
+
+  if(plans_.size() >= 64) // e.g. many different tape structures
+    plans_.clear();
+  plans_[signature_] = std::move(plan);
+}
+
+}  // namespace marian
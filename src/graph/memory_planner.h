@@ -0,0 +1,89 @@
+#pragma once
+
+#include "common/definitions.h"
+#include "tensors/tensor_allocator.h"
+#include "graph/chainable.h"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace marian {
+
+/**
+ * Static memory plan for the values of repeated forward passes, e.g. during translation.
+ *
+ * The first forward pass over a tape with a given signature (node and value types, not shapes)
+ * allocates on the fly and records when each value is allocated and freed. Values that are freed
+ * before the forward pass returns are then assigned offsets in a single arena with a best-fit
+ * packer over their lifetimes. Subsequent forward passes with the same signature place these
+ * values into the arena without going through the allocator, so the allocator neither fragments
+ * nor grows during the pass. The lifetimes do not depend on the shapes, so a pass with the same
+ * signature but other shapes, e.g. the next step in decoding, only repacks the recorded values
+ * with their new sizes.
+ *
+ * A value is only placed if all values planned to share its memory have actually been freed,
+ * otherwise it is allocated on the fly; plans are therefore safe even if lifetimes differ.
+ */
+class MemoryPlanner {
+private:
+  static constexpr size_t NONE = (size_t)-1;
+
+  struct Plan {
+    // recorded once per signature
+    std::vector<size_t> nodes;                // [allocation] position of the node on the tape
+    std::vector<size_t> begins, ends;         // [allocation] lifetime, ends NONE if not freed in the pass
+    std::vector<std::vector<size_t>> overlaps; // [allocation] freed allocations alive at the same time
+    // packed for the shapes of the last pass
+    std::vector<size_t> bytes;                // [allocation] aligned size in allocation order
+    std::vector<size_t> offsets;              // [allocation] offset in the arena, NONE if not planned
+    std::vector<std::vector<size_t>> shares;  // [allocation] earlier allocations sharing its memory
+    size_t arenaBytes{0};
+  };
+
+  enum class Mode { idle, record, replay };
+  enum class State { unused, live, freed };
+
+  Ptr<TensorAllocator> tensors_;
+  std::unordered_map<size_t, Plan> plans_;  // by tape signature
+
+  Mode mode_{Mode::idle};
+  size_t signature_{0};
+  size_t time_{0};  // allocations and frees so far in the current forward pass
+  std::vector<Chainable<Tensor>*> tape_; // nodes of the current forward pass
+
+  // recording
+  std::vector<size_t> recNodes_, recBytes_, recBegin_, recEnd_;
+  std::unordered_map<Chainable<Tensor>*, size_t> positions_;  // of the nodes on the tape
+  std::unordered_map<MemoryPiece*, size_t> recording_;  // not yet freed recorded allocations
+  size_t recAllocatorBytes_{0}; // size of the allocator, the pointers below are invalid if it grows
+  uint8_t* spanBegin_{nullptr};
+  uint8_t* spanEnd_{nullptr};
+
+  // replaying
+  const Plan* plan_{nullptr};
+  size_t next_{0};
+  std::vector<State> states_;
+  MemoryPiece::PtrType arena_;
+  std::unordered_map<MemoryPiece*, size_t> placed_;  // values currently in the arena
+
+  static size_t signature(const std::list<Expr>& tape);
+  void createPlan();
+  static void pack(Plan& plan, const std::vector<size_t>& bytes);
+
+public:
+  MemoryPlanner(Ptr<TensorAllocator> tensors) : tensors_(tensors) {}
+
+  void begin(const std::list<Expr>& tape);
+  void end();
+
+  // allocates the value of a node of the current forward pass
+  void allocate(Expr node);
+  // returns true if the tensor was placed in the arena, i.e. must not be freed by the allocator
+  bool free(const Tensor& t);
+
+  // the allocator has been cleared, nothing is placed in the arena anymore
+  void clear();
+};
+
+}  // namespace marian
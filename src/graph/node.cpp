@@ -2,6 +2,7 @@
 #include "graph/auto_tuner.h"
 #include "graph/expression_graph.h"
 #include "tensors/backend.h"
+#include "tensors/tensor_operators.h"
 
 namespace marian {
 
@@ -67,7 +68,7 @@ void Node::forward() {
   if(recorder_)
     recorder_->start(recorderHash_);
 
-  runForward(forwardOps());
+  runForward(program_ ? programOps() : forwardOps());
 
   if(recorder_)
     recorder_->stop(recorderHash_, recorderStop_);
@@ -90,4 +91,22 @@ void Node::record(Ptr<AutoTunerRecorder> recorder,
   recorderHash_ = recorderHash;
   recorderStop_ = stop;
 }
+void Node::fuse(const std::vector<Expr>& inputs, const functional::Program& program) {
+  ABORT_IF(inputs.empty() || inputs.size() > functional::Program::MAX_INPUTS,
+           "Cannot fuse {} inputs into node {}", inputs.size(), type());
+  children_ = inputs;
+  program_.reset(new functional::Program(program));
+}
+
+NodeOps Node::programOps() {
+  const auto& program = *program_;
+  switch(children_.size()) {
+    case 1: return {NodeOp(Element(program, val_, child(0)->val()))};
+    case 2: return {NodeOp(Element(program, val_, child(0)->val(), child(1)->val()))};
+    case 3: return {NodeOp(Element(program, val_, child(0)->val(), child(1)->val(), child(2)->val()))};
+    default:
+      return {NodeOp(Element(program, val_, child(0)->val(), child(1)->val(), child(2)->val(), child(3)->val()))};
+  }
+}
+
 }  // namespace marian
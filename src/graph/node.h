@@ -8,6 +8,7 @@
 #include "tensors/backend.h"
 #include "tensors/tensor.h"
 
+#include "functional/program.h"
 #include "graph/chainable.h"
 
 namespace marian {
@@ -46,6 +47,10 @@ protected:
   size_t recorderHash_;
   bool recorderStop_;
 
+  UPtr<functional::Program> program_; // set if this node computes absorbed element-wise nodes as well
+
+  NodeOps programOps();
+
 public:
   Node(Ptr<ExpressionGraph> graph, const Shape& shape, const Type& valueType = Type::float32)
     : graph_(graph), shape_(shape), valueType_(valueType) {}
@@ -85,7 +90,7 @@ public:
   virtual void setId(size_t id) override { id_ = id; }
 
   virtual size_t getId() override { return id_; }
-
+
   virtual void increaseEdges(size_t edges = 1) { edges_ += edges; };
   virtual void decreaseEdges(size_t edges = 1) { edges_ -= edges; };
   virtual size_t edges() { return edges_; };
@@ -181,6 +186,14 @@ public:
   virtual Ptr<std::list<Expr>> getSubtape() override {
     return subtape_;
   };
+
+  // Describes the forward step as one step of an element-wise program over the children. Returns
+  // false if the node is not element-wise or cannot be expressed as a ProgramStep.
+  virtual bool elementStep(functional::ProgramStep& /*step*/) override { return false; }
+
+  // Replaces the children by the given inputs and the forward step by the program, which computes
+  // this node together with the element-wise nodes it absorbed. Inference only.
+  virtual void fuse(const std::vector<Expr>& inputs, const functional::Program& program) override;
 };
 
 struct NaryNodeOp : public Node {
@@ -207,6 +207,13 @@ Ptr<NodeInitializer> fromItem(const io::Item& item) {
   }
 }
 
+Ptr<NodeInitializer> fromItem(io::Item&& item) {
+  if(item.mapped)
+    return fromItem((const io::Item&)item);
+  auto owned = New<io::Item>(std::move(item));
+  return fromLambda([owned](Tensor tensor) { tensor->set(*owned); }, owned->type);
+}
+
 Ptr<NodeInitializer> fromTensor(Tensor externalTensor) {
   return fromLambda([externalTensor](Tensor t) { t->copyFrom(externalTensor); }, externalTensor->type());
 }
@@ -153,6 +153,10 @@ Ptr<NodeInitializer> fromSparseVector(std::pair<std::vector<size_t>, std::vector
 // @TODO: add documentation
 Ptr<NodeInitializer> fromItem(const io::Item& item);
 
+// As above, but takes over the bytes of the item instead of copying them. They are released once
+// the parameter has been initialized.
+Ptr<NodeInitializer> fromItem(io::Item&& item);
+
 // @TODO: add documentation
 Ptr<NodeInitializer> fromTensor(Tensor tensor);
 
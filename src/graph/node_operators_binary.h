@@ -778,6 +778,11 @@ struct PlusNodeOp : public ElementBinaryNodeOp {
   }
 
   const std::string type() override { return "+"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::add;
+    return true;
+  }
 };
 
 struct MinusNodeOp : public ElementBinaryNodeOp {
@@ -798,6 +803,11 @@ struct MinusNodeOp : public ElementBinaryNodeOp {
   }
 
   const std::string type() override { return "-"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::sub;
+    return true;
+  }
 };
 
 struct MultNodeOp : public ElementBinaryNodeOp {
@@ -818,6 +828,11 @@ struct MultNodeOp : public ElementBinaryNodeOp {
   }
 
   const std::string type() override { return "×"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::mul;
+    return true;
+  }
 };
 
 struct DivNodeOp : public ElementBinaryNodeOp {
@@ -843,6 +858,11 @@ struct DivNodeOp : public ElementBinaryNodeOp {
   }
 
   const std::string type() override { return "÷"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::div;
+    return true;
+  }
 };
 
 // struct PowNodeOp : public ElementBinaryNodeOp {
@@ -896,6 +916,11 @@ struct LogAddExpNodeOp : public ElementBinaryNodeOp {
 
   // TODO: this is not a "type" (as in data type). It's an operator name.
   const std::string type() override { return "logaddexp"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::logaddexp;
+    return true;
+  }
 };
 
 struct MaximumNodeOp : public ElementBinaryNodeOp {
@@ -923,6 +948,11 @@ struct MaximumNodeOp : public ElementBinaryNodeOp {
   }
 
   const std::string type() override { return "max"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::max;
+    return true;
+  }
 };
 
 // TODO: lotsa code dup here!
@@ -951,6 +981,11 @@ struct MinimumNodeOp : public ElementBinaryNodeOp {
   }
 
   const std::string type() override { return "min"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::min;
+    return true;
+  }
 };
 
 struct CmpNodeOp : public ElementBinaryNodeOp {
@@ -48,6 +48,12 @@ public:
 
   const std::string type() override { return "scalar_add"; }
 
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::addScalar;
+    step.scalar = scalar_;
+    return true;
+  }
+
   virtual size_t hash() override {
     if(!hash_) {
       hash_ = NaryNodeOp::hash();
@@ -105,6 +111,12 @@ public:
 
   const std::string type() override { return "scalar_mult"; }
 
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::mulScalar;
+    step.scalar = scalar_;
+    return true;
+  }
+
   virtual size_t hash() override {
     if(!hash_) {
       hash_ = NaryNodeOp::hash();
@@ -145,6 +157,12 @@ public:
 
   const std::string type() override { return "clip"; }
 
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::clip;
+    step.scalar = clip_;
+    return true;
+  }
+
   virtual size_t hash() override {
     if(!hash_) {
       hash_ = NaryNodeOp::hash();
@@ -179,6 +197,11 @@ struct SigmoidNodeOp : public UnaryNodeOp {
   }
 
   const std::string type() override { return "sigmoid"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::sigmoid;
+    return true;
+  }
 };
 
 // struct Scalar2PowNodeOp : public UnaryNodeOp {
@@ -271,6 +294,13 @@ struct TanhNodeOp : public NaryNodeOp {
   const std::string color() override { return "yellow"; }
 
   const std::string type() override { return "tanh"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    if(children_.size() != 1)
+      return false;
+    step.op = functional::ProgramOp::tanh;
+    return true;
+  }
 };
 
 struct ReLUNodeOp : public UnaryNodeOp {
@@ -296,6 +326,11 @@ struct ReLUNodeOp : public UnaryNodeOp {
   }
 
   const std::string type() override { return "ReLU"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::relu;
+    return true;
+  }
 };
 
 /**
@@ -393,6 +428,12 @@ struct SwishNodeOp : public UnaryNodeOp {
 
   const std::string type() override { return "swish"; }
 
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::swish;
+    step.scalar = b_;
+    return true;
+  }
+
   virtual size_t hash() override {
     if(!hash_) {
       hash_ = NaryNodeOp::hash();
@@ -593,6 +634,11 @@ struct LogNodeOp : public UnaryNodeOp {
   }
 
   const std::string type() override { return "log"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::log;
+    return true;
+  }
 };
 
 struct ExpNodeOp : public UnaryNodeOp {
@@ -609,6 +655,11 @@ struct ExpNodeOp : public UnaryNodeOp {
   }
 
   const std::string type() override { return "exp"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::exp;
+    return true;
+  }
 };
 
 struct SqrtNodeOp : public UnaryNodeOp {
@@ -628,6 +679,12 @@ struct SqrtNodeOp : public UnaryNodeOp {
 
   const std::string type() override { return "sqrt"; }
 
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::sqrt;
+    step.scalar = epsilon_;
+    return true;
+  }
+
   virtual size_t hash() override {
     if(!hash_) {
       size_t seed = NaryNodeOp::hash();
@@ -664,6 +721,11 @@ struct SquareNodeOp : public UnaryNodeOp {
   }
 
   const std::string type() override { return "square"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::square;
+    return true;
+  }
 };
 
 struct NegNodeOp : public UnaryNodeOp {
@@ -680,6 +742,11 @@ struct NegNodeOp : public UnaryNodeOp {
   }
 
   const std::string type() override { return "-"; }
+
+  bool elementStep(functional::ProgramStep& step) override {
+    step.op = functional::ProgramOp::neg;
+    return true;
+  }
 };
 
 struct TransposeNodeOp : public UnaryNodeOp {
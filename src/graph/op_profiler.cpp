@@ -0,0 +1,146 @@
+#include "graph/op_profiler.h"
+#include "common/trace_writer.h"
+#include "graph/expression_graph.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace marian {
+
+namespace {
+
+struct OpStats {
+  size_t calls{0};
+  double seconds{0};
+  double flops{0};
+  double bytes{0};
+};
+
+// (type and direction, shape) -> stats
+typedef std::map<std::pair<std::string, std::string>, OpStats> OpTable;
+
+std::mutex mutex;
+OpTable periodStats, totalStats;
+timer::TraceWriter trace;
+
+std::string shapeString(const Shape& shape) {
+  std::stringstream ss;
+  for(int i = 0; i < shape.size(); ++i)
+    ss << (i > 0 ? "x" : "") << shape[i];
+  return ss.str();
+}
+
+double bytesOf(Chainable<Tensor>* node) {
+  return (double)node->shape().elements() * sizeOf(node->value_type());
+}
+
+// Matrix products take 2 * K operations per output element, where K is the inner dimension; this
+// also holds for transposed and batched products: K = |A| * cols(C) / |C|. Everything else is
+// counted as one operation per output element. A backward step costs about twice the forward step.
+double estimateFlops(Chainable<Tensor>* node, bool backward) {
+  double out = (double)node->shape().elements();
+  double flops = out;
+  const auto& type = node->type();
+  if((type == "dot" || type == "bdot" || type == "affine") && node->children().size() >= 2 && out > 0) {
+    double inner = node->children()[0]->shape().elements() * (double)node->shape()[-1] / out;
+    flops = 2 * out * inner;
+  }
+  return backward ? 2 * flops : flops;
+}
+
+void logTable(const OpTable& table, size_t maxRows, const std::string& title) {
+  std::vector<std::pair<std::pair<std::string, std::string>, OpStats>> rows(table.begin(), table.end());
+  std::sort(rows.begin(), rows.end(), [](const decltype(rows)::value_type& a, const decltype(rows)::value_type& b) {
+    return a.second.seconds > b.second.seconds;
+  });
+  double totalSeconds = 0;
+  for(const auto& row : rows)
+    totalSeconds += row.second.seconds;
+
+  std::stringstream ss;
+  ss << fmt::format("[profiler] {}: {:.3f}s in {} node types and shapes\n", title, totalSeconds, rows.size());
+  ss << fmt::format("{:>10} {:>6} {:>9} {:>10} {:>9} {:>8}  {:<20} {}",
+                    "total ms", "%", "calls", "avg us", "GFLOP/s", "GB/s", "op", "shape");
+  for(size_t i = 0; i < std::min(maxRows, rows.size()); ++i) {
+    const auto& key = rows[i].first;
+    const auto& s = rows[i].second;
+    ss << "\n"
+       << fmt::format("{:>10.2f} {:>6.2f} {:>9} {:>10.1f} {:>9.2f} {:>8.2f}  {:<20} {}",
+                      s.seconds * 1e3,
+                      totalSeconds > 0 ? 100 * s.seconds / totalSeconds : 0.,
+                      s.calls,
+                      s.seconds / s.calls * 1e6,
+                      s.seconds > 0 ? s.flops / s.seconds * 1e-9 : 0.,
+                      s.seconds > 0 ? s.bytes / s.seconds * 1e-9 : 0.,
+                      key.first,
+                      key.second);
+  }
+  LOG(info, ss.str());
+}
+
+}  // namespace
+
+std::atomic<bool> OpProfiler::enabled_{false};
+
+void OpProfiler::enable(const std::string& traceFile) {
+  if(!traceFile.empty() && !trace.isOpen()) {
+    trace.open(traceFile);
+    LOG(info, "[profiler] Writing operator trace to {}", traceFile);
+  }
+  enabled_ = true;
+}
+
+void OpProfiler::disable() {
+  if(!enabled_)
+    return;
+  enabled_ = false;
+  std::lock_guard<std::mutex> lock(mutex);
+  logTable(totalStats, (size_t)-1, "Operators in total");
+  periodStats.clear();
+  totalStats.clear();
+  trace.close();
+}
+
+OpProfiler::clock::time_point OpProfiler::start(Chainable<Tensor>* node) {
+  node->graph()->getBackend()->synchronize(); // do not count work queued by earlier nodes
+  return clock::now();
+}
+
+void OpProfiler::stop(Chainable<Tensor>* node, bool backward, clock::time_point begin) {
+  node->graph()->getBackend()->synchronize();
+  auto end = clock::now();
+
+  std::string op = node->type() + (backward ? " bwd" : " fwd");
+  std::string shape = shapeString(node->shape());
+  double bytes = bytesOf(node);
+  for(const auto& child : node->children())
+    bytes += bytesOf(child.get());
+  if(backward)
+    bytes *= 2; // reads and writes gradients as well
+  double flops = estimateFlops(node, backward);
+  double seconds = std::chrono::duration<double>(end - begin).count();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto table : {&periodStats, &totalStats}) {
+      auto& s = (*table)[{op, shape}];
+      s.calls++;
+      s.seconds += seconds;
+      s.flops += flops;
+      s.bytes += bytes;
+    }
+  }
+  if(trace.isOpen())
+    trace.add(op, begin, end, "\"shape\":\"" + shape + "\"");
+}
+
+void OpProfiler::logPeriod(size_t maxRows) {
+  std::lock_guard<std::mutex> lock(mutex);
+  logTable(periodStats, maxRows, "Operators since last display");
+  periodStats.clear();
+  trace.flush();
+}
+
+}  // namespace marian
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "common/definitions.h"
+#include "common/types.h"
+#include "graph/chainable.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace marian {
+
+// Aggregates the wall time of forward and backward steps per node type and shape, together with
+// call counts and rough estimates of floating-point operations and bytes read and written
+// (--profile-ops). Devices are synchronized around each timed step, so the profiled run is slower
+// but the times are attributed to the right nodes. Optionally writes every step to a trace file in
+// the Chrome trace event format.
+class OpProfiler {
+public:
+  using clock = std::chrono::steady_clock;
+
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // start profiling; if traceFile is not empty, trace events are written to that file
+  static void enable(const std::string& traceFile = "");
+  // log the table for the whole run, close the trace file and stop profiling
+  static void disable();
+
+  static clock::time_point start(Chainable<Tensor>* node);
+  static void stop(Chainable<Tensor>* node, bool backward, clock::time_point begin);
+
+  // log the table for the steps since the last call, at most maxRows rows sorted by total time
+  static void logPeriod(size_t maxRows = 20);
+
+private:
+  static std::atomic<bool> enabled_;
+};
+
+// Times v->forward() or v->backward() in the enclosing scope if profiling is enabled.
+class ScopedOp {
+private:
+  Chainable<Tensor>* node_;
+  bool backward_;
+  bool active_;
+  OpProfiler::clock::time_point begin_;
+
+public:
+  ScopedOp(Chainable<Tensor>* node, bool backward)
+      : node_(node), backward_(backward), active_(OpProfiler::enabled()) {
+    if(active_)
+      begin_ = OpProfiler::start(node_);
+  }
+
+  ~ScopedOp() {
+    if(active_)
+      OpProfiler::stop(node_, backward_, begin_);
+  }
+
+  ScopedOp(const ScopedOp&) = delete;
+  ScopedOp& operator=(const ScopedOp&) = delete;
+};
+
+}  // namespace marian
@@ -94,6 +94,9 @@ public:
           vals_->allocate(p->val(), p->shape(), p->value_type());
         }
       }
+      // the padding between the parameters is part of the optimizer state and the smoothed
+      // parameters of synchronous SGD, and saved with them
+      vals()->set(0.f);
     }
   }
 
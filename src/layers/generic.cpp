@@ -83,7 +83,8 @@ namespace marian {
       auto numGroups = getNumFactorGroups();
       for (size_t g = 1; g < numGroups; g++) {
         auto factorMaxima = max(logits_[g]->loss(), -1);
-        auto factorMasks = constant(getFactorMasks(g, shortlist ? shortlist->indices() : std::vector<WordIndex>()));
+        auto factorMasks = g < factorMasks_.size() && factorMasks_[g] ? factorMasks_[g] // precomputed once per batch by Output
+                         : constant(factoredVocab_->getFactorMasks(g, shortlist ? shortlist->indices() : std::vector<WordIndex>()));
         sel = sel + factorMaxima * factorMasks; // those lemmas that don't have a factor get multiplied with 0
       }
     }
@@ -94,7 +95,7 @@ namespace marian {
     return sel;
   }
 
-  // used for breakDown() only
+  // unnormalized, used for breakDown() and the secondary factors in decoding
   // Index is flattened
   Tensor Logits::getFactoredLogitsTensor(size_t groupIndex) const {
     ABORT_IF(empty(), "Attempted to read out logits on empty Logits object");
@@ -173,25 +174,11 @@ namespace marian {
   //  return res;
   //}
 
-  // return a vector of 1 or 0 indicating for each lemma whether it has a specific factor
-  // If 'indices' is given, then return the masks for the indices; otherwise for all lemmas
-  std::vector<float> Logits::getFactorMasks(size_t factorGroup, const std::vector<WordIndex>& indices) const { // [lemmaIndex] -> 1.0 for words that do have this factor; else 0
-    size_t n = indices.empty() ? (factoredVocab_->getGroupRange(0).second - factoredVocab_->getGroupRange(0).first) : indices.size();
-    std::vector<float> res;
-    res.reserve(n);
-    // @TODO: we should rearrange lemmaHasFactorGroup as vector[groups[i] of float; then move this into FactoredVocab
-    for (size_t i = 0; i < n; i++) {
-      auto lemma = indices.empty() ? i : (indices[i] - factoredVocab_->getGroupRange(0).first);
-      res.push_back((float)factoredVocab_->lemmaHasFactorGroup(lemma, factorGroup));
-    }
-    return res;
-  }
-
   Logits Logits::applyUnaryFunction(const std::function<Expr(Expr)>& f) const { // clone this but apply f to all loss values
     std::vector<Ptr<RationalLoss>> newLogits;
     for (const auto& l : logits_)
       newLogits.emplace_back(New<RationalLoss>(f(l->loss()), l->count()));
-    return Logits(std::move(newLogits), factoredVocab_);
+    return Logits(std::move(newLogits), factoredVocab_, factorMasks_);
   }
 
   Logits Logits::applyUnaryFunctions(const std::function<Expr(Expr)>& f1, const std::function<Expr(Expr)>& fother) const {
@@ -201,7 +188,7 @@ namespace marian {
         newLogits.emplace_back(New<RationalLoss>((first?f1:fother)(l->loss()), l->count())); // f1 for first, fother for all others
         first = false;
       }
-      return Logits(std::move(newLogits), factoredVocab_);
+      return Logits(std::move(newLogits), factoredVocab_, factorMasks_);
   }
 
   // @TODO: code dup with above; we can merge it into applyToRationalLoss()
@@ -209,7 +196,7 @@ namespace marian {
     std::vector<Ptr<RationalLoss>> newLogits;
     for (const auto& l : logits_)
       newLogits.emplace_back(New<RationalLoss>(l->loss(), count));
-    return Logits(std::move(newLogits), factoredVocab_);
+    return Logits(std::move(newLogits), factoredVocab_, factorMasks_);
   }
 
   namespace mlp {
@@ -395,7 +382,16 @@ namespace marian {
             input1 = input1 + f;
           }
         }
-        return Logits(std::move(allLogits), factoredVocab_);
+        // in decoding, the lemma masks used for normalizing the lemma scores (see Logits::getFactoredLogits())
+        // are the same in every step, so they are created once per batch, like the shortlisted parameters
+        if (graph_->isInference() && cachedFactorMasks_.empty()) {
+          cachedFactorMasks_.resize(numGroups);
+          for (size_t g = 1; g < numGroups; g++) {
+            auto masks = factoredVocab_->getFactorMasks(g, shortlist_ ? shortlist_->indices() : std::vector<WordIndex>());
+            cachedFactorMasks_[g] = graph->constant({(int)masks.size()}, inits::fromVector(masks), Type::float32);
+          }
+        }
+        return Logits(std::move(allLogits), factoredVocab_, cachedFactorMasks_);
       }
       else if (shortlist_)
         return Logits(affine(input, cachedShortWt_, cachedShortb_, false, /*transB=*/isLegacyUntransposedW ? false : true));
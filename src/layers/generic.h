@@ -109,8 +109,8 @@ public:
       logits_.push_back(logits);
     }
     explicit Logits(Expr logits); // single-output constructor from Expr only (RationalLoss has no count)
-    Logits(std::vector<Ptr<RationalLoss>>&& logits, Ptr<FactoredVocab> embeddingFactorMapping) // factored-output constructor
-      : logits_(std::move(logits)), factoredVocab_(embeddingFactorMapping) {}
+    Logits(std::vector<Ptr<RationalLoss>>&& logits, Ptr<FactoredVocab> embeddingFactorMapping, const std::vector<Expr>& factorMasks = {}) // factored-output constructor
+      : logits_(std::move(logits)), factoredVocab_(embeddingFactorMapping), factorMasks_(factorMasks) {}
     Expr getLogits() const; // assume it holds logits: get them, possibly aggregating over factors
     Expr getFactoredLogits(size_t groupIndex, Ptr<data::Shortlist> shortlist = nullptr, const std::vector<IndexType>& hypIndices = {}, size_t beamSize = 0) const; // get logits for only one factor group, with optional reshuffle
     //Ptr<RationalLoss> getRationalLoss() const; // assume it holds a loss: get that
@@ -127,7 +127,7 @@ public:
       MaskedFactorIndices(const Words& words) { indices = toWordIndexVector(words); } // we can leave masks uninitialized for this special use case
     };
     std::vector<MaskedFactorIndices> factorizeWords(const Words& words) const; // breaks encoded Word into individual factor indices
-    Tensor getFactoredLogitsTensor(size_t factorGroup) const; // used for breakDown() only
+    Tensor getFactoredLogitsTensor(size_t factorGroup) const; // unnormalized, used for breakDown() and the secondary factors in decoding
     size_t getNumFactorGroups() const { return logits_.size(); }
     bool empty() const { return logits_.empty(); }
     Logits withCounts(const Expr& count) const; // create new Logits with 'count' implanted into all logits_
@@ -138,12 +138,12 @@ private:
     Expr constant(const Shape& shape, const std::vector<uint32_t>& data) const { return graph()->constant(shape, inits::fromVector(data), Type::uint32);  }
     template<typename T> Expr constant(const std::vector<T>& data) const { return constant(Shape{(int)data.size()}, data); } // same as constant() but assuming vector
     Expr indices(const std::vector<uint32_t>& data) const { return graph()->indices(data); } // actually the same as constant(data) for this data type
-    std::vector<float> getFactorMasks(size_t factorGroup, const std::vector<WordIndex>& indices) const;
 private:
     // members
     // @TODO: we don't use the RationalLoss component anymore, can be removed again, and replaced just by the Expr
     std::vector<Ptr<RationalLoss>> logits_; // [group id][B..., num factors in group]
     Ptr<FactoredVocab> factoredVocab_;
+    std::vector<Expr> factorMasks_; // [group id] optional precomputed FactoredVocab::getFactorMasks() constants, matching the shortlist
 };
 
 // Unary function that returns a Logits object
@@ -238,6 +238,7 @@ private:
   Expr cachedShortWt_;  // short-listed version, cached (cleared by clear())
   Expr cachedShortb_;   // these match the current value of shortlist_
   Expr cachedShortLemmaEt_;
+  std::vector<Expr> cachedFactorMasks_; // [group id] lemma masks for decoding, also match shortlist_
   Ptr<FactoredVocab> factoredVocab_;
 
   // optional parameters set/updated after construction
@@ -262,7 +263,7 @@ public:
     if (shortlist_)
       ABORT_IF(shortlist.get() != shortlist_.get(), "Output shortlist cannot be changed except after clear()");
     else {
-      ABORT_IF(cachedShortWt_ || cachedShortb_ || cachedShortLemmaEt_, "No shortlist but cached parameters??");
+      ABORT_IF(cachedShortWt_ || cachedShortb_ || cachedShortLemmaEt_ || !cachedFactorMasks_.empty(), "No shortlist but cached parameters??");
       shortlist_ = shortlist;
     }
     // cachedShortWt_ and cachedShortb_ will be created lazily inside apply()
@@ -275,6 +276,7 @@ public:
     cachedShortWt_ = nullptr;
     cachedShortb_  = nullptr;
     cachedShortLemmaEt_ = nullptr;
+    cachedFactorMasks_.clear();
   }
 
   Logits applyAsLogits(Expr input) override final;
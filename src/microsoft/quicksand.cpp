@@ -171,7 +171,7 @@ public:
           else
             alignmentThreshold = std::max(std::stof(alignment), 0.f);
           auto hyp = std::get<1>(result);
-          data::WordAlignment align = data::ConvertSoftAlignToHardAlign(hyp->tracebackAlignment(), alignmentThreshold);
+          data::WordAlignment align = data::ConvertSoftAlignToHardAlign(hyp.tracebackAlignment(), alignmentThreshold);
           // convert to QuickSAND format
           alignmentSets.resize(words.size());
           for (const auto& p : align)
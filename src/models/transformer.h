@@ -579,10 +579,13 @@ public:
 
 class DecoderTransformer : public Transformer<DecoderBase> {
   typedef Transformer<DecoderBase> Base;
-  using Base::Base;
 private:
   Ptr<mlp::Output> output_;
 
+  // decoder layer that returns the attention weights of one head, or -1 if none. Resolved once from
+  // the options, as step() runs for every target word during decoding.
+  int alignmentLayer_{-1};
+
   // This caches RNN objects to avoid reconstruction between batches or deocoding steps.
   // To be removed after refactoring of transformer.h
   std::unordered_map<std::string, Ptr<rnn::RNN>> perLayerRnn_;
@@ -609,6 +612,21 @@ private:
   }
 
 public:
+  DecoderTransformer(Ptr<ExpressionGraph> graph, Ptr<Options> options) : Base(graph, options) {
+    // if training is performed with guided_alignment or if alignment is requested during
+    // decoding or scoring return the attention weights of one head of the last layer.
+    // @TODO: maybe allow to return average or max over all heads?
+    if(opt<std::string>("guided-alignment", "none") != "none" || options_->hasAndNotEmpty("alignment")) {
+      int decDepth = opt<int>("dec-depth");
+      std::string gaStr = opt<std::string>("transformer-guided-alignment-layer", "last");
+      alignmentLayer_ = gaStr == "last" ? decDepth - 1 : std::stoi(gaStr) - 1;
+
+      ABORT_IF(alignmentLayer_ < 0 || alignmentLayer_ >= decDepth,
+               "Chosen layer for guided attention ({}) larger than number of layers ({})",
+               alignmentLayer_ + 1, decDepth);
+    }
+  }
+
   virtual Ptr<DecoderState> startState(
       Ptr<ExpressionGraph> graph,
       Ptr<data::CorpusBatch> batch,
@@ -750,22 +768,7 @@ public:
           if(j > 0)
             prefix += "_enc" + std::to_string(j + 1);
 
-          // if training is performed with guided_alignment or if alignment is requested during
-          // decoding or scoring return the attention weights of one head of the last layer.
-          // @TODO: maybe allow to return average or max over all heads?
-          bool saveAttentionWeights = false;
-          if(j == 0 && (options_->get("guided-alignment", std::string("none")) != "none" || options_->hasAndNotEmpty("alignment"))) {
-            size_t attLayer = decDepth - 1;
-            std::string gaStr = options_->get<std::string>("transformer-guided-alignment-layer", "last");
-            if(gaStr != "last")
-              attLayer = std::stoull(gaStr) - 1;
-
-            ABORT_IF(attLayer >= decDepth,
-                     "Chosen layer for guided attention ({}) larger than number of layers ({})",
-                     attLayer + 1, decDepth);
-
-            saveAttentionWeights = i == attLayer;
-          }
+          bool saveAttentionWeights = j == 0 && i == alignmentLayer_;
 
           query = LayerAttention(prefix,
                                  query,
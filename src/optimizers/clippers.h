@@ -16,6 +16,15 @@ namespace marian {
 class ClipperBase {
 public:
   virtual void clip(Tensor) = 0;
+
+  // For optimizers that clip within a fused update pass: instead of modifying t, return the
+  // factor to scale t by and the value to clip the scaled elements to (0 means no clipping).
+  virtual void getClipping(Tensor t, float& scale, float& clipValue) {
+    clip(t);
+    scale = 1.f;
+    clipValue = 0.f;
+  }
+
   virtual ~ClipperBase() {}
 };
 
@@ -26,6 +35,7 @@ public:
   Elementwise(float c = 10.0) : c_(c) {}
 
   void clip(Tensor t) override;
+  void getClipping(Tensor t, float& scale, float& clipValue) override;
 
 private:
   float c_;
@@ -36,6 +46,7 @@ public:
   Norm(float c = 1.0) : c_(c) {}
 
   void clip(Tensor t) override;
+  void getClipping(Tensor t, float& scale, float& clipValue) override;
 
 private:
   float c_;
@@ -1,11 +1,42 @@
 #include "optimizers.h"
 
 #include "common/io.h"
+#include "common/phase_timer.h"
 #include "tensors/tensor_operators.h"
 #include <array>
+#include <thread>
 
 namespace marian {
 
+void OptimizerBase::update(Tensor params,
+                           Tensor grads,
+                           size_t mbSize /*= mbSizeNotProvided*/,
+                           Tensor paramsAvg /*= nullptr*/,
+                           float avgDecay /*= 0.f*/) {
+  timer::ScopedPhase phase(timer::Phase::update);
+  size_t refMBWords = refMBWordsParam_;
+  if (refMBWords == 0) { // optimizer not configured to use hyper-parameter auto-adjustment
+    refMBWords = mbSize = 1; // neutral settings that keep the standard behavior
+  }
+  else { // optimizer is configured to auto-adjust hyper-parameters
+    ABORT_IF(mbSize == mbSizeNotProvided, "Using rational optimizer auto-adjustment with trainer that does not provide MB size");
+    // note: this behavior is only meaningful if using the ce-sum criterion
+  }
+
+  if(updateFusedImpl(params, grads, paramsAvg, avgDecay, mbSize, refMBWords))
+    return;
+
+  if(clipper_)
+    clipper_->clip(grads); //@BUGBUG: take into account actual mini-batch size since gradients are not normalized
+
+  updateImpl(params, grads, mbSize, refMBWords);
+
+  if(paramsAvg) {
+    using namespace functional;
+    Element(_1 = ((1.f - avgDecay) * _1) + (avgDecay * _2), paramsAvg, params);
+  }
+}
+
 void Sgd::updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_t refMBWords) {
   actualMBSize, refMBWords; // (no correction for base update needed beyond using ce-sum)
   using namespace functional;
@@ -42,21 +73,15 @@ void Adagrad::updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_
   params->getBackend()->synchronize();
 }
 
-void Adagrad::load(const std::string& name,
-                   const std::vector<Ptr<OptimizerBase>>& opts,
-                   const std::vector<Ptr<Backend>>& backends,
-                   const ScatterStateFunc& scatterFn) {
+void Adagrad::setStateItems(const std::vector<io::Item>& items,
+                            const std::vector<Ptr<OptimizerBase>>& opts,
+                            const std::vector<Ptr<Backend>>& backends,
+                            const ScatterStateFunc& scatterFn) {
   ABORT_IF(opts.size() != backends.size(), "opts and backends of different sizes??");
 
-  if(!filesystem::exists(name))
-    return;
-
-  LOG(info, "Loading Adagrad parameters from {}", name);
-
   std::vector<float> vGt;
 
-  auto items = io::loadItems(name);
-  for(auto item : items) {
+  for(const auto& item : items) {
     // get the size of gt_
     auto totalSize = item.shape.elements();
 
@@ -85,12 +110,9 @@ void Adagrad::load(const std::string& name,
   });
 }
 
-void Adagrad::save(const std::string& name,
-                   const std::vector<Ptr<OptimizerBase>>& opts,
-                   const GatherStateFunc& gatherFn,
-                   bool isMainProcess /*= true*/) {
-  LOG(info, "Saving Adagrad parameters to {}", name);
-
+std::vector<io::Item> Adagrad::getStateItems(const std::vector<Ptr<OptimizerBase>>& opts,
+                                             const GatherStateFunc& gatherFn,
+                                             bool isMainProcess /*= true*/) {
   // fetch and concatenate state vectors from distributed shards into a CPU-side vector
   auto vGt = gatherFn([&](size_t localDeviceIndex) {
       auto opt = std::dynamic_pointer_cast<Adagrad>(opts[localDeviceIndex]);
@@ -101,9 +123,8 @@ void Adagrad::save(const std::string& name,
 
   // if not main MPI process then we have done our duty
   if (!isMainProcess)
-    return;
+    return {};
 
-  // save to file
   io::Item item;
   item.name = "adagrad_gt";
   item.shape = Shape({1, (int)vGt.size()});
@@ -111,7 +132,7 @@ void Adagrad::save(const std::string& name,
   item.bytes.resize(vGt.size() * sizeOf(item.type));
   std::copy((char*)vGt.data(), (char*)(vGt.data() + vGt.size()), item.bytes.begin());
 
-  io::saveItems(name, {item});
+  return {item};
 }
 
 void Adagrad::resetStats() {
@@ -121,8 +142,7 @@ void Adagrad::resetStats() {
 
 // Adam
 
-void Adam::updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_t refMBWords) {
-  // lazy allocation
+void Adam::lazyAllocate(Tensor params) {
   if(!alloc_)
     alloc_ = New<TensorAllocator>(params->getBackend());
 
@@ -134,6 +154,53 @@ void Adam::updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_t r
     alloc_->allocate(vt_, {1, elements});
     vt_->set(0.f);
   }
+}
+
+// Same computation as updateImpl() below plus clipping and smoothing, but as a single pass over
+// the shard, which matters since the update is bound by memory bandwidth.
+bool Adam::updateFusedImpl(Tensor params,
+                           Tensor grads,
+                           Tensor paramsAvg,
+                           float avgDecay,
+                           size_t actualMBSize,
+                           size_t refMBWords) {
+  if(params->type() != Type::float32 || grads->type() != Type::float32)
+    return false;
+
+  lazyAllocate(params);
+
+  AdamUpdateParams p;
+  if(clipper_)
+    clipper_->getClipping(grads, p.gradScale, p.gradClip);
+
+  double T    = (double)actualMBSize;
+  double Tref = (double)refMBWords;
+  double beta1 = beta1_;
+  double beta2 = beta2_;
+
+  denom1_ = (beta1 * denom1_) + (1 - beta1);
+  denom2_ = (beta2 * denom2_) + (1 - beta2);
+
+  p.beta1     = (float)beta1;
+  p.beta2     = (float)beta2;
+  p.gradNorm1 = float((1 - beta1) / T);
+  p.gradNorm2 = float((1 - beta2) / T / T);
+  p.eta       = (float)(eta_ * (T/Tref));
+  p.denom1    = (float)denom1_;
+  p.denom2    = (float)denom2_;
+  p.eps       = eps_;
+  p.decay     = w_;
+  p.avgDecay  = paramsAvg ? avgDecay : 0.f;
+  p.threads   = updateThreads_;
+
+  AdamUpdate(params, mt_, vt_, paramsAvg, grads, p);
+
+  params->getBackend()->synchronize();
+  return true;
+}
+
+void Adam::updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_t refMBWords) {
+  lazyAllocate(params);
 
   double T    = (double)actualMBSize;
   double Tref = (double)refMBWords;
@@ -167,23 +234,17 @@ void Adam::updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_t r
   params->getBackend()->synchronize(); // @TODO: This should not be in here. Maybe in the wrapper. Why is it needed at all?
 }
 
-void Adam::load(const std::string& name,
-                const std::vector<Ptr<OptimizerBase>>& opts,
-                const std::vector<Ptr<Backend>>& backends,
-                const ScatterStateFunc& scatterFn) {
+void Adam::setStateItems(const std::vector<io::Item>& items,
+                         const std::vector<Ptr<OptimizerBase>>& opts,
+                         const std::vector<Ptr<Backend>>& backends,
+                         const ScatterStateFunc& scatterFn) {
   ABORT_IF(opts.size() != backends.size(), "opts and backends of different sizes??");
 
-  if(!filesystem::exists(name))
-    return;
-
-  LOG(info, "Loading Adam parameters from {}", name);
-
   std::vector<float> vMt;
   std::vector<float> vVt;
-  std::array<double, 2> vDenoms;
+  std::array<double, 2> vDenoms{0, 0};
 
-  auto items = io::loadItems(name);
-  for(auto item : items) {
+  for(const auto& item : items) {
     // get the size of mt_ and vt_, they are the same
     auto totalSize = item.shape.elements();
 
@@ -232,18 +293,17 @@ void Adam::load(const std::string& name,
     opt->vt_->set(std::vector<float>(begin, end));
   });
 
-  denom1_ = vDenoms[0];
-  denom2_ = vDenoms[1];
+  for(auto opt : opts) { // every shard keeps its own denominators
+    auto adam = std::dynamic_pointer_cast<Adam>(opt);
+    adam->denom1_ = vDenoms[0];
+    adam->denom2_ = vDenoms[1];
+  }
   //LOG(info, "done loading Adam params");
 }
 
-void Adam::save(const std::string& name,
-                const std::vector<Ptr<OptimizerBase>>& opts,
-                const GatherStateFunc& gatherFn,
-                bool isMainProcess /*= true*/) {
-  if (isMainProcess)
-    LOG(info, "Saving Adam parameters to {}", name);
-
+std::vector<io::Item> Adam::getStateItems(const std::vector<Ptr<OptimizerBase>>& opts,
+                                          const GatherStateFunc& gatherFn,
+                                          bool isMainProcess /*= true*/) {
   // fetch and concatenate state vectors from distributed shards into a CPU-side vector
   auto vMt = gatherFn([&](size_t localDeviceIndex) {
     auto opt = std::dynamic_pointer_cast<Adam>(opts[localDeviceIndex]);
@@ -261,9 +321,8 @@ void Adam::save(const std::string& name,
 
   // if not main MPI process then we have done our duty
   if (!isMainProcess)
-      return;
+      return {};
 
-  // save to file
   io::Item itemMt;
   itemMt.name = "adam_mt";
   itemMt.shape = Shape({1, (int)vMt.size()});
@@ -290,7 +349,7 @@ void Adam::save(const std::string& name,
   std::copy(
       (char*)vDenoms.data(), (char*)(vDenoms.data() + vDenoms.size()), itemDenoms.bytes.begin());
 
-  io::saveItems(name, {itemMt, itemVt, itemDenoms});
+  return {itemMt, itemVt, itemDenoms};
 }
 
 void Adam::resetStats() {
@@ -322,7 +381,12 @@ Ptr<OptimizerBase> Optimizer(Ptr<Options> options) {
   } else if(opt == "adagrad") {
     return Optimizer<Adagrad>(lrate, refMBWordsParam, clipper, params);
   } else if(opt == "adam") {
-    return Optimizer<Adam>(lrate, refMBWordsParam, clipper, params);
+    auto adam = Optimizer<Adam>(lrate, refMBWordsParam, clipper, params);
+    // the shards of all CPU devices are updated at the same time, each of them gets its share of the cores
+    size_t cpuDevices = options->get<size_t>("cpu-threads", 0);
+    if(cpuDevices > 0)
+      adam->setUpdateThreads(std::thread::hardware_concurrency() / cpuDevices);
+    return adam;
   } else {
     ABORT("Unknown optimizer kind: {}", opt);
   }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/io.h"
 #include "common/options.h"
 #include "graph/expression_graph.h"
 #include "optimizers/clippers.h"
@@ -40,21 +41,17 @@ public:
     update(p, g, mbSize);
   }
 
-  void update(Tensor params, Tensor grads, size_t mbSize = mbSizeNotProvided) {
-    if(clipper_)
-      clipper_->clip(grads); //@BUGBUG: take into account actual mini-batch size since gradients are not normalized
+  // Update params from grads. If paramsAvg is given, also update these exponentially smoothed
+  // parameters: paramsAvg = (1 - avgDecay) * paramsAvg + avgDecay * params. Optimizers with a
+  // fused update kernel apply clipping, the update and the smoothing in a single pass.
+  void update(Tensor params,
+              Tensor grads,
+              size_t mbSize = mbSizeNotProvided,
+              Tensor paramsAvg = nullptr,
+              float avgDecay = 0.f);
 
-    size_t refMBWords = refMBWordsParam_;
-    if (refMBWords == 0) { // optimizer not configured to use hyper-parameter auto-adjustment
-      refMBWords = mbSize = 1; // neutral settings that keep the standard behavior
-    }
-    else { // optimizer is configured to auto-adjust hyper-parameters
-      ABORT_IF(mbSize == mbSizeNotProvided, "Using rational optimizer auto-adjustment with trainer that does not provide MB size");
-      // note: this behavior is only meaningful if using the ce-sum criterion
-    }
-
-    updateImpl(params, grads, mbSize, refMBWords);
-  }
+  // Number of threads for the update of a shard on the CPU, for optimizers with a fused update
+  void setUpdateThreads(size_t threads) { updateThreads_ = std::max((size_t)1, threads); }
 
   virtual void init(TrainingState& state) override {
     eta_ = state.eta;
@@ -88,17 +85,54 @@ public:
   typedef std::function<void(const std::vector<float>& /*data*/, const ScatterStateSetFunc& /*setFn*/)> ScatterStateFunc;
   typedef std::function<std::vector<float>(const GatherStateGetFunc& /*getFn*/)> GatherStateFunc;
 
-  virtual void load(const std::string& /*name*/,
-                    const std::vector<Ptr<OptimizerBase>>& /*opts*/,
-                    const std::vector<Ptr<Backend>>& /*backends*/,
-                    const ScatterStateFunc& /*scatterFn*/) {}
-  virtual void save(const std::string& /*name*/,
-                    const std::vector<Ptr<OptimizerBase>>& /*opts*/,
-                    const GatherStateFunc& /*gatherFn*/,
-                    bool /*isMainProcess*/ = true) {}
+  // Distribute optimizer state read from items (see getStateItems()) over the shards.
+  virtual void setStateItems(const std::vector<io::Item>& /*items*/,
+                             const std::vector<Ptr<OptimizerBase>>& /*opts*/,
+                             const std::vector<Ptr<Backend>>& /*backends*/,
+                             const ScatterStateFunc& /*scatterFn*/) {}
+
+  void load(const std::string& name,
+            const std::vector<Ptr<OptimizerBase>>& opts,
+            const std::vector<Ptr<Backend>>& backends,
+            const ScatterStateFunc& scatterFn) {
+    if(!filesystem::exists(name))
+      return;
+    LOG(info, "Loading optimizer parameters from {}", name);
+    setStateItems(io::loadItems(name), opts, backends, scatterFn);
+  }
+
+  // Fetch the optimizer state from all shards into CPU-side items, e.g. to write them
+  // later from a background thread. All processes need to call this, but only the main
+  // process receives the items.
+  virtual std::vector<io::Item> getStateItems(const std::vector<Ptr<OptimizerBase>>& /*opts*/,
+                                              const GatherStateFunc& /*gatherFn*/,
+                                              bool /*isMainProcess*/ = true) {
+    return {};
+  }
+
+  void save(const std::string& name,
+            const std::vector<Ptr<OptimizerBase>>& opts,
+            const GatherStateFunc& gatherFn,
+            bool isMainProcess = true) {
+    auto items = getStateItems(opts, gatherFn, isMainProcess);
+    if(isMainProcess && !items.empty()) {
+      LOG(info, "Saving optimizer parameters to {}", name);
+      io::saveItems(name, items);
+    }
+  }
 
 protected:
   virtual void updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_t refMBWords) = 0;
+  // Clipping, update and smoothing in one pass; returns false if not supported for these tensors,
+  // then update() performs them separately
+  virtual bool updateFusedImpl(Tensor /*params*/,
+                               Tensor /*grads*/,
+                               Tensor /*paramsAvg*/,
+                               float /*avgDecay*/,
+                               size_t /*actualMBSize*/,
+                               size_t /*refMBWords*/) {
+    return false;
+  }
   virtual void resetStats() = 0;
 
   // Learning rate
@@ -107,6 +141,8 @@ protected:
   size_t refMBWordsParam_{0}; // 0 means no adjustment
   // Clip gradient norm
   Ptr<ClipperBase> clipper_;
+  // Threads for the fused update on the CPU
+  size_t updateThreads_{1};
 };
 
 /**
@@ -134,14 +170,13 @@ public:
   Adagrad(float eta, size_t refMBWordsParam = 0, Ptr<ClipperBase> clipper = nullptr)
       : OptimizerBase(eta, refMBWordsParam, clipper) {}
 
-  void load(const std::string& name,
-            const std::vector<Ptr<OptimizerBase>>& opts,
-            const std::vector<Ptr<Backend>>& backends,
-            const ScatterStateFunc& scatterFn) override;
-  void save(const std::string& name,
-            const std::vector<Ptr<OptimizerBase>>& opts,
-            const GatherStateFunc& gatherFn,
-            bool /*isMainProcess*/ = true) override;
+  void setStateItems(const std::vector<io::Item>& items,
+                     const std::vector<Ptr<OptimizerBase>>& opts,
+                     const std::vector<Ptr<Backend>>& backends,
+                     const ScatterStateFunc& scatterFn) override;
+  std::vector<io::Item> getStateItems(const std::vector<Ptr<OptimizerBase>>& opts,
+                                      const GatherStateFunc& gatherFn,
+                                      bool /*isMainProcess*/ = true) override;
 
   void setParams(const std::vector<float>& params) override {
     if(params.size() > 0)
@@ -169,17 +204,23 @@ public:
   Adam(float eta, size_t refMBWordsParam = 0, Ptr<ClipperBase> clipper = nullptr)
       : OptimizerBase(eta, refMBWordsParam, clipper) {}
 
-  void load(const std::string& name,
-            const std::vector<Ptr<OptimizerBase>>& opts,
-            const std::vector<Ptr<Backend>>& backends,
-            const ScatterStateFunc& scatterFn) override;
-  void save(const std::string& name,
-            const std::vector<Ptr<OptimizerBase>>& opts,
-            const GatherStateFunc& gatherFn,
-            bool isMainProcess = true) override;
+  void setStateItems(const std::vector<io::Item>& items,
+                     const std::vector<Ptr<OptimizerBase>>& opts,
+                     const std::vector<Ptr<Backend>>& backends,
+                     const ScatterStateFunc& scatterFn) override;
+  std::vector<io::Item> getStateItems(const std::vector<Ptr<OptimizerBase>>& opts,
+                                      const GatherStateFunc& gatherFn,
+                                      bool isMainProcess = true) override;
 
 private:
   void updateImpl(Tensor params, Tensor grads, size_t actualMBSize, size_t refMBWords) override;
+  bool updateFusedImpl(Tensor params,
+                       Tensor grads,
+                       Tensor paramsAvg,
+                       float avgDecay,
+                       size_t actualMBSize,
+                       size_t refMBWords) override;
+  void lazyAllocate(Tensor params);
   void resetStats() override;
 
   // Adam parameters:
@@ -2,6 +2,9 @@
 
 #include <cstdint>
 #include <deque>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <set>
 #include <unordered_map>
@@ -87,8 +90,28 @@ private:
 
   bool throw_{false};
 
-  std::set<Gap> gaps_;
+  std::set<Gap> gaps_;                      // by size, for best-fit search
+  std::map<uint8_t*, size_t> gapsByAddress_; // same gaps by address, for coalescing with neighbours
   std::unordered_map<uint8_t*, MemoryPiece::PtrType> allocated_;
+  std::unordered_map<MemoryPiece*, MemoryPiece::PtrType> views_; // pieces inside allocations, see view()
+
+  // Freed small pieces are kept in free lists per size class, i.e. multiple of the alignment, and
+  // handed out again without searching and coalescing gaps. They are returned to the gaps before
+  // the allocator would grow or throw.
+  static const size_t SIZE_CLASSES = 16;
+  std::vector<std::vector<uint8_t*>> freeLists_ = std::vector<std::vector<uint8_t*>>(SIZE_CLASSES + 1);
+  size_t cachedBytes_{0};
+
+  // Trace of allocations and frees, see recordTrace(). Pieces are identified by their offset,
+  // which does not change when the allocator grows.
+  UPtr<std::ofstream> trace_;
+  std::unordered_map<size_t, size_t> traceIds_; // offset -> id of the allocation in the trace
+  size_t nextTraceId_{0};
+
+  size_t sizeClass(size_t alignedBytes) const {
+    size_t c = alignedBytes / alignment_;
+    return c <= SIZE_CLASSES ? c : 0; // 0: not a small piece
+  }
 
   void grow(size_t add) {
     add = alignedSize(add);
@@ -97,26 +120,54 @@ private:
 
     device_->reserve(oldSize + add);
 
+    auto rebase = [&](uint8_t* ptr) { return device_->data() + std::distance(oldData, ptr); };
+
     std::set<Gap> oldGaps;
     gaps_.swap(oldGaps);
-
+    gapsByAddress_.clear();
+    available_ = 0;
     for(auto gap : oldGaps)
-      gaps_.insert(Gap(device_->data() + std::distance(oldData, gap.data()),
-                       gap.size()));
+      insertGap(Gap(rebase(gap.data()), gap.size()), false);
     insertGap(Gap(device_->data() + oldSize, add));
 
+    for(auto& freeList : freeLists_)
+      for(auto& ptr : freeList)
+        ptr = rebase(ptr);
+    available_ += cachedBytes_;
+
     std::unordered_map<uint8_t*, MemoryPiece::PtrType> oldAllocated;
     allocated_.swap(oldAllocated);
     for(auto it : oldAllocated) {
-      uint8_t* newPtr = device_->data() + std::distance(oldData, it.first);
+      uint8_t* newPtr = rebase(it.first);
       allocated_[newPtr] = oldAllocated[it.first];
       allocated_[newPtr]->setPtr(newPtr);
     }
+
+    for(auto it : views_)
+      it.second->setPtr(rebase(it.second->data()));
+  }
+
+  // return all cached small pieces to the gaps, coalescing them with their neighbours
+  void flushFreeLists() {
+    if(cachedBytes_ == 0)
+      return;
+    available_ -= cachedBytes_;
+    cachedBytes_ = 0;
+    for(size_t c = 1; c <= SIZE_CLASSES; ++c) {
+      for(auto ptr : freeLists_[c])
+        insertGap(Gap(ptr, c * alignment_));
+      freeLists_[c].clear();
+    }
   }
 
   Gap getGap(size_t size) {
     size = alignedSize(size);
-    auto it = std::lower_bound(gaps_.begin(), gaps_.end(), Gap(nullptr, size));
+    auto it = gaps_.lower_bound(Gap(nullptr, size));
+
+    if(it == gaps_.end()) {
+      flushFreeLists();
+      it = gaps_.lower_bound(Gap(nullptr, size));
+    }
 
     if(throw_ && it == gaps_.end()) {
       //ABORT("Trying to allocate {}, but only {} available.", available_, size);
@@ -126,32 +177,51 @@ private:
     // @TODO: compact memory before re-allocation attempt, maybe by left shifting memory over currently largest gap
     while(it == gaps_.end()) {
       grow(step_);
-      it = std::lower_bound(gaps_.begin(), gaps_.end(), Gap(nullptr, size));
+      it = gaps_.lower_bound(Gap(nullptr, size));
     }
 
     Gap gap = *it;
     gaps_.erase(it);
+    gapsByAddress_.erase(gap.data());
 
     available_ -= gap.size();
     return gap;
   }
 
+  void traceFree(size_t offset) {
+    auto it = traceIds_.find(offset);
+    if(it != traceIds_.end()) {
+      *trace_ << "f " << it->second << "\n";
+      traceIds_.erase(it);
+    }
+  }
+
+  void eraseGap(std::map<uint8_t*, size_t>::iterator it) {
+    gaps_.erase(Gap(it->first, it->second));
+    gapsByAddress_.erase(it);
+  }
+
   void insertGap(Gap gap, bool consolidate = true) {
+    if(gap.size() == 0)
+      return;
     available_ += gap.size();
     if(consolidate) {
-      auto it = gaps_.begin();
-      std::vector<decltype(it)> adjacent;
-      while(it != gaps_.end()) {
-        if(gap.adjacent(*it)) {
-          gap = gap.combine(*it);
-          adjacent.push_back(it);
+      // gaps are disjoint and fully coalesced, so only the direct neighbours can be adjacent
+      auto next = gapsByAddress_.lower_bound(gap.data());
+      if(next != gapsByAddress_.end() && gap.data() + gap.size() == next->first) {
+        gap = Gap(gap.data(), gap.size() + next->second);
+        eraseGap(next++);
+      }
+      if(next != gapsByAddress_.begin()) {
+        auto prev = std::prev(next);
+        if(prev->first + prev->second == gap.data()) {
+          gap = Gap(prev->first, prev->second + gap.size());
+          eraseGap(prev);
         }
-        it++;
       }
-      for(auto&& a : adjacent)
-        gaps_.erase(a);
     }
     gaps_.insert(gap);
+    gapsByAddress_[gap.data()] = gap.size();
   }
 
 public:
@@ -181,6 +251,14 @@ public:
 
   void throwAtReallocation(bool throwRealloc) { throw_ = throwRealloc; }
 
+  // Write every allocation and free to a file, one event per line, "a <id> <bytes>" or "f <id>",
+  // e.g. to replay the allocations of a real decoder with test_allocator. Pieces still allocated
+  // when the allocator is cleared are written as freed.
+  void recordTrace(const std::string& fileName) {
+    trace_.reset(new std::ofstream(fileName));
+    ABORT_IF(!*trace_, "Cannot write allocation trace {}", fileName);
+  }
+
   void reserve(size_t bytes) {
     bytes = alignedSize(bytes);
     if(bytes > 0)
@@ -200,13 +278,27 @@ public:
 
   MemoryPiece::PtrType alloc(size_t bytes) {
     bytes = alignedSize(bytes);
-    Gap gap = getGap(bytes);
 
-    if(gap.size() > bytes) {
-      insertGap(gap.rest(bytes), false);
+    uint8_t* ptr;
+    size_t c = sizeClass(bytes);
+    if(c > 0 && !freeLists_[c].empty()) {
+      ptr = freeLists_[c].back();
+      freeLists_[c].pop_back();
+      cachedBytes_ -= bytes;
+      available_ -= bytes;
+    } else {
+      Gap gap = getGap(bytes);
+      if(gap.size() > bytes) {
+        insertGap(gap.rest(bytes), false);
+      }
+      ptr = gap.data();
+    }
+
+    if(trace_) {
+      traceIds_[ptr - device_->data()] = nextTraceId_;
+      *trace_ << "a " << nextTraceId_++ << " " << bytes << "\n";
     }
 
-    auto ptr = gap.data();
     auto mp = MemoryPiece::New(ptr, bytes);
     allocated_[ptr] = mp;
     return mp;
@@ -222,8 +314,17 @@ public:
 
     auto it = allocated_.find(ptr);
     if(it != allocated_.end()) {
-      allocated_.erase(ptr);
-      insertGap(Gap(ptr, bytes), true);
+      allocated_.erase(it);
+      if(trace_)
+        traceFree(ptr - device_->data());
+      size_t c = sizeClass(bytes);
+      if(c > 0) {
+        freeLists_[c].push_back(ptr);
+        cachedBytes_ += bytes;
+        available_ += bytes;
+      } else {
+        insertGap(Gap(ptr, bytes), true);
+      }
       return true;
     }
     return false;
@@ -237,10 +338,34 @@ public:
     return false;
   }
 
+  // A piece of memory inside an allocation, e.g. a tensor placed by a memory plan. Like allocated
+  // memory it is moved when the allocator grows. Release it with freeView() before freeing the
+  // allocation that contains it.
+  MemoryPiece::PtrType view(uint8_t* ptr, size_t bytes) {
+    auto mp = MemoryPiece::New(ptr, bytes);
+    views_[mp.get()] = mp;
+    return mp;
+  }
+
+  void freeView(MemoryPiece::PtrType mp) {
+    views_.erase(mp.get());
+    mp->set(nullptr, 0);
+  }
+
   void clear() {
+    if(trace_) {
+      for(const auto& kv : traceIds_)
+        *trace_ << "f " << kv.second << "\n";
+      traceIds_.clear();
+    }
     available_ = 0;
     gaps_.clear();
     allocated_.clear();
+    views_.clear();
+    gapsByAddress_.clear();
+    for(auto& freeList : freeLists_)
+      freeList.clear();
+    cachedBytes_ = 0;
     insertGap({device_->data(), device_->size()}, false);
   }
 
@@ -16,12 +16,39 @@
 #include <mkl.h>
 #endif
 
+#include <cstring>
+#include <thread>
+
 namespace marian {
 
 namespace cpu {
 
-  void IsNaN(const Tensor /*in*/, Ptr<Allocator> /*allocator*/, bool& /*isNaN*/, bool& /*isInf*/) {
-  ABORT("Not implemented");
+// tests the bits, since std::isnan and std::isinf may be optimized away with -ffinite-math-only
+template <typename T>
+static void IsNaNImpl(const T* in, size_t length, bool& isNaN, bool& isInf) {
+  for(size_t i = 0; i < length; ++i) {
+    float value = (float)in[i];
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if((bits & 0x7f800000u) == 0x7f800000u) { // exponent all ones
+      if(bits & 0x007fffffu)
+        isNaN = true;
+      else
+        isInf = true;
+    }
+  }
+}
+
+void IsNaN(const Tensor in, Ptr<Allocator> /*allocator*/, bool& isNaN, bool& isInf) {
+  isNaN = false;
+  isInf = false;
+  if(in->type() == Type::float32) {
+    IsNaNImpl(in->data<float>(), in->size(), isNaN, isInf);
+  } else if(in->type() == Type::float16) {
+    IsNaNImpl(in->data<float16>(), in->size(), isNaN, isInf);
+  } else {
+    ABORT("IsNaN for type {} not implemented", in->type());
+  }
 }
 
 template <typename To, typename From>
@@ -939,6 +966,63 @@ float L2Norm(Tensor in, Ptr<Allocator> /*not used*/) {
   return std::sqrt(sum);
 }
 
+template <bool smoothing>
+static void AdamUpdateImpl(float* params,
+                           float* mt,
+                           float* vt,
+                           float* paramsAvg,
+                           const float* grads,
+                           int length,
+                           const AdamUpdateParams p) { // (a copy cannot alias the arrays)
+  float clip = p.gradClip > 0.f ? p.gradClip : std::numeric_limits<float>::max();
+  for(int i = 0; i < length; ++i) {
+    float g = std::max(-clip, std::min(clip, p.gradScale * grads[i]));
+    float m = p.beta1 * mt[i] + p.gradNorm1 * g;
+    float v = p.beta2 * vt[i] + p.gradNorm2 * (g * g);
+    float x = params[i];
+    x -= p.eta * ((m / p.denom1) / (std::sqrt(v / p.denom2) + p.eps) + p.decay * x);
+    mt[i] = m;
+    vt[i] = v;
+    params[i] = x;
+    if(smoothing)
+      paramsAvg[i] = (1.f - p.avgDecay) * paramsAvg[i] + p.avgDecay * x;
+  }
+}
+
+void AdamUpdate(Tensor params,
+                Tensor mt,
+                Tensor vt,
+                Tensor paramsAvg,
+                const Tensor grads,
+                const AdamUpdateParams& p) {
+  ABORT_IF(params->type() != Type::float32, "AdamUpdate not implemented for type {}", params->type());
+  int length = (int)params->size();
+  float* avg = paramsAvg ? paramsAvg->data() : nullptr;
+  auto update = [&](int begin, int end) {
+    if(avg)
+      AdamUpdateImpl<true>(params->data() + begin, mt->data() + begin, vt->data() + begin, avg + begin,
+                           grads->data() + begin, end - begin, p);
+    else
+      AdamUpdateImpl<false>(params->data() + begin, mt->data() + begin, vt->data() + begin, nullptr,
+                            grads->data() + begin, end - begin, p);
+  };
+
+  // parts of at least 1 MB per array, otherwise starting the threads costs more than they save
+  const int minPart = 1 << 18;
+  int threads = (int)std::max((size_t)1, std::min(p.threads, (size_t)(length / minPart)));
+  if(threads == 1) {
+    update(0, length);
+    return;
+  }
+  int part = (length / threads + 15) / 16 * 16; // whole cache lines
+  std::vector<std::thread> workers;
+  for(int t = 1; t < threads; ++t)
+    workers.emplace_back(update, std::min(length, t * part), std::min(length, (t + 1) * part));
+  update(0, std::min(length, part));
+  for(auto& worker : workers)
+    worker.join();
+}
+
 void Att(Tensor out_, Tensor va_, Tensor context_, Tensor state_) {
   float* out = out_->data();
   const float* va = va_->data();
@@ -2,6 +2,7 @@
 
 #include "functional/array.h"
 #include "functional/functional.h"
+#include "functional/program.h"
 #include "functional/tensor.h"
 #include "functional/tmp.h"
 
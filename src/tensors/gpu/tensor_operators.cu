@@ -1705,6 +1705,53 @@ float L2Norm(Tensor in, Ptr<Allocator> allocator) { // @TODO: reverse order of a
   return l2Norm;
 }
 
+template <bool smoothing>
+__global__ void gAdamUpdate(float* params,
+                            float* mt,
+                            float* vt,
+                            float* paramsAvg,
+                            const float* grads,
+                            int length,
+                            AdamUpdateParams p) {
+  float clip = p.gradClip > 0.f ? p.gradClip : CUDA_FLT_MAX;
+  for(int bid = 0; bid < length; bid += blockDim.x * gridDim.x) {
+    int index = bid + blockDim.x * blockIdx.x + threadIdx.x;
+    if(index < length) {
+      float g = fmaxf(-clip, fminf(clip, p.gradScale * grads[index]));
+      float m = p.beta1 * mt[index] + p.gradNorm1 * g;
+      float v = p.beta2 * vt[index] + p.gradNorm2 * (g * g);
+      float x = params[index];
+      x -= p.eta * ((m / p.denom1) / (sqrtf(v / p.denom2) + p.eps) + p.decay * x);
+      mt[index] = m;
+      vt[index] = v;
+      params[index] = x;
+      if(smoothing)
+        paramsAvg[index] = (1.f - p.avgDecay) * paramsAvg[index] + p.avgDecay * x;
+    }
+  }
+}
+
+void AdamUpdate(Tensor params,
+                Tensor mt,
+                Tensor vt,
+                Tensor paramsAvg,
+                const Tensor grads,
+                const AdamUpdateParams& p) {
+  ABORT_IF(params->type() != Type::float32, "AdamUpdate not implemented for type {}", params->type());
+  cudaSetDevice(params->getDeviceId().no);
+
+  int length = params->shape().elements();
+  int threads = std::min(MAX_THREADS, length);
+  int blocks = std::min(MAX_BLOCKS, length / threads + (length % threads != 0));
+
+  if(paramsAvg)
+    gAdamUpdate<true><<<blocks, threads>>>(
+        params->data(), mt->data(), vt->data(), paramsAvg->data(), grads->data(), length, p);
+  else
+    gAdamUpdate<false><<<blocks, threads>>>(
+        params->data(), mt->data(), vt->data(), nullptr, grads->data(), length, p);
+}
+
 template <typename T, typename AccType = float>
 __global__ void gAtt(T* out,
                      const T* va,
@@ -34,6 +34,8 @@ public:
     allocator_->throwAtReallocation(throwRealloc);
   }
 
+  void recordTrace(const std::string& fileName) { allocator_->recordTrace(fileName); }
+
   void reserve(size_t bytes = 0) {
     auto mult = bytes / GROW + 1;
     LOG(info,
@@ -82,6 +84,21 @@ public:
 
   void free(const Tensor& t) { allocator_->free(t->memory()); }
 
+  // place a tensor at an offset into a previously allocated piece of memory
+  void allocateView(/*out*/ Tensor& t,
+                    MemoryPiece::PtrType within,
+                    size_t offset,
+                    Shape shape,
+                    Type type = Type::float32) {
+    auto mem = allocator_->view(within->data() + offset, requiredBytes(shape, type));
+    t = Tensor(TensorBase::New(mem, shape, type, backend_));
+  }
+
+  void freeView(const Tensor& t) { allocator_->freeView(t->memory()); }
+
+  MemoryPiece::PtrType allocateBytes(size_t bytes) { return allocator_->alloc(bytes); }
+  void freeBytes(MemoryPiece::PtrType mp) { allocator_->free(mp); }
+
   Tensor asTensor(Type type = Type::float32) {
     auto mem = allocator_->memory();
     auto size = mem->size() / sizeOf(type);
@@ -328,6 +328,27 @@ static inline float L2Norm(marian::Tensor in, Ptr<Allocator> allocator) {
     return cpu::L2Norm(in, allocator);
 }
 
+// Hyper-parameters of a fused Adam update step, see AdamUpdate()
+struct AdamUpdateParams {
+  float gradScale{1.f};  // multiply gradients by this factor first (e.g. for norm clipping)
+  float gradClip{0.f};   // then clip them elementwise to [-gradClip, gradClip] (0 means no clipping)
+  float beta1, beta2;    // decay of the first and second moment estimates
+  float gradNorm1;       // weight of the gradient in the first moment, i.e. (1 - beta1) / T
+  float gradNorm2;       // weight of the squared gradient in the second moment, i.e. (1 - beta2) / T^2
+  float eta;             // learning rate
+  float denom1, denom2;  // bias correction of the moment estimates
+  float eps;
+  float decay;           // weight decay (AdamW)
+  float avgDecay{0.f};   // exponential smoothing: avg = (1 - avgDecay) * avg + avgDecay * params
+  size_t threads{1};     // CPU only: number of threads that update parts of the shard
+};
+
+// Single pass over the parameter shard that reads grads, params, mt, vt (and paramsAvg) once and
+// writes params, mt, vt (and paramsAvg) once. This is equivalent to gradient clipping, the
+// Element() updates in Adam::updateImpl and ExponentialSmoothing::updateAvgParams in sequence.
+// paramsAvg may be nullptr, then no smoothing is performed.
+DISPATCH6(AdamUpdate, marian::Tensor, marian::Tensor, marian::Tensor, marian::Tensor, const marian::Tensor, const AdamUpdateParams&)
+
 // clang-format off
 DISPATCH5(PoolingWithMaskingForward, marian::Tensor, marian::Tensor, marian::Tensor, int, bool)
 DISPATCH6(PoolingWithMaskingBackward, marian::Tensor, marian::Tensor, marian::Tensor, marian::Tensor, int, bool)
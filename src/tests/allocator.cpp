@@ -0,0 +1,122 @@
+#include "marian.h"
+#include "common/timer.h"
+#include "tensors/allocator.h"
+
+#include <fstream>
+#include <random>
+
+// Benchmark for the device Allocator: replays an allocation trace of decoder steps and reports the
+// time per allocation or free. The trace is read from a file with one event per line,
+// "a <id> <bytes>" or "f <id>", or generated to resemble a transformer decoder step with beam
+// search: per layer, many short-lived activations and small statistics tensors, some values that
+// live until the end of the layer, and states that are freed during the next step. A trace of a
+// real model is written by running e.g. marian-decoder with MARIAN_ALLOCATOR_TRACE=<prefix>, one
+// file <prefix>.<n> per expression graph.
+// Usage: test_allocator [iterations] [trace-file]
+
+using namespace marian;
+
+struct Event {
+  bool alloc;
+  size_t id;
+  size_t bytes;
+};
+
+static std::vector<Event> readTrace(const std::string& fileName) {
+  std::ifstream in(fileName);
+  ABORT_IF(!in, "Cannot read trace {}", fileName);
+  std::vector<Event> trace;
+  std::string op;
+  size_t id, bytes = 0;
+  while(in >> op >> id) {
+    if(op == "a")
+      in >> bytes;
+    trace.push_back({op == "a", id, op == "a" ? bytes : 0});
+  }
+  return trace;
+}
+
+static std::vector<Event> decoderTrace(size_t steps) {
+  const size_t rows = 64, dim = 512, heads = 8, srcLen = 40, layers = 6, vocab = 32000;
+  std::mt19937 rng(1234);
+  std::vector<Event> trace;
+  size_t nextId = 0;
+  auto alloc = [&](size_t bytes) {
+    trace.push_back({true, nextId, bytes});
+    return nextId++;
+  };
+  auto release = [&](size_t id) { trace.push_back({false, id, 0}); };
+
+  std::vector<size_t> states; // per-layer decoder states kept until the next step
+  for(size_t step = 0; step < steps; ++step) {
+    std::vector<size_t> newStates;
+    size_t x = alloc(rows * dim * 4);
+    for(size_t l = 0; l < layers; ++l) {
+      std::vector<size_t> layerValues; // e.g. residuals, freed at the end of the layer
+      for(size_t op = 0; op < 24; ++op) {
+        // layer normalization statistics, biases, broadcast scalars
+        std::vector<size_t> small;
+        size_t numSmall = 1 + rng() % 3;
+        for(size_t k = 0; k < numSmall; ++k)
+          small.push_back(alloc((1 + rng() % 16) * 256));
+        size_t out = op % 6 == 3 ? alloc(rows * heads * (srcLen + step) * 4) : alloc(rows * dim * 4);
+        for(auto id : small)
+          release(id);
+        if(op % 4 == 0)
+          layerValues.push_back(x);
+        else
+          release(x);
+        x = out;
+      }
+      for(auto id : layerValues)
+        release(id);
+      newStates.push_back(alloc(rows * (step + 1) * dim * 4));
+    }
+    size_t logits = alloc(rows * vocab * 4);
+    release(x);
+    release(logits);
+    for(auto id : states)
+      release(id);
+    states = newStates;
+  }
+  for(auto id : states)
+    release(id);
+  return trace;
+}
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? std::stoi(argv[1]) : 20;
+  auto trace = argc > 2 ? readTrace(argv[2]) : decoderTrace(/*steps=*/20);
+
+  size_t numAllocs = 0, maxId = 0;
+  for(const auto& e : trace) {
+    numAllocs += e.alloc;
+    maxId = std::max(maxId, e.id);
+  }
+
+  Allocator allocator({0, DeviceType::cpu}, 256 * 1024 * 1024, 128 * 1024 * 1024);
+  std::vector<MemoryPiece::PtrType> pieces(maxId + 1);
+
+  double seconds = 0;
+  for(int it = 0; it < iterations + 1; ++it) { // the first replay may grow the allocator and is not timed
+    timer::Timer timer;
+    for(const auto& e : trace) {
+      if(e.alloc) {
+        pieces[e.id] = allocator.alloc(e.bytes);
+      } else {
+        allocator.free(pieces[e.id]);
+        pieces[e.id] = nullptr;
+      }
+    }
+    if(it > 0)
+      seconds += timer.elapsed();
+    allocator.clear();
+  }
+
+  std::cerr << trace.size() << " events (" << numAllocs << " allocations) per replay, "
+            << seconds / iterations * 1000 << " ms per replay, "
+            << seconds / iterations / trace.size() * 1e9 << " ns per event, reserved "
+            << allocator.size() / (1024 * 1024) << " MB" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include "marian.h"
+#include "common/config.h"
+#include "common/file_stream.h"
+#include "common/timer.h"
+#include "data/batch_generator.h"
+#include "data/corpus.h"
+#include "models/model_factory.h"
+#include "translator/beam_search.h"
+#include "translator/scorers.h"
+
+#include <cstdio>
+#include <iomanip>
+
+// Benchmark for BeamSearch::search with a tiny transformer on the CPU, for small batches where the
+// bookkeeping of the search is a noticeable part of a step: the time per batch with a BeamSearch
+// constructed for each batch, as the translator did before, and with one BeamSearch reused for all
+// batches of a thread. The model is randomly initialized and saved to a temporary file first, so
+// the translations run to the maximum length. Also checks that both give the same translations.
+// Usage: test_beam_search [dim-emb [beam-size [passes]]]
+
+using namespace marian;
+
+static Ptr<Options> parse(std::vector<std::string> args, cli::mode mode) {
+  args.insert(args.begin(), "marian");
+  std::vector<char*> argv;
+  for(auto& arg : args)
+    argv.push_back(&arg[0]);
+  return parseOptions((int)argv.size(), argv.data(), mode, /*validate=*/false);
+}
+
+int main(int argc, char** argv) {
+  std::string dimEmb = argc > 1 ? argv[1] : "64";
+  std::string beamSize = argc > 2 ? argv[2] : "4";
+  size_t passes = argc > 3 ? std::stoul(argv[3]) : 5;
+
+  io::TemporaryFile vocabFile("/tmp", /*earlyUnlink=*/false);
+  vocabFile << "</s>\n<unk>\n";
+  for(size_t w = 0; w < 100; ++w)
+    vocabFile << "w" << w << "\n";
+  vocabFile.flush();
+  io::TemporaryFile srcFile("/tmp", /*earlyUnlink=*/false);
+  for(size_t i = 0; i < 64; ++i) {
+    for(size_t k = 0; k < 5 + i % 11; ++k)
+      srcFile << (k ? " w" : "w") << (i * 7 + k * 13) % 100;
+    srcFile << "\n";
+  }
+  srcFile.flush();
+  std::string modelFile = srcFile.getFileName() + ".npz";
+
+  std::vector<std::string> modelArgs = {"--type", "transformer", "--dim-emb", dimEmb,
+      "--transformer-dim-ffn", std::to_string(4 * std::stoi(dimEmb)), "--transformer-heads", "4",
+      "--enc-depth", "2", "--dec-depth", "2", "--tied-embeddings-all",
+      "--vocabs", vocabFile.getFileName(), vocabFile.getFileName(), "--cpu-threads", "1", "--seed", "1234"};
+
+  { // random initialization
+    auto options = parse(modelArgs, cli::mode::training);
+    std::vector<Ptr<Vocab>> vocabs;
+    for(size_t i = 0; i < 2; ++i) {
+      vocabs.push_back(New<Vocab>(options, i));
+      vocabs.back()->load(vocabFile.getFileName());
+    }
+    auto graph = New<ExpressionGraph>();
+    graph->setDevice({0, DeviceType::cpu});
+    graph->reserveWorkspaceMB(128);
+    auto model = models::createModelFromOptions(options, models::usage::raw);
+    model->build(graph, data::CorpusBatch::fakeBatch({8, 8}, vocabs, 2, options));
+    graph->forward();
+    model->save(graph, modelFile, /*saveTranslatorConfig=*/true);
+  }
+
+  auto translate = [&](const std::string& miniBatch) {
+    auto args = modelArgs;
+    args.insert(args.end(), {"--models", modelFile, "--input", srcFile.getFileName(), "--beam-size", beamSize,
+                             "--mini-batch", miniBatch, "--maxi-batch", "1", "--max-length-factor", "2", "--quiet"});
+    auto options = parse(args, cli::mode::translation);
+    options->set("inference", true, "shuffle", "none");
+    return options;
+  };
+
+  std::cerr << std::fixed << std::setprecision(2);
+  for(std::string miniBatch : {"1", "2", "4", "8"}) {
+    auto options = translate(miniBatch);
+    DecodeConfig config(options);
+    auto trgVocab = New<Vocab>(options, 1);
+    trgVocab->load(vocabFile.getFileName());
+
+    auto graph = New<ExpressionGraph>(/*inference=*/true);
+    graph->setDevice({0, DeviceType::cpu});
+    graph->reserveWorkspaceMB(128);
+    auto scorers = createScorers(options);
+    for(auto scorer : scorers)
+      scorer->init(graph);
+    graph->forward();
+
+    auto corpus = New<data::Corpus>(options, /*translate=*/true);
+    data::BatchGenerator<data::Corpus> batchGenerator(corpus, options);
+    batchGenerator.prepare();
+    std::vector<Ptr<data::CorpusBatch>> batches;
+    for(auto batch : batchGenerator)
+      batches.push_back(batch);
+
+    double seconds[2] = {0, 0};
+    std::vector<Words> outputs[2];
+    auto reused = New<BeamSearch>(config, scorers, trgVocab);
+    for(size_t pass = 0; pass < passes + 1; ++pass) { // the first pass is not timed
+      for(int reuse = 0; reuse < 2; ++reuse) {
+        outputs[reuse].clear();
+        timer::Timer timer;
+        for(auto batch : batches) {
+          auto search = reuse ? reused : New<BeamSearch>(config, scorers, trgVocab);
+          for(auto history : search->search(graph, batch))
+            outputs[reuse].push_back(std::get<0>(history->top()));
+        }
+        if(pass > 0)
+          seconds[reuse] += timer.elapsed();
+      }
+    }
+    ABORT_IF(outputs[0] != outputs[1], "Different translations with a reused BeamSearch");
+
+    std::cerr << "batch size " << std::setw(2) << miniBatch << ": " << seconds[0] / passes / batches.size() * 1000
+              << " ms per batch with a BeamSearch per batch, " << seconds[1] / passes / batches.size() * 1000
+              << " ms with a reused BeamSearch" << std::endl;
+  }
+
+  std::remove(modelFile.c_str());
+  return 0;
+}
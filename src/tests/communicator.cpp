@@ -0,0 +1,78 @@
+#include "marian.h"
+#include "common/timer.h"
+#include "training/communicator.h"
+
+// Benchmark for DefaultCommunicator, as used for multi-graph CPU training and GPUs without NCCL.
+// For 2 .. maxGraphs CPU graphs, times the reduce-scatter of the gradients and the all-gather of
+// the parameters and reports the bus bandwidth, i.e. size * (N-1)/N per second, which is
+// independent of the number of graphs for an optimal implementation. Also checks the results.
+// Usage: test_communicator [maxGraphs] [elements] [iterations]
+
+using namespace marian;
+
+int main(int argc, char** argv) {
+  size_t maxGraphs = argc > 1 ? std::stoul(argv[1]) : 8;
+  int elements = argc > 2 ? std::stoi(argv[2]) : (1 << 24);
+  int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+
+  double bytes = (double)elements * sizeof(float);
+  for(size_t numGraphs = 2; numGraphs <= maxGraphs; ++numGraphs) {
+    std::vector<Ptr<ExpressionGraph>> graphs;
+    for(size_t i = 0; i < numGraphs; ++i) {
+      auto graph = New<ExpressionGraph>();
+      graph->setDevice({i, DeviceType::cpu});
+      graph->reserveWorkspaceMB(16);
+      graph->param("p", {1, elements}, inits::zeros());
+      graph->forward();
+      graph->params()->allocateBackward();
+      graphs.push_back(graph);
+    }
+    auto comm = New<DefaultCommunicator>(graphs, nullptr);
+
+    double reduceSeconds = 0, gatherSeconds = 0;
+    for(int it = 0; it < iterations; ++it) {
+      for(size_t i = 0; i < numGraphs; ++i)
+        graphs[i]->params()->grads()->set((float)(i + 1));
+
+      timer::Timer reduceTimer;
+      comm->scatterReduceAndResetGrads();
+      reduceSeconds += reduceTimer.elapsed();
+
+      // every shard holds the sum of all gradients, everything else is zero
+      float expected = numGraphs * (numGraphs + 1) / 2.f;
+      comm->foreach([&](size_t idx, size_t begin, size_t end) {
+        std::vector<float> grads;
+        graphs[idx]->params()->grads()->get(grads);
+        for(size_t k = 0; k < grads.size(); ++k) {
+          float want = k >= begin && k < end ? expected : 0.f;
+          ABORT_IF(grads[k] != want, "Wrong reduced gradient {} at {} in graph {}, expected {}", grads[k], k, idx, want);
+        }
+      }, /*parallel=*/false);
+
+      comm->foreach([&](size_t idx, size_t begin, size_t end) {
+        graphs[idx]->params()->vals()->subtensor(begin, end - begin)->set((float)idx);
+      });
+
+      timer::Timer gatherTimer;
+      comm->allGatherParams();
+      gatherSeconds += gatherTimer.elapsed();
+
+      comm->foreach([&](size_t idx, size_t begin, size_t end) {
+        for(auto graph : graphs) {
+          std::vector<float> vals;
+          graph->params()->vals()->subtensor(begin, end - begin)->get(vals);
+          for(auto v : vals)
+            ABORT_IF(v != (float)idx, "Wrong gathered parameter {}, expected {}", v, idx);
+        }
+      }, /*parallel=*/false);
+    }
+
+    double busBytes = bytes * (numGraphs - 1) / numGraphs * iterations;
+    std::cerr << numGraphs << " graphs: reduce-scatter " << reduceSeconds / iterations * 1000 << " ms, "
+              << busBytes / reduceSeconds / 1e9 << " GB/s bus bandwidth; all-gather "
+              << gatherSeconds / iterations * 1000 << " ms, "
+              << busBytes / gatherSeconds / 1e9 << " GB/s bus bandwidth" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "marian.h"
+#include "common/file_stream.h"
+#include "common/timer.h"
+#include "data/corpus.h"
+#include "data/corpus_sqlite.h"
+
+#include <functional>
+#include <iomanip>
+#include <random>
+
+// Benchmark for data::CorpusSQLite against the text corpus data::Corpus on the same data: the
+// time to construct the corpus (for SQLite, the import into a temporary database), to shuffle it
+// and read it once, as done per epoch in training, and to read it once in original order. A
+// synthetic corpus of the given number of sentence pairs (default 200000) is generated in a
+// temporary directory.
+// Usage: test_corpus_sqlite [lines [tempdir]]
+
+using namespace marian;
+
+int main(int argc, char** argv) {
+  createLoggers();
+
+  size_t lines = argc > 1 ? std::stoul(argv[1]) : 200000;
+  std::string tempDir = argc > 2 ? argv[2] : "/tmp";
+
+  // synthetic corpus and vocabulary of words w0 ... w999
+  const size_t numWords = 1000;
+  io::TemporaryFile vocabFile(tempDir, /*earlyUnlink=*/false);
+  vocabFile << "</s>\n<unk>\n"; // text format, one word per line
+  for(size_t w = 0; w < numWords; ++w)
+    vocabFile << "w" << w << "\n";
+  vocabFile.flush();
+
+  std::vector<UPtr<io::TemporaryFile>> corpusFiles;
+  std::mt19937 rng(1234);
+  for(size_t stream = 0; stream < 2; ++stream) {
+    corpusFiles.emplace_back(new io::TemporaryFile(tempDir, /*earlyUnlink=*/false));
+    for(size_t i = 0; i < lines; ++i) {
+      size_t length = 5 + rng() % 40;
+      for(size_t j = 0; j < length; ++j)
+        *corpusFiles.back() << (j > 0 ? " w" : "w") << rng() % numWords;
+      *corpusFiles.back() << "\n";
+    }
+    corpusFiles.back()->flush();
+  }
+
+  auto options = New<Options>("max-length", (size_t)100,
+                              "max-length-crop", false,
+                              "right-left", false,
+                              "tempdir", tempDir,
+                              "sqlite", std::string("temporary"),
+                              "sqlite-drop", false,
+                              "seed", (size_t)1234);
+
+  std::vector<std::string> paths;
+  std::vector<Ptr<Vocab>> vocabs;
+  for(size_t stream = 0; stream < 2; ++stream) {
+    paths.push_back(corpusFiles[stream]->getFileName());
+    vocabs.push_back(New<Vocab>(options, stream));
+    vocabs.back()->load(vocabFile.getFileName());
+  }
+
+  auto readAll = [](Ptr<data::CorpusBase> corpus) {
+    size_t words = 0;
+    for(const auto& tuple : *corpus)
+      for(size_t stream = 0; stream < tuple.size(); ++stream)
+        words += tuple[stream].size();
+    return words;
+  };
+
+  // the same loop over both corpus types: construct, shuffle and read, reset and read
+  auto run = [&](const std::string& name, std::function<Ptr<data::CorpusBase>()> create) {
+    timer::Timer timer;
+    auto corpus = create();
+    double created = timer.elapsed();
+
+    timer.start();
+    corpus->shuffle();
+    size_t words = readAll(corpus);
+    double shuffled = timer.elapsed();
+
+    timer.start();
+    corpus->reset();
+    words += readAll(corpus);
+    double inOrder = timer.elapsed();
+
+    std::cerr << std::setw(6) << name << ": construction " << created << "s, shuffle and read "
+              << shuffled << "s, read in original order " << inOrder << "s (" << words << " words)" << std::endl;
+  };
+
+  std::cerr << std::fixed << std::setprecision(3) << lines << " sentence pairs" << std::endl;
+  run("text", [&]() { return New<data::Corpus>(paths, vocabs, options); });
+  run("sqlite", [&]() { return New<data::CorpusSQLite>(paths, vocabs, options); });
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "marian.h"
+#include "common/timer.h"
+#include "translator/decode_config.h"
+#include "translator/history.h"
+
+#include <iomanip>
+
+// Synthetic microbenchmark for the cost of looking up decoding options by name compared to reading
+// them from a DecodeConfig. It does not run BeamSearch or a model: the two loops below are simplified
+// copies of the bookkeeping in BeamSearch::search, once with the option lookups where the search used
+// to do them (per batch, per sentence and per time step) and once with a DecodeConfig resolved up
+// front. The times are per step of these loops only; in real decoding they add to the time of the
+// model and the beam search itself.
+// Usage: test_decode_config [beam-size [max-length-factor]]
+
+using namespace marian;
+
+static const size_t numBatches = 20000;
+static const size_t srcLength = 20;
+
+// mock of the previous behavior: the options are looked up where they are used
+static size_t searchWithOptions(Ptr<const Options> options, size_t dimBatch) {
+  size_t checks = 0;
+  for(size_t b = 0; b < numBatches; ++b) {
+    size_t beamSize = options->get<size_t>("beam-size"); // BeamSearch constructed per batch
+    auto arena = New<HypothesisArena>(options->get<bool>("n-best") ? 1 : 0);
+    std::vector<Ptr<History>> histories(dimBatch);
+    for(size_t i = 0; i < dimBatch; ++i)
+      histories[i] = New<History>(i, arena, options->get<float>("normalize"), options->get<float>("word-penalty"));
+    bool allowUnk = options->get<bool>("allow-unk", false);
+    for(size_t t = 0; ; ++t) {
+      bool alignment = options->hasAndNotEmpty("alignment"); // toHyps()
+      bool maxLengthReached = false;
+      for(size_t i = 0; i < dimBatch; ++i)
+        if(t >= options->get<float>("max-length-factor") * srcLength)
+          maxLengthReached = true;
+      checks += beamSize + allowUnk + alignment;
+      if(maxLengthReached)
+        break;
+    }
+  }
+  return checks;
+}
+
+// mock with the options resolved once
+static size_t searchWithConfig(const DecodeConfig& config, size_t dimBatch) {
+  size_t checks = 0;
+  for(size_t b = 0; b < numBatches; ++b) {
+    size_t beamSize = config.beamSize;
+    auto arena = New<HypothesisArena>(config.nBest ? 1 : 0);
+    std::vector<Ptr<History>> histories(dimBatch);
+    for(size_t i = 0; i < dimBatch; ++i)
+      histories[i] = New<History>(i, arena, config.normalize, config.wordPenalty);
+    bool allowUnk = config.allowUnk;
+    const float maxLength = config.maxLengthFactor * srcLength;
+    for(size_t t = 0; ; ++t) {
+      bool alignment = !config.alignment.empty();
+      bool maxLengthReached = false;
+      for(size_t i = 0; i < dimBatch; ++i)
+        if(t >= maxLength)
+          maxLengthReached = true;
+      checks += beamSize + allowUnk + alignment;
+      if(maxLengthReached)
+        break;
+    }
+  }
+  return checks;
+}
+
+int main(int argc, char** argv) {
+  createLoggers();
+
+  // the decoding options at their command-line defaults
+  auto options = New<Options>("beam-size", argc > 1 ? std::stoul(argv[1]) : (size_t)12,
+                              "normalize", 0.f,
+                              "word-penalty", 0.f,
+                              "max-length-factor", argc > 2 ? std::stof(argv[2]) : 3.f,
+                              "allow-unk", false,
+                              "n-best", false,
+                              "alignment", std::string(),
+                              "right-left", false,
+                              "word-scores", false);
+  size_t steps = (size_t)(options->get<float>("max-length-factor") * srcLength) + 1;
+
+  std::cerr << std::fixed << std::setprecision(1);
+  for(size_t dimBatch : {1, 2, 4, 8, 16}) {
+    timer::Timer timer;
+    size_t checks = searchWithOptions(options, dimBatch);
+    double before = timer.elapsed();
+
+    timer.start();
+    DecodeConfig config(options);
+    checks -= searchWithConfig(config, dimBatch);
+    double after = timer.elapsed();
+    ABORT_IF(checks != 0, "Different decoding decisions??");
+
+    double perStep = 1e9 / (numBatches * steps);
+    std::cerr << "synthetic loop, batch size " << std::setw(2) << dimBatch << ": " << before * perStep
+              << " ns per step with Options, " << after * perStep << " ns per step with DecodeConfig" << std::endl;
+  }
+  return 0;
+}
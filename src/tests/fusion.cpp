@@ -0,0 +1,64 @@
+#include "marian.h"
+#include "common/timer.h"
+
+#include <iomanip>
+
+// Benchmark for element-wise fusion (--fuse-elementwise) on the CPU: the time of inference forward
+// passes over a chain of element-wise operations, as after the affine transformations of a feed-
+// forward layer, with one kernel per operation and with one kernel per fused chain. The time
+// includes building the graph and the fusion itself, as in decoding, where the graph is rebuilt at
+// every step. Also checks that the values are the same.
+// Usage: test_fusion [dim [passes]]
+
+using namespace marian;
+
+static std::vector<float> pass(Ptr<ExpressionGraph> graph, const std::vector<float>& input, int rows, int dim) {
+  graph->clear();
+  auto x = graph->constant({rows, dim}, inits::fromVector(input));
+  auto b1 = graph->constant({1, dim}, inits::fromValue(0.1f));
+  auto b2 = graph->constant({1, dim}, inits::fromValue(-0.2f));
+  auto h = swish(x + b1) * 0.5f + x;
+  auto out = tanh(relu(h * x + b2) - sigmoid(x)) * 2.f + h;
+  graph->forward();
+  std::vector<float> values;
+  out->val()->get(values);
+  return values;
+}
+
+int main(int argc, char** argv) {
+  createLoggers();
+
+  int dim = argc > 1 ? std::stoi(argv[1]) : 512;
+  size_t passes = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+  std::cerr << std::fixed << std::setprecision(1);
+  for(int rows : {1, 8, 64, 512}) {
+    std::vector<float> input((size_t)rows * dim);
+    for(size_t i = 0; i < input.size(); ++i)
+      input[i] = (float)(i % 101) / 50.f - 1.f;
+
+    double seconds[2];
+    std::vector<float> values[2];
+    for(int fusion = 0; fusion < 2; ++fusion) {
+      auto graph = New<ExpressionGraph>(/*inference=*/true);
+      graph->setDevice({0, DeviceType::cpu});
+      graph->reserveWorkspaceMB(64);
+      graph->setElementwiseFusion(fusion == 1);
+      values[fusion] = pass(graph, input, rows, dim); // warm-up
+
+      timer::Timer timer;
+      for(size_t p = 0; p < passes; ++p)
+        pass(graph, input, rows, dim);
+      seconds[fusion] = timer.elapsed();
+    }
+
+    for(size_t i = 0; i < values[0].size(); ++i)
+      ABORT_IF(std::abs(values[0][i] - values[1][i]) > 1e-5f * (1.f + std::abs(values[0][i])),
+               "Different values {} and {} at {}", values[0][i], values[1][i], i);
+
+    std::cerr << std::setw(4) << rows << " x " << dim << ": " << seconds[0] / passes * 1e6
+              << " us per pass without fusion, " << seconds[1] / passes * 1e6 << " us with fusion"
+              << std::endl;
+  }
+  return 0;
+}
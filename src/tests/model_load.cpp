@@ -0,0 +1,117 @@
+#include "marian.h"
+#include "3rd_party/cnpy/cnpy.h"
+#include "common/io.h"
+#include "common/timer.h"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+// Benchmark for loading models from .npz and .bin files: the time to read the items with the
+// previous single-threaded cnpy loader and with io::loadItems, and the time and peak memory to load
+// them into the parameters of a CPU graph. Without arguments, a model of transformer-like parameter
+// shapes with about size-MB of parameters is generated and saved in both formats first.
+// Usage: test_model_load [size-MB | model.npz model.bin]
+
+using namespace marian;
+
+static std::vector<io::Item> generateItems(size_t megabytes) {
+  const int dim = 512, ffn = 2048, vocab = 32000;
+  std::vector<std::pair<std::string, Shape>> layer = {
+      {"Wq", {dim, dim}}, {"Wk", {dim, dim}}, {"Wv", {dim, dim}}, {"Wo", {dim, dim}},
+      {"bq", {1, dim}},   {"bk", {1, dim}},   {"bv", {1, dim}},   {"bo", {1, dim}},
+      {"ffn_W1", {dim, ffn}}, {"ffn_b1", {1, ffn}}, {"ffn_W2", {ffn, dim}}, {"ffn_b2", {1, dim}},
+      {"ln_scale", {1, dim}}, {"ln_bias", {1, dim}}};
+
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+  auto add = [&](std::vector<io::Item>& items, const std::string& name, const Shape& shape) {
+    io::Item item;
+    item.name = name;
+    item.shape = shape;
+    item.type = Type::float32;
+    item.bytes.resize(shape.elements() * sizeof(float));
+    float* data = (float*)item.bytes.data();
+    for(int i = 0; i < shape.elements(); ++i)
+      data[i] = dist(rng);
+    items.push_back(std::move(item));
+    return shape.elements() * sizeof(float);
+  };
+
+  std::vector<io::Item> items;
+  size_t bytes = add(items, "Wemb", {vocab, dim});
+  for(int l = 1; bytes < megabytes * 1024 * 1024; ++l)
+    for(const auto& p : layer)
+      bytes += add(items, "encoder_l" + std::to_string(l) + "_" + p.first, p.second);
+  return items;
+}
+
+// resets and reads the peak resident set size in MB, 0 if not available
+static double peakMemoryMB(bool reset) {
+#ifdef __linux__
+  if(reset) {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    return 0;
+  }
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while(std::getline(status, line))
+    if(line.compare(0, 6, "VmHWM:") == 0)
+      return std::stod(line.substr(6)) / 1024;
+#else
+  (void)reset;
+#endif
+  return 0;
+}
+
+static void benchmark(const std::string& fileName) {
+  if(io::isNpz(fileName)) {
+    timer::Timer timer;
+    auto numpy = cnpy::npz_load(fileName);
+    std::cerr << fileName << ": cnpy::npz_load " << timer.elapsed() << "s" << std::endl;
+  }
+
+  timer::Timer timer;
+  auto items = io::loadItems(fileName);
+  std::cerr << fileName << ": io::loadItems " << timer.elapsed() << "s, " << items.size() << " items" << std::endl;
+  items.clear();
+  items.shrink_to_fit();
+
+  peakMemoryMB(/*reset=*/true);
+  double baseMB = peakMemoryMB(/*reset=*/false);
+  timer.start();
+  {
+    auto graph = New<ExpressionGraph>(/*inference=*/true);
+    graph->setDevice({0, DeviceType::cpu});
+    graph->load(fileName);
+    graph->forward(); // allocates and initializes the parameters
+    std::cerr << fileName << ": ExpressionGraph::load " << timer.elapsed() << "s, peak memory +"
+              << peakMemoryMB(/*reset=*/false) - baseMB << " MB for "
+              << graph->params()->vals()->memory()->size() / (1024 * 1024) << " MB of parameters" << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  createLoggers();
+
+  std::vector<std::string> files;
+  if(argc > 2) {
+    files = {argv[1], argv[2]};
+  } else {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 256;
+    auto items = generateItems(megabytes);
+    files = {"test_model_load.npz", "test_model_load.bin"};
+    for(const auto& file : files)
+      io::saveItems(file, items);
+  }
+
+  for(const auto& file : files)
+    benchmark(file);
+
+  if(argc <= 2)
+    for(const auto& file : files)
+      std::remove(file.c_str());
+
+  return 0;
+}
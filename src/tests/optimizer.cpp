@@ -0,0 +1,119 @@
+#include "marian.h"
+#include "common/timer.h"
+#include "optimizers/clippers.h"
+#include "optimizers/optimizers.h"
+
+#include <cmath>
+#include <random>
+#include <thread>
+
+// Microbenchmark for the optimizer update step on a parameter shard. Compares the separate
+// passes for norm clipping, the Adam moments, the parameter update and exponential smoothing
+// with Adam's fused single-pass update, and checks that both compute the same result.
+// Usage: test_optimizer [elements] [iterations] [gpu|threads]
+
+using namespace marian;
+
+static void unfusedUpdate(Tensor params, Tensor mt, Tensor vt, Tensor avg, Tensor grads,
+                          double& denom1, double& denom2, float clipNorm, float eta, float avgDecay) {
+  using namespace functional;
+  const double beta1 = 0.9, beta2 = 0.999;
+  const float eps = 1e-8f;
+
+  float l2Norm = L2Norm(grads, nullptr);
+  if(l2Norm >= clipNorm)
+    Element(_1 = (clipNorm / l2Norm) * _1, grads);
+
+  denom1 = (beta1 * denom1) + (1 - beta1);
+  denom2 = (beta2 * denom2) + (1 - beta2);
+  Element(_1 = ((float)beta1 * _1) + float(1 - beta1) * _2, mt, grads);
+  Element(_1 = ((float)beta2 * _1) + float(1 - beta2) * (_2 * _2), vt, grads);
+  float denom1f = (float)denom1, denom2f = (float)denom2;
+  Element(_1 -= eta * ((_2 / denom1f) / (sqrt(_3 / denom2f) + eps)), params, mt, vt);
+
+  Element(_1 = ((1.f - avgDecay) * _1) + (avgDecay * _2), avg, params);
+  params->getBackend()->synchronize();
+}
+
+int main(int argc, char** argv) {
+  int elements = argc > 1 ? std::stoi(argv[1]) : (1 << 24);
+  int iterations = argc > 2 ? std::stoi(argv[2]) : 10;
+  DeviceType deviceType = argc > 3 && std::string(argv[3]) == "gpu" ? DeviceType::gpu : DeviceType::cpu;
+  size_t threads = argc > 3 && deviceType == DeviceType::cpu ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+
+  const float clipNorm = 1.f, eta = 1e-4f, avgDecay = 1e-4f;
+
+  std::vector<float> initParams(elements), initGrads(elements);
+  std::mt19937 eng(1234);
+  std::normal_distribution<float> dist(0.f, 0.1f);
+  for(int i = 0; i < elements; ++i) {
+    initParams[i] = dist(eng);
+    initGrads[i] = dist(eng);
+  }
+
+  auto backend = BackendByDeviceId({0, deviceType}, 1234);
+  auto alloc = New<TensorAllocator>(backend);
+  alloc->reserveExact(9 * sizeof(float) * elements);
+
+  Tensor params, mt, vt, avg, grads; // reference
+  Tensor fusedParams, fusedAvg, fusedGrads, initGradsTensor;
+  for(Tensor* t : {&params, &mt, &vt, &avg, &grads, &fusedParams, &fusedAvg, &fusedGrads, &initGradsTensor})
+    alloc->allocate(*t, {1, elements});
+
+  params->set(initParams);
+  avg->set(initParams);
+  mt->set(0.f);
+  vt->set(0.f);
+  fusedParams->set(initParams);
+  fusedAvg->set(initParams);
+  initGradsTensor->set(initGrads);
+
+  // one update reads grads, params, mt, vt, avg and writes params, mt, vt, avg
+  double bytesPerUpdate = 9. * sizeof(float) * elements;
+
+  double denom1 = 0, denom2 = 0;
+  double seconds = 0;
+  for(int it = 0; it < iterations; ++it) {
+    grads->copyFrom(initGradsTensor);
+    backend->synchronize();
+    timer::Timer timer;
+    unfusedUpdate(params, mt, vt, avg, grads, denom1, denom2, clipNorm, eta, avgDecay);
+    seconds += timer.elapsed();
+  }
+  std::cerr << "[separate passes] " << seconds / iterations * 1000 << " ms per update, "
+            << bytesPerUpdate * iterations / seconds / 1e9 << " GB/s effective" << std::endl;
+
+  // single-threaded, then threaded on the CPU; the values of the last run are compared below
+  std::vector<size_t> runs = {1};
+  if(threads > 1 && deviceType == DeviceType::cpu)
+    runs.push_back(threads);
+  for(size_t updateThreads : runs) {
+    fusedParams->set(initParams);
+    fusedAvg->set(initParams);
+    auto adam = New<Adam>(eta, /*refMBWordsParam=*/0, New<Norm>(clipNorm));
+    adam->setUpdateThreads(updateThreads);
+    seconds = 0;
+    for(int it = 0; it < iterations; ++it) {
+      fusedGrads->copyFrom(initGradsTensor);
+      backend->synchronize();
+      timer::Timer timer;
+      adam->update(fusedParams, fusedGrads, OptimizerBase::mbSizeNotProvided, fusedAvg, avgDecay);
+      seconds += timer.elapsed();
+    }
+    std::cerr << "[fused, " << updateThreads << " thread(s)] " << seconds / iterations * 1000 << " ms per update, "
+              << bytesPerUpdate * iterations / seconds / 1e9 << " GB/s effective" << std::endl;
+  }
+
+  std::vector<float> v1, v2, a1, a2;
+  params->get(v1);
+  fusedParams->get(v2);
+  avg->get(a1);
+  fusedAvg->get(a2);
+  float maxDiff = 0.f;
+  for(int i = 0; i < elements; ++i)
+    maxDiff = std::max(maxDiff, std::max(std::abs(v1[i] - v2[i]), std::abs(a1[i] - a2[i])));
+  std::cerr << "Max difference between results: " << maxDiff << std::endl;
+  ABORT_IF(maxDiff > 1e-5f, "Fused and separate optimizer updates differ");
+
+  return 0;
+}
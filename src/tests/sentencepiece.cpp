@@ -0,0 +1,56 @@
+#include "common/file_stream.h"
+#include "common/logging.h"
+#include "common/options.h"
+#include "common/timer.h"
+#include "data/vocab.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Benchmark for SentencePiece encoding with and without --sentencepiece-cache-size.
+// Usage: test_sentencepiece vocab.spm corpus.txt [cache size] [words|lines]
+// Encodes the corpus twice (to simulate two epochs) and reports lines per second.
+
+using namespace marian;
+
+static void encodeAll(const std::string& vocabPath,
+                      const std::vector<std::string>& lines,
+                      size_t cacheSize,
+                      const std::string& cacheMode) {
+  auto options = New<Options>("sentencepiece-cache-size", cacheSize,
+                              "sentencepiece-cache-mode", cacheMode);
+  auto vocab = New<Vocab>(options, 0);
+  vocab->load(vocabPath);
+
+  size_t words = 0;
+  timer::Timer timer;
+  for(int epoch = 0; epoch < 2; ++epoch)
+    for(const auto& line : lines)
+      words += vocab->encode(line, /*addEOS=*/true, /*inference=*/true).size();
+  double seconds = timer.elapsed();
+
+  std::cout << "cache size " << cacheSize << " (" << cacheMode << "): "
+            << 2 * lines.size() / seconds << " lines/s, "
+            << words / seconds << " pieces/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  ABORT_IF(argc < 3 || argc > 5, "FATAL ERROR: Incorrect number of command line arguments "
+           "(expected: 2 to 4) for command {}.", argv[0]);
+  createLoggers();
+
+  std::vector<std::string> lines;
+  io::InputFileStream in(argv[2]);
+  std::string line;
+  while(io::getline(in, line))
+    lines.push_back(line);
+
+  size_t cacheSize = argc > 3 ? std::stoul(argv[3]) : 1000000;
+  std::string cacheMode = argc > 4 ? argv[4] : "words";
+
+  encodeAll(argv[1], lines, 0, cacheMode);
+  encodeAll(argv[1], lines, cacheSize, cacheMode);
+
+  return 0;
+}
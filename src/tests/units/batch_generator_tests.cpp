@@ -0,0 +1,58 @@
+#include "catch.hpp"
+#include "common/file_stream.h"
+#include "data/batch_generator.h"
+#include "data/corpus.h"
+
+#include <chrono>
+#include <future>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace marian;
+
+TEST_CASE("BatchGenerator can be stopped while the reader waits for input", "[batch_generator]") {
+  io::TemporaryFile vocabFile("/tmp", /*earlyUnlink=*/false);
+  vocabFile << "</s>\n<unk>\na\nb\nc\n";
+  vocabFile.flush();
+
+  // a pipe that stays open for writing, like stdin from a terminal or another process
+  std::string fifo = "batch_generator_tests.fifo";
+  unlink(fifo.c_str());
+  REQUIRE(mkfifo(fifo.c_str(), 0600) == 0);
+  int fd = open(fifo.c_str(), O_RDWR);
+  REQUIRE(fd >= 0);
+  std::string lines = "a b c\nb c\nc a b a\n";
+  REQUIRE(write(fd, lines.data(), lines.size()) == (ssize_t)lines.size());
+
+  auto options = New<Options>("max-length", (size_t)100,
+                              "max-length-crop", false,
+                              "right-left", false,
+                              "inference", true,
+                              "shuffle", std::string("none"),
+                              "maxi-batch-timeout", (size_t)20,
+                              "mini-batch", 2,
+                              "maxi-batch", 10,
+                              "maxi-batch-sort", std::string("none"));
+  auto vocab = New<Vocab>(options, 0);
+  vocab->load(vocabFile.getFileName());
+  auto corpus = New<data::Corpus>(std::vector<std::string>({fifo}), std::vector<Ptr<Vocab>>({vocab}), options);
+
+  auto bg = New<data::BatchGenerator<data::Corpus>>(corpus, options);
+  bg->prepare();
+  auto it = bg->begin(); // the lines written so far are flushed after the timeout
+  REQUIRE(*it);
+  CHECK((*it)->size() == 2);
+  ++it;
+  REQUIRE(*it);
+  CHECK((*it)->size() == 1);
+
+  // the reader thread is now blocked in reading the next line; destruction must not wait for it
+  auto destroyed = std::async(std::launch::async, [&bg]() { bg.reset(); });
+  CHECK(destroyed.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+  close(fd); // end of input, so that the reader thread ends in any case
+  destroyed.wait();
+  unlink(fifo.c_str());
+}
@@ -0,0 +1,137 @@
+#include "catch.hpp"
+#include "common/timer.h"
+#include "graph/expression_graph.h"
+#include "graph/expression_operators.h"
+#include "rnn/types.h"
+#include "translator/beam_search.h"
+
+#include <iostream>
+#include <random>
+
+using namespace marian;
+
+// A step of a secondary factor group with random logits of several scorers, some hypotheses
+// that cannot expand the factor and back pointers into the rows of the logits.
+struct FactorStep {
+  size_t maxBeamSize, currentDimBatch, dimFactor;
+  std::vector<std::vector<float>> logits; // [scorer] -> [maxBeamSize, 1, currentDimBatch, dimFactor]
+  std::vector<float> weights;             // [scorer]
+  std::vector<IndexType> hypIndices;      // [maxBeamSize, 1, currentDimBatch, 1]
+  std::vector<float> prevScores;          // [maxBeamSize, 1, currentDimBatch, 1]
+
+  FactorStep(size_t maxBeamSize_, size_t currentDimBatch_, size_t dimFactor_, unsigned seed)
+      : maxBeamSize(maxBeamSize_), currentDimBatch(currentDimBatch_), dimFactor(dimFactor_), weights({1.f, 0.5f}) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> logit(-4.f, 4.f);
+    std::uniform_real_distribution<float> score(-20.f, 0.f);
+    size_t rows = maxBeamSize * currentDimBatch;
+    logits.resize(weights.size());
+    for(auto& values : logits)
+      for(size_t k = 0; k < rows * dimFactor; ++k)
+        values.push_back(logit(rng));
+    for(size_t k = 0; k < rows; ++k) {
+      hypIndices.push_back((IndexType)(rng() % rows));
+      prevScores.push_back(rng() % 4 == 0 ? std::numeric_limits<float>::lowest() : score(rng)); // without this factor
+    }
+  }
+
+  Shape shape() const { return {(int)maxBeamSize, 1, (int)currentDimBatch, (int)dimFactor}; }
+};
+
+// the logits of the step as computed by the graph pass of the lemma step
+static std::vector<Expr> forwardLogits(Ptr<ExpressionGraph> graph, const FactorStep& step) {
+  graph->clear();
+  std::vector<Expr> logits;
+  for(const auto& values : step.logits)
+    logits.push_back(graph->constant(step.shape(), inits::fromVector(values)));
+  graph->forward();
+  return logits;
+}
+
+// the factor step on the host, as in BeamSearch::search
+static void factorNBest(const std::vector<Expr>& logits, const FactorStep& step,
+                        std::vector<float>& nBestPathScores, std::vector<unsigned int>& nBestKeys) {
+  std::vector<Tensor> factorLogits;
+  for(auto node : logits)
+    factorLogits.push_back(node->val());
+  BeamSearch search(DecodeConfig(), {}, nullptr);
+  search.getFactorNBestList(factorLogits, step.weights, step.hypIndices, step.prevScores,
+                            step.maxBeamSize, step.currentDimBatch, nBestPathScores, nBestKeys);
+}
+
+// the factor step as before the factor scores were expanded on the host: normalization, selection
+// of the rows, expansion and n-best in a graph pass of its own
+static void factorNBestInGraph(const std::vector<Expr>& logits, const FactorStep& step,
+                               std::vector<float>& nBestPathScores, std::vector<unsigned int>& nBestKeys) {
+  auto graph = logits.front()->graph();
+  auto expandedPathScores = graph->constant({(int)step.maxBeamSize, 1, (int)step.currentDimBatch, 1},
+                                            inits::fromVector(step.prevScores));
+  for(size_t i = 0; i < logits.size(); ++i) {
+    auto logProbs = logits[i] - max(logits[i], -1);
+    logProbs = rnn::State::select(logProbs, step.hypIndices, (int)step.maxBeamSize, /*isBatchMajor=*/false);
+    expandedPathScores = expandedPathScores + step.weights[i] * logProbs;
+  }
+  expandedPathScores = swapAxes(expandedPathScores, 0, 2);
+  graph->forwardNext();
+  auto getNBestList = createGetNBestListFn(step.maxBeamSize, step.currentDimBatch, graph->getDeviceId());
+  getNBestList(expandedPathScores->val(), step.maxBeamSize, nBestPathScores, nBestKeys, /*isFirst=*/false);
+}
+
+static Ptr<ExpressionGraph> newGraph() {
+  auto graph = New<ExpressionGraph>(/*inference=*/true);
+  graph->setDevice({0, DeviceType::cpu});
+  graph->reserveWorkspaceMB(16);
+  return graph;
+}
+
+TEST_CASE("Secondary factors expanded on the host give the n-best list of a graph pass", "[beam_search]") {
+  auto graph = newGraph();
+  const float invalid = std::numeric_limits<float>::lowest();
+  for(size_t maxBeamSize : {1, 4}) {
+    for(size_t currentDimBatch : {1, 3}) {
+      FactorStep step(maxBeamSize, currentDimBatch, /*dimFactor=*/7, /*seed=*/(unsigned)(maxBeamSize * 10 + currentDimBatch));
+
+      std::vector<float> scores, expectedScores;
+      std::vector<unsigned int> keys, expectedKeys;
+      auto logits = forwardLogits(graph, step);
+      factorNBest(logits, step, scores, keys);
+      factorNBestInGraph(logits, step, expectedScores, expectedKeys);
+
+      REQUIRE(scores.size() == expectedScores.size());
+      REQUIRE(keys.size() == expectedKeys.size());
+      for(size_t k = 0; k < scores.size(); ++k) {
+        CHECK((scores[k] == invalid) == (expectedScores[k] == invalid));
+        if(expectedScores[k] == invalid) // (no hypothesis of this batch entry can expand the factor, ignored by toHyps())
+          continue;
+        CHECK(keys[k] == expectedKeys[k]);
+        CHECK(scores[k] == Approx(expectedScores[k]).epsilon(1e-6));
+      }
+    }
+  }
+}
+
+// Time of a factor step for small batches, after the graph pass of the lemma step.
+// Run with: run_beam_search_tests "[benchmark]"
+TEST_CASE("Benchmark of the secondary factor step for small batches", "[.][benchmark]") {
+  auto graph = newGraph();
+  for(size_t currentDimBatch : {1, 4, 16}) {
+    FactorStep step(/*maxBeamSize=*/6, currentDimBatch, /*dimFactor=*/20, /*seed=*/1);
+    const size_t steps = 2000;
+    std::vector<float> scores;
+    std::vector<unsigned int> keys;
+    double seconds[2] = {0, 0};
+    for(int host = 0; host < 2; ++host) {
+      for(size_t n = 0; n < steps; ++n) {
+        auto logits = forwardLogits(graph, step);
+        timer::Timer timer;
+        if(host)
+          factorNBest(logits, step, scores, keys);
+        else
+          factorNBestInGraph(logits, step, scores, keys);
+        seconds[host] += timer.elapsed();
+      }
+    }
+    std::cout << "batch " << currentDimBatch << ": " << seconds[0] / steps * 1e6 << " us per factor step with a "
+              << "graph pass, " << seconds[1] / steps * 1e6 << " us on the host" << std::endl;
+  }
+}
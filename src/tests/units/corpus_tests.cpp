@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "common/file_stream.h"
+#include "data/corpus.h"
+
+#include <set>
+
+using namespace marian;
+
+TEST_CASE("On-disk shuffling returns every sentence pair exactly once", "[corpus]") {
+  const size_t numWords = 50, numLines = 10000;
+
+  io::TemporaryFile vocabFile("/tmp", /*earlyUnlink=*/false);
+  vocabFile << "</s>\n<unk>\n";
+  for(size_t w = 0; w < numWords; ++w)
+    vocabFile << "w" << w << "\n";
+  vocabFile.flush();
+
+  // line i encodes i in both streams, so that content and id can be checked against each other
+  std::vector<std::string> srcLines, trgLines;
+  io::TemporaryFile srcFile("/tmp", /*earlyUnlink=*/false), trgFile("/tmp", /*earlyUnlink=*/false);
+  for(size_t i = 0; i < numLines; ++i) {
+    srcLines.push_back("w" + std::to_string(i % numWords) + " w" + std::to_string(i / numWords % numWords));
+    trgLines.push_back("w" + std::to_string(i / numWords / numWords) + " " + srcLines.back());
+    srcFile << srcLines.back() << "\n";
+    trgFile << trgLines.back() << "\n";
+  }
+  srcFile.flush();
+  trgFile.flush();
+
+  auto options = New<Options>("max-length", (size_t)100,
+                              "max-length-crop", false,
+                              "right-left", false,
+                              "tempdir", std::string("/tmp"),
+                              "shuffle-shards", (size_t)7);
+  std::vector<Ptr<Vocab>> vocabs;
+  for(size_t stream = 0; stream < 2; ++stream) {
+    vocabs.push_back(New<Vocab>(options, stream));
+    vocabs.back()->load(vocabFile.getFileName());
+  }
+  auto corpus = New<data::Corpus>(std::vector<std::string>({srcFile.getFileName(), trgFile.getFileName()}),
+                                  vocabs,
+                                  options);
+
+  for(int epoch = 0; epoch < 2; ++epoch) {
+    corpus->shuffle();
+
+    std::set<size_t> seen;
+    size_t inOrder = 0;
+    for(const auto& tuple : *corpus) {
+      size_t id = tuple.getId();
+      REQUIRE(id < numLines);
+      CHECK(seen.insert(id).second);
+      CHECK(tuple[0] == vocabs[0]->encode(srcLines[id]));
+      CHECK(tuple[1] == vocabs[1]->encode(trgLines[id]));
+      if(id == inOrder)
+        inOrder++;
+    }
+    CHECK(seen.size() == numLines);
+    CHECK(inOrder < numLines / 2); // the order has changed
+  }
+}
@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include "common/file_stream.h"
+
+#include <cstdio>
+
+using namespace marian;
+
+static std::vector<std::string> makeLines(size_t n) {
+  std::vector<std::string> lines;
+  for(size_t i = 0; i < n; ++i)
+    lines.push_back("sentence " + std::to_string(i) + std::string(i % 37, 'x'));
+  return lines;
+}
+
+static std::vector<std::string> readLines(std::istream& in) {
+  std::vector<std::string> lines;
+  for(std::string line; io::getline(in, line);)
+    lines.push_back(line);
+  return lines;
+}
+
+TEST_CASE("Compressed files can be read back", "[file_stream]") {
+  auto lines = makeLines(200000); // more than one read-ahead block
+
+  std::vector<std::string> extensions = {".txt", ".gz"};
+#ifdef USE_ZSTD
+  extensions.push_back(".zst");
+#endif
+  for(const auto& extension : extensions) {
+    INFO("extension " << extension);
+    std::string fileName = "file_stream_tests" + extension;
+    {
+      io::OutputFileStream out(fileName);
+      for(const auto& line : lines)
+        out << line << '\n';
+    }
+    {
+      io::InputFileStream in(fileName);
+      CHECK(readLines(in) == lines);
+    }
+    std::remove(fileName.c_str());
+  }
+}
+
+TEST_CASE("Compressed temporary files can be read back after flushing", "[file_stream]") {
+  auto lines = makeLines(1000);
+  io::TemporaryFile temp("/tmp/", /*earlyUnlink=*/true, /*compressed=*/true);
+  for(const auto& line : lines)
+    temp << line << '\n';
+  temp.flush();
+  temp << "last" << '\n';
+  temp.flush();
+  lines.push_back("last");
+
+  auto in = temp.getInputStream();
+  CHECK(readLines(*in) == lines);
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "graph/expression_graph.h"
+#include "graph/expression_operators.h"
+#include "training/gradient_buckets.h"
+
+using namespace marian;
+
+TEST_CASE("Gradient buckets reduce the same gradients as the full reduce-scatter", "[gradient_buckets]") {
+  const size_t numGraphs = 3;
+  // parameters straddle the bucket edges (multiples of 2^18 elements for 1 MB) and the shard edges
+  const std::vector<int> sizes = {100003, 300007, 5, 262144, 77777};
+
+  std::vector<Ptr<ExpressionGraph>> graphs;
+  for(size_t g = 0; g < numGraphs; ++g) {
+    auto graph = New<ExpressionGraph>();
+    graph->setDevice({g, DeviceType::cpu});
+    graph->reserveWorkspaceMB(16);
+    graphs.push_back(graph);
+  }
+  auto comm = New<DefaultCommunicator>(graphs, nullptr);
+
+  // the gradient of each parameter is its weight, which differs between graphs
+  auto build = [&](size_t g) {
+    auto graph = graphs[g];
+    graph->clear();
+    Expr cost;
+    for(size_t k = 0; k < sizes.size(); ++k) {
+      std::vector<float> weights(sizes[k]);
+      for(int i = 0; i < sizes[k]; ++i)
+        weights[i] = (float)((i * (g + 1) + k) % 17) - 8.f;
+      auto p = graph->param("p" + std::to_string(k), {1, sizes[k]}, inits::zeros());
+      auto w = graph->constant({1, sizes[k]}, inits::fromVector(weights));
+      auto c = sum(p * w, -1);
+      cost = cost ? cost + c : c;
+    }
+    graph->forward();
+  };
+
+  auto getGrads = [&]() {
+    std::vector<std::vector<float>> grads(numGraphs);
+    for(size_t g = 0; g < numGraphs; ++g)
+      graphs[g]->params()->grads()->get(grads[g]);
+    return grads;
+  };
+
+  // reference: backward passes, then reduce all gradients at once
+  for(size_t g = 0; g < numGraphs; ++g) {
+    build(g);
+    graphs[g]->backward();
+  }
+  comm->scatterReduceAndResetGrads();
+  auto expected = getGrads();
+
+  // reduction in buckets of 1 MB during the backward passes
+  for(auto graph : graphs)
+    graph->params()->set_zero_adjoint();
+  GradientBuckets buckets(comm, graphs, /*bucketSizeMB=*/1);
+  buckets.start();
+  for(size_t g = 0; g < numGraphs; ++g) {
+    build(g);
+    buckets.backward(g);
+    buckets.finish(g);
+  }
+  buckets.wait();
+  comm->resetGrads();
+  auto actual = getGrads();
+
+  for(size_t g = 0; g < numGraphs; ++g) {
+    REQUIRE(actual[g].size() == expected[g].size());
+    CHECK(actual[g] == expected[g]);
+  }
+}
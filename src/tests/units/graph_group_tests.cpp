@@ -0,0 +1,177 @@
+#include "catch.hpp"
+#include "common/config.h"
+#include "common/file_stream.h"
+#include "data/batch_generator.h"
+#include "data/corpus.h"
+#include "training/graph_group_sync.h"
+#include "training/scheduler.h"
+
+#include <cstdio>
+#include <fstream>
+#include <tuple>
+
+#include <glob.h>
+
+using namespace marian;
+
+TEST_CASE("Batch statistics cache keys are stable", "[graph_group]") {
+  SECTION("FNV-1a gives the reference values") {
+    CHECK(util::fnv1a64("") == 14695981039346656037ull);
+    CHECK(util::fnv1a64("a") == 0xaf63dc4c8601ec8cull);
+    CHECK(util::fnv1a64("foobar") == 0x85944171f73967e8ull);
+  }
+
+  SECTION("the key depends on the settings that affect memory use only") {
+    auto options = New<Options>("type", std::string("transformer"),
+                                "dim-emb", 512,
+                                "workspace", (size_t)2048,
+                                "disp-freq", std::string("500"));
+    // the same for every build, as the cache file may be shared between builds
+    auto key = GraphGroup::batchStatsKey(options, 1.0);
+    CHECK(key == "15568678246983457606");
+
+    auto other = New<Options>(options->clone());
+    other->set("disp-freq", std::string("1000"));
+    CHECK(GraphGroup::batchStatsKey(other, 1.0) == key);
+
+    other->set("workspace", (size_t)4096);
+    CHECK(GraphGroup::batchStatsKey(other, 1.0) != key);
+    CHECK(GraphGroup::batchStatsKey(options, 2.0) != key);
+  }
+}
+
+TEST_CASE("Sharded checkpoints restore the state of a full checkpoint for the same and other layouts", "[graph_group]") {
+  // a tiny transformer trained on the CPU devices of this process
+  io::TemporaryFile vocabFile("/tmp", /*earlyUnlink=*/false);
+  vocabFile << "</s>\n<unk>\n";
+  for(size_t w = 0; w < 20; ++w)
+    vocabFile << "w" << w << "\n";
+  vocabFile.flush();
+  io::TemporaryFile srcFile("/tmp", /*earlyUnlink=*/false), trgFile("/tmp", /*earlyUnlink=*/false);
+  for(size_t i = 0; i < 48; ++i) {
+    srcFile << "w" << i % 20 << " w" << i * 7 % 20 << " w" << i * 3 % 20 << "\n";
+    trgFile << "w" << i * 3 % 20 << " w" << i % 20 << "\n";
+  }
+  srcFile.flush();
+  trgFile.flush();
+
+  std::string prefix = srcFile.getFileName();
+  // parsed once, since parseOptions() also creates the loggers
+  auto options = [&]() {
+    std::vector<std::string> args = {"marian", "--type", "transformer", "--dim-emb", "16",
+        "--transformer-dim-ffn", "32", "--transformer-heads", "2", "--enc-depth", "1", "--dec-depth", "1",
+        "--train-sets", srcFile.getFileName(), trgFile.getFileName(),
+        "--vocabs", vocabFile.getFileName(), vocabFile.getFileName(),
+        "--cpu-threads", "2", "--workspace", "64", "--mini-batch", "12", "--maxi-batch", "1",
+        "--no-shuffle", "--seed", "1234", "--cost-type", "ce-sum", "--exponential-smoothing",
+        "--overwrite", "--disp-freq", "1000", "--save-freq", "1000", "--quiet"};
+    std::vector<char*> argv;
+    for(auto& arg : args)
+      argv.push_back(&arg[0]);
+    return parseOptions((int)argv.size(), argv.data(), cli::mode::training);
+  }();
+  auto corpus = New<data::Corpus>(options);
+  data::BatchGenerator<data::Corpus> batchGenerator(corpus, options);
+  batchGenerator.prepare();
+  std::vector<Ptr<data::CorpusBatch>> batches;
+  for(auto batch : batchGenerator)
+    batches.push_back(batch);
+  REQUIRE(batches.size() >= 3);
+
+  auto mpi = initMPI(/*multiThreaded=*/false);
+  auto start = [&](const std::string& model, size_t devices, bool sharded) {
+    auto runOptions = New<Options>(options->clone());
+    runOptions->set("model", prefix + model, "cpu-threads", devices, "sharded-checkpoints", sharded);
+    auto scheduler = New<Scheduler>(runOptions, New<TrainingState>(runOptions->get<float>("learn-rate")));
+    auto graphGroup = New<SyncGraphGroup>(runOptions, mpi);
+    graphGroup->setScheduler(scheduler);
+    graphGroup->load();
+    return std::make_tuple(runOptions, scheduler, graphGroup);
+  };
+
+  // the checkpoint after two updates on two devices, once sharded and once full
+  for(bool sharded : {true, false}) {
+    auto run = start(sharded ? ".sharded.npz" : ".full.npz", 2, sharded);
+    std::get<2>(run)->update(batches[0]);
+    std::get<2>(run)->update(batches[1]);
+    std::get<2>(run)->save();
+  }
+
+  auto manifest = YAML::LoadFile(prefix + ".sharded.npz.optimizer.shards.yml");
+  std::map<std::string, bool> sharded;
+  for(const auto& item : manifest["items"])
+    sharded[item["name"].as<std::string>()] = item["sharded"].as<bool>();
+  CHECK(sharded == std::map<std::string, bool>({{"adam_mt", true}, {"adam_vt", true},
+                                                {"adam_denoms", false}, {"exp_smoothing", true}}));
+
+  // the third update on the given number of devices, continued from a checkpoint; returns the
+  // smoothed and the original parameters and the optimizer state
+  auto resume = [&](const std::string& model, size_t devices, bool sharded) {
+    auto run = start(model, devices, sharded);
+    std::get<2>(run)->update(batches[2]);
+    std::get<0>(run)->set("model", prefix + ".resumed.npz");
+    std::get<2>(run)->save();
+    auto items = io::loadItems(prefix + ".resumed.npz");
+    for(auto& item : io::loadItems(prefix + ".resumed.npz.orig.npz")) {
+      item.name = "orig." + item.name;
+      items.push_back(item);
+    }
+    for(auto& item : io::loadItems(prefix + (sharded ? ".resumed.npz.optimizer.shard0.npz" : ".resumed.npz.optimizer.npz")))
+      if(item.name != "exp_smoothing") // restored from and saved to model.npz with full checkpoints
+        items.push_back(item);
+    return items;
+  };
+
+  auto maxDifference = [](const std::vector<io::Item>& a, const std::vector<io::Item>& b) {
+    REQUIRE(a.size() == b.size());
+    double difference = 0;
+    for(size_t i = 0; i < a.size(); ++i) {
+      REQUIRE(a[i].name == b[i].name);
+      REQUIRE(a[i].bytes.size() == b[i].bytes.size());
+      if(a[i].type != Type::float32)
+        CHECK(a[i].bytes == b[i].bytes);
+      else
+        for(size_t k = 0; k < (size_t)a[i].shape.elements(); ++k)
+          difference = std::max(difference, (double)std::abs(((float*)a[i].data())[k] - ((float*)b[i].data())[k]));
+    }
+    return difference;
+  };
+
+  // the same and another number of devices; the gradients are clipped per shard, so the update
+  // itself depends on the number of devices
+  for(size_t devices : {2, 3})
+    CHECK(maxDifference(resume(".sharded.npz", devices, true), resume(".full.npz", devices, false)) < 1e-6);
+
+  { // another number of shards, as if written by three MPI processes
+    auto items = io::loadItems(prefix + ".sharded.npz.optimizer.shard0.npz");
+    size_t size = manifest["size"].as<size_t>();
+    std::vector<size_t> edges = {0, size / 5, size / 2, size};
+    manifest["shards"] = YAML::Node();
+    for(size_t rank = 0; rank < 3; ++rank) {
+      std::vector<io::Item> shardItems;
+      for(const auto& item : items) {
+        shardItems.push_back(item);
+        if(!sharded[item.name])
+          continue;
+        auto& shardItem = shardItems.back();
+        shardItem.shape = Shape({1, (int)(edges[rank + 1] - edges[rank])});
+        shardItem.bytes.assign(item.bytes.begin() + edges[rank] * sizeof(float),
+                               item.bytes.begin() + edges[rank + 1] * sizeof(float));
+      }
+      io::saveItems(prefix + ".sharded.npz.optimizer.shard" + std::to_string(rank) + ".npz", shardItems);
+      YAML::Node shard;
+      shard["rank"] = rank;
+      shard["begin"] = edges[rank];
+      shard["end"] = edges[rank + 1];
+      manifest["shards"].push_back(shard);
+    }
+    std::ofstream(prefix + ".sharded.npz.optimizer.shards.yml") << manifest;
+    CHECK(maxDifference(resume(".sharded.npz", 2, true), resume(".full.npz", 2, false)) < 1e-6);
+  }
+
+  glob_t files;
+  if(glob((prefix + ".*").c_str(), 0, nullptr, &files) == 0)
+    for(size_t i = 0; i < files.gl_pathc; ++i)
+      std::remove(files.gl_pathv[i]);
+  globfree(&files);
+}
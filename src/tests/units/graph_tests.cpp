@@ -121,3 +121,126 @@ TEST_CASE("Expression graph can be initialized with constant values (cpu)",
     REQUIRE(values == v);
   }
 }
+
+TEST_CASE("Checkpointing with a memory budget computes the same gradients (cpu)", "[graph]") {
+  // chain of 24 activations of 1 MB each, only a third of them fit into the budget
+  auto gradients = [](size_t budgetMB) {
+    Config::seed = 1234;
+    auto graph = New<ExpressionGraph>();
+    graph->setDevice({0, DeviceType::cpu});
+    graph->setCheckpointingBudgetMB(budgetMB);
+    graph->reserveWorkspaceMB(64);
+
+    auto x = graph->param("x", {256, 1024}, inits::uniform(-1.f, 1.f));
+    auto y = x;
+    for(int i = 0; i < 8; ++i)
+      y = tanh(y * 0.9f + 0.1f);
+    sum(sum(y, -1), -2);
+
+    graph->forward();
+    graph->backward();
+
+    std::vector<float> values;
+    graph->params()->grads()->get(values);
+    return values;
+  };
+
+  auto reference = gradients(0);
+  CHECK(gradients(8) == reference);
+  CHECK(gradients(1) == reference); // budget cannot be met, falls back to the smallest peak
+}
+
+TEST_CASE("Memory planning places values without changing results (cpu)", "[graph]") {
+  std::vector<float> input(64 * 256);
+  for(size_t i = 0; i < input.size(); ++i)
+    input[i] = (float)(i % 17) / 17.f - 0.5f;
+
+  // each pass builds the same chain, intermediate values are freed during the pass
+  auto pass = [&](Ptr<ExpressionGraph> graph, bool holdIntermediate, int rows = 64) {
+    graph->clear();
+    auto x = graph->constant({rows, 256}, inits::fromVector(std::vector<float>(input.begin(), input.begin() + rows * 256)));
+    Expr held;
+    auto y = x;
+    for(int i = 0; i < 6; ++i) {
+      y = tanh(y * 0.9f + 0.1f) + y;
+      if(holdIntermediate && i == 2)
+        held = y; // stays alive, values planned into its memory must be allocated elsewhere
+    }
+    auto out = sum(y, -1);
+    graph->forward();
+    std::vector<float> values;
+    out->val()->get(values);
+    return values;
+  };
+
+  auto newGraph = []() {
+    auto graph = New<ExpressionGraph>(/*inference=*/true);
+    graph->setDevice({0, DeviceType::cpu});
+    graph->reserveWorkspaceMB(16);
+    return graph;
+  };
+  auto reference = pass(newGraph(), false);
+  auto reference17 = pass(newGraph(), false, 17);
+
+  auto graph = New<ExpressionGraph>(/*inference=*/true);
+  graph->setDevice({0, DeviceType::cpu});
+  graph->reserveWorkspaceMB(16);
+  graph->setMemoryPlanning(true);
+
+  CHECK(pass(graph, false) == reference); // records the plan
+  CHECK(pass(graph, false) == reference); // places values in the arena
+  CHECK(pass(graph, true) == reference);
+  CHECK(pass(graph, false) == reference);
+  CHECK(pass(graph, false, 17) == reference17); // the same plan, repacked for other shapes
+  CHECK(pass(graph, false) == reference);
+}
+
+TEST_CASE("Element-wise fusion computes the same values (cpu)", "[graph]") {
+  std::vector<float> input(32 * 64);
+  for(size_t i = 0; i < input.size(); ++i)
+    input[i] = (float)(i % 23) / 23.f - 0.5f;
+
+  // returns the values and the number of absorbed nodes
+  auto pass = [&](bool fusion, bool holdIntermediate) {
+    auto graph = New<ExpressionGraph>(/*inference=*/true);
+    graph->setDevice({0, DeviceType::cpu});
+    graph->reserveWorkspaceMB(16);
+    graph->setElementwiseFusion(fusion);
+
+    auto a = graph->constant({32, 64}, inits::fromVector(input));
+    auto b = graph->constant({32, 64}, inits::fromValue(0.3f));
+    auto c = graph->constant({1, 64}, inits::fromValue(-0.2f)); // broadcast input
+    // the chain is built without references to its intermediate nodes, except the one held below
+    Expr held;
+    auto h = [&]() {
+      auto expr = sigmoid(a * b + c) * a;
+      if(holdIntermediate)
+        held = expr; // stays alive, must not be absorbed
+      return expr;
+    };
+    auto out = sum(tanh(relu(h() - 0.1f) * 2.f) + exp(a), -1);
+    graph->forward();
+
+    if(held)
+      CHECK(held->val());
+    std::vector<float> values;
+    out->val()->get(values);
+    return std::make_pair(values, graph->getNumFusedNodes());
+  };
+
+  auto reference = pass(false, false);
+  CHECK(reference.second == 0);
+
+  auto fused = pass(true, false);
+  // all 10 element-wise nodes but the last one before the sum are absorbed into it
+  CHECK(fused.second == 9);
+  auto partial = pass(true, true);
+  // the held node is computed by itself, from the 3 nodes before it
+  CHECK(partial.second == 8);
+
+  for(const auto& values : {fused.first, partial.first}) {
+    REQUIRE(values.size() == reference.first.size());
+    for(size_t i = 0; i < values.size(); ++i)
+      CHECK(values[i] == Approx(reference.first[i]).epsilon(1e-5));
+  }
+}
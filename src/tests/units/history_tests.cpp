@@ -0,0 +1,301 @@
+#include "catch.hpp"
+#include "common/timer.h"
+#include "translator/history.h"
+
+#include <array>
+#include <iostream>
+#include <random>
+
+using namespace marian;
+
+// The per-hypothesis storage that HypothesisArena replaced: one reference-counted object per
+// hypothesis with its own score breakdown and alignment, as reference for the results.
+namespace legacy {
+
+class Hypothesis {
+public:
+  typedef IPtr<Hypothesis> PtrType;
+
+  Hypothesis(const PtrType prevHyp, Word word, size_t prevBeamHypIdx, float pathScore)
+      : prevHyp_(prevHyp), prevBeamHypIdx_(prevBeamHypIdx), word_(word), pathScore_(pathScore) {}
+
+  const PtrType getPrevHyp() const { return prevHyp_; }
+  Word getWord() const { return word_; }
+  size_t getPrevStateIndex() const { return prevBeamHypIdx_; }
+  float getPathScore() const { return pathScore_; }
+
+  const std::vector<float>& getScoreBreakdown() { return scoreBreakdown_; }
+  void setScoreBreakdown(const std::vector<float>& scoreBreakdown) { scoreBreakdown_ = scoreBreakdown; }
+
+  const std::vector<float>& getAlignment() { return alignment_; }
+  void setAlignment(const std::vector<float>& align) { alignment_ = align; }
+
+  Words tracebackWords() {
+    Words targetWords;
+    for(auto hyp = this; hyp->getPrevHyp(); hyp = hyp->getPrevHyp().get())
+      targetWords.push_back(hyp->getWord());
+    std::reverse(targetWords.begin(), targetWords.end());
+    return targetWords;
+  }
+
+  std::vector<float> tracebackWordScores() {
+    std::vector<float> scores;
+    for(auto hyp = this; hyp->getPrevHyp(); hyp = hyp->getPrevHyp().get())
+      scores.push_back(hyp->pathScore_ - hyp->getPrevHyp()->pathScore_);
+    std::reverse(scores.begin(), scores.end());
+    return scores;
+  }
+
+  data::SoftAlignment tracebackAlignment() {
+    data::SoftAlignment align;
+    for(auto hyp = this; hyp->getPrevHyp(); hyp = hyp->getPrevHyp().get())
+      align.push_back(hyp->getAlignment());
+    std::reverse(align.begin(), align.end());
+    return align;
+  }
+
+private:
+  const PtrType prevHyp_;
+  const size_t prevBeamHypIdx_;
+  const Word word_;
+  const float pathScore_;
+
+  std::vector<float> scoreBreakdown_;
+  std::vector<float> alignment_;
+
+  ENABLE_INTRUSIVE_PTR(Hypothesis)
+};
+
+typedef std::vector<IPtr<Hypothesis>> Beam;
+typedef std::tuple<Words, IPtr<Hypothesis>, float> Result;
+
+class History {
+  struct SentenceHypothesisCoord {
+    bool operator<(const SentenceHypothesisCoord& hc) const { return normalizedPathScore < hc.normalizedPathScore; }
+    size_t timeStepIdx;
+    size_t beamIdx;
+    float normalizedPathScore;
+  };
+
+public:
+  History(float alpha, float wp) : alpha_(alpha), wp_(wp) {}
+
+  void add(const Beam& beam, Word trgEosId, bool last = false) {
+    if(beam.back()->getPrevHyp() != nullptr) {
+      for(size_t beamIdx = 0; beamIdx < beam.size(); ++beamIdx)
+        if(beam[beamIdx]->getWord() == trgEosId || last) {
+          float pathScore = (beam[beamIdx]->getPathScore() - wp_ * (float)history_.size())
+                            / std::pow((float)history_.size(), alpha_);
+          topHyps_.push({history_.size(), beamIdx, pathScore});
+        }
+    }
+    history_.push_back(beam);
+  }
+
+  std::vector<Result> nBest(size_t n) const {
+    std::vector<Result> nbest;
+    for(auto topHypsCopy = topHyps_; nbest.size() < n && !topHypsCopy.empty(); topHypsCopy.pop()) {
+      auto bestHypCoord = topHypsCopy.top();
+      auto bestHyp = history_[bestHypCoord.timeStepIdx][bestHypCoord.beamIdx];
+      nbest.emplace_back(bestHyp->tracebackWords(), bestHyp, bestHypCoord.normalizedPathScore);
+    }
+    return nbest;
+  }
+
+private:
+  std::vector<Beam> history_;
+  std::priority_queue<SentenceHypothesisCoord> topHyps_;
+  float alpha_;
+  float wp_;
+};
+
+}  // namespace legacy
+
+// Random search grids in the way BeamSearch::toHyps expands hypotheses: every second step is like
+// the step of a secondary factor, which short-circuits the back pointer and keeps the alignment of
+// the expanded hypothesis. The same expansions are recorded in both storages.
+class SearchSimulation {
+public:
+  static constexpr size_t numScores = 2;
+  static constexpr size_t srcLength = 7;
+  const Word eos = Word::fromWordIndex(0);
+
+  struct Expansion {
+    size_t prevBeamHypIdx;
+    Word word;
+    float logProb;
+    std::array<float, numScores> scores;
+    std::vector<float> alignment; // empty for secondary factors
+    bool factorStep;
+  };
+
+  SearchSimulation(size_t dimBatch, size_t beamSize, size_t maxLength, bool withFactorSteps, unsigned seed)
+      : dimBatch_(dimBatch) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> logProb(-3.f, 0.f);
+    std::uniform_int_distribution<unsigned> word(0, 50); // 0 is eos
+    std::vector<size_t> beamSizes(dimBatch, 1);
+    steps_.resize(maxLength, std::vector<std::vector<Expansion>>(dimBatch));
+    for(size_t t = 0; t < maxLength; ++t) {
+      for(size_t i = 0; i < dimBatch; ++i) {
+        for(size_t k = 0; k < beamSize; ++k) {
+          Expansion e;
+          e.prevBeamHypIdx = rng() % beamSizes[i];
+          e.word = Word::fromWordIndex(word(rng));
+          e.logProb = logProb(rng);
+          for(auto& score : e.scores)
+            score = logProb(rng);
+          e.factorStep = withFactorSteps && t % 2 == 0 && t > 0; // (t = 0 expands the start hypothesis)
+          if(!e.factorStep)
+            for(size_t s = 0; s < srcLength; ++s)
+              e.alignment.push_back(logProb(rng) + 3.f);
+          steps_[t][i].push_back(e);
+        }
+        beamSizes[i] = beamSize;
+      }
+    }
+  }
+
+  // calls expand(batchIdx, expansions, last) for every step and batch entry
+  template <class Fn>
+  void run(Fn&& expand) const {
+    for(size_t t = 0; t < steps_.size(); ++t)
+      for(size_t i = 0; i < dimBatch_; ++i)
+        expand(i, steps_[t][i], t + 1 == steps_.size());
+  }
+
+  size_t dimBatch() const { return dimBatch_; }
+
+private:
+  size_t dimBatch_;
+  std::vector<std::vector<std::vector<Expansion>>> steps_; // [step][batch entry][beam entry]
+};
+
+constexpr size_t SearchSimulation::numScores;
+constexpr size_t SearchSimulation::srcLength;
+
+// expansions into the arena-backed History, as in BeamSearch::toHyps
+static Histories searchArena(const SearchSimulation& sim, bool nBest) {
+  auto arena = New<HypothesisArena>(nBest ? SearchSimulation::numScores : 0);
+  Histories histories;
+  std::vector<Beam> beams;
+  for(size_t i = 0; i < sim.dimBatch(); ++i) {
+    histories.push_back(New<History>(i, arena, /*alpha=*/0.6f, /*wp=*/0.1f));
+    beams.push_back(Beam(1, Hypothesis(arena.get(), 0)));
+    histories.back()->add(beams.back(), sim.eos);
+  }
+  sim.run([&](size_t i, const std::vector<SearchSimulation::Expansion>& expansions, bool last) {
+    Beam newBeam;
+    for(const auto& e : expansions) {
+      auto prevHyp = beams[i][e.prevBeamHypIdx];
+      auto prevBeamHypIdx = e.prevBeamHypIdx;
+      if(e.factorStep) {
+        prevBeamHypIdx = prevHyp.getPrevStateIndex();
+        prevHyp = prevHyp.getPrevHyp();
+      }
+      auto hypIdx = arena->add(prevHyp.getIndex(), e.word, prevBeamHypIdx, beams[i][e.prevBeamHypIdx].getPathScore() + e.logProb);
+      if(arena->numScores() > 0) {
+        float* breakDown = arena->scoreBreakdown(hypIdx);
+        const float* prevBreakDown = arena->scoreBreakdown(beams[i][e.prevBeamHypIdx].getIndex());
+        for(size_t j = 0; j < SearchSimulation::numScores; ++j)
+          breakDown[j] = prevBreakDown[j] + e.scores[j];
+      }
+      if(!e.alignment.empty())
+        arena->setAlignment(hypIdx, e.alignment);
+      else
+        arena->shareAlignment(hypIdx, beams[i][e.prevBeamHypIdx].getIndex());
+      newBeam.emplace_back(arena.get(), hypIdx);
+    }
+    beams[i] = newBeam;
+    histories[i]->add(beams[i], sim.eos, last);
+  });
+  return histories;
+}
+
+// the same expansions into the per-hypothesis History, as in BeamSearch::toHyps before the arena
+static std::vector<Ptr<legacy::History>> searchLegacy(const SearchSimulation& sim, bool nBest) {
+  std::vector<Ptr<legacy::History>> histories;
+  std::vector<legacy::Beam> beams;
+  for(size_t i = 0; i < sim.dimBatch(); ++i) {
+    histories.push_back(New<legacy::History>(/*alpha=*/0.6f, /*wp=*/0.1f));
+    beams.push_back(legacy::Beam(1, INew<legacy::Hypothesis>(nullptr, Word::ZERO, 0, 0.f)));
+    histories.back()->add(beams.back(), sim.eos);
+  }
+  sim.run([&](size_t i, const std::vector<SearchSimulation::Expansion>& expansions, bool last) {
+    legacy::Beam newBeam;
+    for(const auto& e : expansions) {
+      auto prevHyp = beams[i][e.prevBeamHypIdx];
+      auto prevBeamHypIdx = e.prevBeamHypIdx;
+      if(e.factorStep) {
+        prevBeamHypIdx = prevHyp->getPrevStateIndex();
+        prevHyp = prevHyp->getPrevHyp();
+      }
+      auto hyp = INew<legacy::Hypothesis>(prevHyp, e.word, prevBeamHypIdx, beams[i][e.prevBeamHypIdx]->getPathScore() + e.logProb);
+      if(nBest) {
+        auto breakDown = beams[i][e.prevBeamHypIdx]->getScoreBreakdown();
+        breakDown.resize(SearchSimulation::numScores, 0);
+        for(size_t j = 0; j < SearchSimulation::numScores; ++j)
+          breakDown[j] += e.scores[j];
+        hyp->setScoreBreakdown(breakDown);
+      }
+      if(!e.alignment.empty())
+        hyp->setAlignment(e.alignment);
+      else
+        hyp->setAlignment(beams[i][e.prevBeamHypIdx]->getAlignment());
+      newBeam.push_back(hyp);
+    }
+    beams[i] = newBeam;
+    histories[i]->add(beams[i], sim.eos, last);
+  });
+  return histories;
+}
+
+TEST_CASE("History from the hypothesis arena matches per-hypothesis storage", "[history]") {
+  for(bool factorSteps : {false, true}) {
+    for(size_t beamSize : {1, 4}) {
+      SearchSimulation sim(/*dimBatch=*/3, beamSize, /*maxLength=*/15, factorSteps, /*seed=*/1234 + (unsigned)beamSize);
+      auto histories = searchArena(sim, /*nBest=*/true);
+      auto expected = searchLegacy(sim, /*nBest=*/true);
+
+      for(size_t i = 0; i < sim.dimBatch(); ++i) {
+        auto nbest = histories[i]->nBest(beamSize * 4);
+        auto nbestExpected = expected[i]->nBest(beamSize * 4);
+        REQUIRE(nbest.size() == nbestExpected.size());
+        REQUIRE(!nbest.empty());
+        for(size_t k = 0; k < nbest.size(); ++k) {
+          const auto& hyp = std::get<1>(nbest[k]);
+          const auto& hypExpected = std::get<1>(nbestExpected[k]);
+          CHECK(std::get<0>(nbest[k]) == std::get<0>(nbestExpected[k]));
+          CHECK(std::get<2>(nbest[k]) == std::get<2>(nbestExpected[k]));
+          CHECK(hyp.getPathScore() == hypExpected->getPathScore());
+          CHECK(hyp.tracebackWordScores() == hypExpected->tracebackWordScores());
+          CHECK(hyp.tracebackAlignment() == hypExpected->tracebackAlignment());
+          CHECK(hyp.getScoreBreakdown() == hypExpected->getScoreBreakdown());
+        }
+      }
+    }
+  }
+}
+
+// Time of the hypothesis bookkeeping of a search for small batches, without the model.
+// Run with: run_history_tests "[benchmark]"
+TEST_CASE("Benchmark of the hypothesis storage for small batches", "[.][benchmark]") {
+  for(size_t dimBatch : {1, 4, 16}) {
+    SearchSimulation sim(dimBatch, /*beamSize=*/6, /*maxLength=*/40, /*withFactorSteps=*/false, /*seed=*/42);
+    const size_t searches = 1000;
+    double seconds[2];
+    for(int arena = 0; arena < 2; ++arena) {
+      timer::Timer timer;
+      for(size_t n = 0; n < searches; ++n) {
+        if(arena)
+          searchArena(sim, /*nBest=*/false)[0]->top();
+        else
+          searchLegacy(sim, /*nBest=*/false)[0]->nBest(1);
+      }
+      seconds[arena] = timer.elapsed();
+    }
+    std::cout << "batch " << dimBatch << ": " << seconds[0] / searches * 1e6 << " us per search with "
+              << "per-hypothesis storage, " << seconds[1] / searches * 1e6 << " us with the arena"
+              << std::endl;
+  }
+}
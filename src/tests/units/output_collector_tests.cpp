@@ -0,0 +1,91 @@
+#include "catch.hpp"
+#include "common/file_stream.h"
+#include "translator/output_collector.h"
+#include "3rd_party/threadpool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <random>
+#include <thread>
+
+using namespace marian;
+
+static std::vector<std::string> writeShuffled(size_t numOutputs, size_t windowSize, size_t numThreads, bool nbest) {
+  io::TemporaryFile file("/tmp/", /*earlyUnlink=*/false);
+  {
+    auto collector = New<OutputCollector>(file.getFileName(), windowSize);
+    collector->setPrintingStrategy(New<QuietPrinting>());
+
+    std::vector<long> ids(numOutputs);
+    for(size_t i = 0; i < numOutputs; ++i)
+      ids[i] = (long)i;
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(1234));
+
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; ++t) {
+      threads.emplace_back([&, t]() {
+        for(size_t i = t; i < numOutputs; i += numThreads)
+          collector->Write(ids[i], "best " + std::to_string(ids[i]), "nbest " + std::to_string(ids[i]), nbest);
+      });
+    }
+    for(auto& thread : threads)
+      thread.join();
+  } // the collector writes the remaining outputs when it is destroyed
+
+  std::vector<std::string> lines;
+  std::ifstream in(file.getFileName());
+  for(std::string line; std::getline(in, line);)
+    lines.push_back(line);
+  return lines;
+}
+
+TEST_CASE("OutputCollector writes outputs in the order of their ids", "[output_collector]") {
+  SECTION("within the window") {
+    auto lines = writeShuffled(1000, 1024, 4, /*nbest=*/false);
+    REQUIRE(lines.size() == 1000);
+    for(size_t i = 0; i < lines.size(); ++i)
+      CHECK(lines[i] == "best " + std::to_string(i));
+  }
+
+  SECTION("beyond the window") {
+    auto lines = writeShuffled(1000, 8, 3, /*nbest=*/true);
+    REQUIRE(lines.size() == 1000);
+    for(size_t i = 0; i < lines.size(); ++i)
+      CHECK(lines[i] == "nbest " + std::to_string(i));
+  }
+}
+
+TEST_CASE("OutputCollector::close completes the output while the collector is still held", "[output_collector]") {
+  io::TemporaryFile file("/tmp/", /*earlyUnlink=*/false);
+  auto collector = New<OutputCollector>(file.getFileName(), /*windowSize=*/4);
+  collector->setPrintingStrategy(New<QuietPrinting>());
+
+  ThreadPool threadPool(2);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::vector<std::future<void>> written;
+  for(long id = 9; id >= 0; --id) {
+    // like a translation task, holds the collector by value until the pool has finished with it
+    auto task = [=]() {
+      collector->Write(id, "best " + std::to_string(id), "", /*nbest=*/false);
+    };
+    written.push_back(threadPool.enqueue(task));
+  }
+  for(auto& w : written)
+    w.wait();
+  // keep one more copy in a task that is still running when the output is read
+  auto holding = threadPool.enqueue([=]() { released.wait(); collector->Write(10, "late", "", false); });
+  collector->close();
+
+  std::vector<std::string> lines;
+  std::ifstream in(file.getFileName());
+  for(std::string line; std::getline(in, line);)
+    lines.push_back(line);
+  REQUIRE(lines.size() == 10);
+  for(size_t i = 0; i < lines.size(); ++i)
+    CHECK(lines[i] == "best " + std::to_string(i));
+
+  release.set_value();
+  holding.wait();
+}
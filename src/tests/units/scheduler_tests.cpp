@@ -0,0 +1,145 @@
+#include "catch.hpp"
+#include "training/scheduler.h"
+
+#include <future>
+
+using namespace marian;
+
+// validator that is never run, the tests only look at the stalled counts in the training state
+class DummyValidator : public ValidatorBase {
+public:
+  DummyValidator() : ValidatorBase(/*lowerIsBetter=*/true) {}
+
+  float validate(const std::vector<Ptr<ExpressionGraph>>& /*graphs*/,
+                 Ptr<const TrainingState> /*state*/) override {
+    return 0.f;
+  }
+  std::string type() override { return "dummy"; }
+};
+
+TEST_CASE("Scheduler early stopping with background validation", "[scheduler]") {
+  auto options = New<Options>("learn-rate", 0.0003f,
+                              "lr-warmup", std::string("0"),
+                              "lr-warmup-start-rate", 0.f,
+                              "lr-decay-inv-sqrt", std::vector<std::string>({"0"}),
+                              "valid-async", (size_t)1,
+                              "after-epochs", (size_t)0,
+                              "after-batches", (size_t)0,
+                              "early-stopping", (size_t)10);
+
+  SECTION("before the first validation of a resumed training has completed") {
+    auto state = New<TrainingState>(options->get<float>("learn-rate"));
+    state->loaded = true; // resumed from a state without validators, so there is no stalled count
+    auto scheduler = New<Scheduler>(options, state);
+    scheduler->addValidator(New<DummyValidator>());
+
+    CHECK( scheduler->stalled() == 0 );
+    CHECK( scheduler->keepGoing() );
+  }
+
+  SECTION("after the validations have stalled") {
+    auto state = New<TrainingState>(options->get<float>("learn-rate"));
+    auto scheduler = New<Scheduler>(options, state);
+    scheduler->addValidator(New<DummyValidator>());
+    CHECK( scheduler->keepGoing() );
+
+    state->validators["dummy"]["stalled"] = 10;
+    CHECK( scheduler->stalled() == 10 );
+    CHECK_FALSE( scheduler->keepGoing() );
+  }
+}
+
+// validator that waits until it is released; reports the parameter value it was given and
+// returns the number of validations including this one
+class BlockingValidator : public ValidatorBase {
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool released_{false};
+  std::vector<float> seen_;
+  size_t completed_{0};
+
+public:
+  BlockingValidator() : ValidatorBase(/*lowerIsBetter=*/true) {}
+
+  float validate(const std::vector<Ptr<ExpressionGraph>>& graphs,
+                 Ptr<const TrainingState> /*state*/) override {
+    graphs[0]->forward(); // allocates the parameters loaded from the snapshot
+    std::vector<float> values;
+    graphs[0]->get("p")->val()->get(values);
+    std::unique_lock<std::mutex> lock(mutex_);
+    seen_.push_back(values[0]);
+    cv_.notify_all();
+    cv_.wait(lock, [&]() { return released_; });
+    return (float)++completed_;
+  }
+  std::string type() override { return "blocking"; }
+
+  void hold() { std::lock_guard<std::mutex> lock(mutex_); released_ = false; }
+  void release() { std::lock_guard<std::mutex> lock(mutex_); released_ = true; cv_.notify_all(); }
+
+  float waitStarted(size_t validations) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() { return seen_.size() == validations; });
+    return seen_.back();
+  }
+  size_t completed() { std::lock_guard<std::mutex> lock(mutex_); return completed_; }
+};
+
+TEST_CASE("Scheduler runs validation in the background while training continues", "[scheduler]") {
+  auto options = New<Options>("learn-rate", 0.0003f,
+                              "lr-warmup", std::string("0"),
+                              "lr-warmup-start-rate", 0.f,
+                              "lr-decay-inv-sqrt", std::vector<std::string>({"0"}),
+                              "lr-report", false,
+                              "valid-async", (size_t)1,
+                              "valid-freq", std::string("1u"),
+                              "after-epochs", (size_t)0,
+                              "after-batches", (size_t)0,
+                              "early-stopping", (size_t)10,
+                              "cost-type", std::string("ce-sum"),
+                              "disp-label-counts", false,
+                              "disp-freq", std::string("1000u"),
+                              "disp-first", (size_t)0);
+
+  auto graph = New<ExpressionGraph>();
+  graph->setDevice({0, DeviceType::cpu});
+  graph->reserveWorkspaceMB(4);
+  auto p = graph->param("p", {1, 4}, inits::fromValue(1.f));
+  graph->forward();
+
+  auto state = New<TrainingState>(options->get<float>("learn-rate"));
+  auto scheduler = New<Scheduler>(options, state);
+  auto validator = New<BlockingValidator>();
+  scheduler->addValidator(validator);
+
+  scheduler->update(StaticLoss(), 1, 1, 1); // every update starts a validation period
+  scheduler->validate({graph});
+
+  // the validation runs on a snapshot of the parameters, which training changes in the meantime
+  p->val()->set(5.f);
+  CHECK(validator->waitStarted(1) == 1.f);
+
+  // the next update does not wait for the running validation
+  scheduler->update(StaticLoss(), 1, 1, 1);
+  CHECK(validator->completed() == 0);
+  CHECK(state->validBest == 0.f);
+
+  // once it has completed, its result is applied at the next update
+  validator->release();
+  while(validator->completed() == 0)
+    std::this_thread::yield();
+  CHECK(state->validBest == 0.f);
+  scheduler->update(StaticLoss(), 1, 1, 1);
+  CHECK(state->validBest == 1.f);
+
+  // finishing waits for a running validation and applies its result
+  validator->hold();
+  scheduler->validate({graph});
+  CHECK(validator->waitStarted(2) == 5.f);
+  auto finished = std::async(std::launch::async, [&]() { scheduler->finishValidation(/*wait=*/true); });
+  CHECK(finished.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout);
+  CHECK(state->validBest == 1.f);
+  validator->release();
+  finished.wait();
+  CHECK(state->validBest == 2.f);
+}
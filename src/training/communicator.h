@@ -5,6 +5,7 @@
 #include "functional/functional.h"
 #include "tensors/tensor_operators.h"
 #include "optimizers/optimizers.h"
+#include "common/phase_timer.h"
 #if MPI_FOUND
 #ifdef __GNUC__
 #pragma GCC diagnostic push
@@ -17,6 +18,10 @@
 #endif
 // clang-format on
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace marian {
 
 struct/*interface*/ IMPIWrapper; // @TODO: Should we use a separate header, or move this declaration up here?
@@ -40,6 +45,14 @@ public:
   virtual void scatterReduceAndResetGrads() const = 0; // reduce param gradients and scatter into gradient shards
   virtual void allGatherParams() const = 0;     // redistribute value shards into param values
 
+  // Reduction of a range of the gradients, e.g. as soon as the backward pass has completed it
+  // (see GradientBuckets). Sums the range [begin, end) of all local gradients into the gradient
+  // shards covering it; once all ranges are reduced, resetGrads() zeroes the gradients outside
+  // each shard. Together, this is the same as scatterReduceAndResetGrads().
+  virtual bool canScatterReduceRange() const { return false; }
+  virtual void scatterReduceRange(size_t /*begin*/, size_t /*end*/) const { ABORT("scatterReduceRange() not supported by this communicator"); }
+  virtual void resetGrads() const { ABORT("resetGrads() not supported by this communicator"); }
+
   virtual void swapParams(const std::vector<Tensor>& paramShards) const = 0;
 
   virtual void scatterState(const std::vector<float>& data, const OptimizerBase::ScatterStateSetFunc& setFn) const = 0;
@@ -95,32 +108,95 @@ private:
   std::vector<Ptr<TensorAllocator>> paramsAllocs_;
   std::vector<Tensor> tmpTensors_;
 
+  // chunks are transferred in pieces of this many elements, so that consecutive ring steps pipeline
+  const size_t ringPieceSize_{1 << 20};
+
   void lazyInit() {
     if(tmpTensors_.size() == 0) {
-      int totalSize = (int)graphs_[0]->params()->vals()->size();
-      int shardSize = (int)ceil(totalSize / (float)graphs_.size());
+      size_t totalSize = graphs_[0]->params()->vals()->size();
+      size_t shardSize = (size_t)ceil(totalSize / (float)graphs_.size());
+      int tmpSize = (int)std::min(shardSize, ringPieceSize_); // receive buffer for one piece
 
-      int pos = 0;
       for(auto graph : graphs_) {
-        int __size__ = std::min(shardSize, totalSize);
-
         auto paramsAlloc = New<TensorAllocator>(graph->getBackend());
         paramsAllocs_.push_back(paramsAlloc);
 
-        paramsAlloc->reserveExact(__size__ * sizeof(float));
+        paramsAlloc->reserveExact(tmpSize * sizeof(float));
 
         Tensor tmp;
-
-        paramsAlloc->allocate(tmp, {1, __size__});
+        paramsAlloc->allocate(tmp, {1, tmpSize});
         tmpTensors_.push_back(tmp);
-
-        // move to next shard
-        pos += __size__;
-        totalSize -= __size__;
       }
     }
   }
 
+  // Ring communication over the chunks [begin, end) of the shards, one chunk per graph. There are
+  // N-1 steps; in step k, each graph j receives chunk (j - k - 1 - shift) mod N from its predecessor
+  // (j - 1) mod N and calls stepFn(j, predecessor, begin, end) for each piece of it. Each graph
+  // only waits for its predecessor to finish the same piece in the previous step, so pieces of
+  // consecutive steps are pipelined along the ring. A piece counts as finished once the backend
+  // of the receiving graph has completed the work of stepFn. With shift = 1, graph j ends up with
+  // chunk j after the last step (reduce-scatter), with shift = 0, it starts from chunk j (all-gather).
+  typedef std::function<void(size_t /*receiver*/, size_t /*sender*/, size_t /*begin*/, size_t /*end*/)> RingStepFunc;
+  void ring(const std::vector<std::pair<size_t, size_t>>& chunks, size_t shift, const RingStepFunc& stepFn) const {
+    size_t numGraphs = graphs_.size();
+    if(numGraphs == 1)
+      return;
+
+    size_t maxChunkSize = 0;
+    for(const auto& chunk : chunks)
+      maxChunkSize = std::max(maxChunkSize, chunk.second - chunk.first);
+    size_t numPieces = std::max((size_t)1, (maxChunkSize + ringPieceSize_ - 1) / ringPieceSize_);
+
+    std::vector<std::vector<size_t>> stepsDone(numGraphs, std::vector<size_t>(numPieces, 0)); // [graph][piece]
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    auto run = [&](size_t j) {
+      size_t i = (j + numGraphs - 1) % numGraphs; // predecessor
+      for(size_t k = 0; k + 1 < numGraphs; ++k) {
+        const auto& chunk = chunks[(j + 2 * numGraphs - k - 1 - shift) % numGraphs];
+        for(size_t p = 0; p < numPieces; ++p) {
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return stepsDone[i][p] >= k; });
+          }
+          size_t begin = std::min(chunk.first + p * ringPieceSize_, chunk.second);
+          size_t end = std::min(begin + ringPieceSize_, chunk.second);
+          if(begin < end) {
+            stepFn(j, i, begin, end);
+            // the work is only queued on GPUs; the successor reads this piece in the next step
+            auto backend = graphs_[j]->getBackend();
+            backend->setDevice();
+            backend->synchronize();
+          }
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            stepsDone[j][p] = k + 1;
+          }
+          cv.notify_all();
+        }
+      }
+    };
+
+    std::vector<std::thread> group;
+    for(size_t j = 0; j < numGraphs; ++j)
+      group.emplace_back(run, j);
+    for(auto& t : group)
+      t.join();
+  }
+
+  // shard boundaries, clipped to [rangeBegin, rangeEnd)
+  std::vector<std::pair<size_t, size_t>> getChunks(size_t rangeBegin, size_t rangeEnd) const {
+    std::vector<std::pair<size_t, size_t>> chunks(graphs_.size());
+    foreach([&](size_t idx, size_t shardBegin, size_t shardEnd) {
+      size_t begin = std::max(rangeBegin, shardBegin);
+      size_t end = std::max(begin, std::min(rangeEnd, shardEnd));
+      chunks[idx] = std::make_pair(begin, end);
+    }, /*parallel=*/false);
+    return chunks;
+  }
+
 public:
   DefaultCommunicator(const std::vector<Ptr<ExpressionGraph>>& graphs, Ptr<IMPIWrapper> mpi)
       : ICommunicator(graphs) {
@@ -154,24 +230,32 @@ public:
   }
 
   void scatterReduceAndResetGrads() const override {
-    const_cast<DefaultCommunicator*>(this)->lazyInit();
+    timer::ScopedPhase phase(timer::Phase::communication);
+    scatterReduceRange(0, graphs_[0]->params()->grads()->size());
+    resetGrads();
+  }
 
-    // Gather gradients from different devices into current gradient shards
-    auto scatter = [this](size_t idx, size_t begin, size_t end) {
-      auto curGrad = graphs_[idx]->params()->grads()->subtensor(begin, end-begin);
+  bool canScatterReduceRange() const override { return true; }
 
-      // collect and sum gradients
-      for(auto graph : graphs_) {
-        if(graph != graphs_[idx]) {
-          auto subGrad = graph->params()->grads()->subtensor(begin, end - begin);
-          tmpTensors_[idx]->copyFrom(subGrad);
+  // ring reduce-scatter: each graph adds its predecessor's partial sum of a chunk to its own
+  void scatterReduceRange(size_t rangeBegin, size_t rangeEnd) const override {
+    timer::ScopedPhase phase(timer::Phase::communication);
+    const_cast<DefaultCommunicator*>(this)->lazyInit();
 
-          using namespace functional;
-          Element(_1 = _1 + _2, curGrad, tmpTensors_[idx]);
-        }
-      }
+    auto reduce = [this](size_t receiver, size_t sender, size_t begin, size_t end) {
+      auto curGrad = graphs_[receiver]->params()->grads()->subtensor(begin, end - begin);
+      auto subGrad = graphs_[sender]->params()->grads()->subtensor(begin, end - begin);
+      auto tmp = tmpTensors_[receiver]->subtensor(0, end - begin);
+      tmp->copyFrom(subGrad);
+
+      using namespace functional;
+      Element(_1 = _1 + _2, curGrad, tmp);
     };
 
+    ring(getChunks(rangeBegin, rangeEnd), /*shift=*/1, reduce);
+  }
+
+  void resetGrads() const override {
     // reset gradients outside current shard
     auto reset = [this](size_t idx, size_t begin, size_t end) {
       auto grad = graphs_[idx]->params()->grads();
@@ -181,32 +265,22 @@ public:
         grad->subtensor(end, grad->size()-end)->set(0);
     };
 
-    foreach(scatter);
     foreach(reset);
   }
 
+  // ring all-gather: each graph passes on the parameter shards it has received
   void allGatherParams() const override {
-
-    // Update all graphs with parameter shard
-    auto gather = [this](size_t idx, size_t begin, size_t end) {
-      auto getShard = [&](Ptr<ExpressionGraph> graph) {
-        return graph->params()->vals()->subtensor(begin, end-begin);
-      };
-      auto curShard = getShard(graphs_[idx]);
-
-      // Copy parameter shard to each graph
-      for(auto graph : graphs_) {
-        if(graph != graphs_[idx]) {
-          auto subShard = getShard(graph);
-          subShard->copyFrom(curShard);
-        }
-      }
+    timer::ScopedPhase phase(timer::Phase::communication);
+    auto gather = [this](size_t receiver, size_t sender, size_t begin, size_t end) {
+      auto subShard = graphs_[receiver]->params()->vals()->subtensor(begin, end - begin);
+      subShard->copyFrom(graphs_[sender]->params()->vals()->subtensor(begin, end - begin));
     };
 
-    foreach(gather);
+    ring(getChunks(0, graphs_[0]->params()->vals()->size()), /*shift=*/0, gather);
   }
 
   void swapParams(const std::vector<Tensor>& paramShards) const override {
+    timer::ScopedPhase phase(timer::Phase::communication);
     // Update all graphs with parameter shard
     auto gather = [this, paramShards](size_t idx, size_t begin, size_t end) {
       ABORT_IF(end - begin != paramShards[idx]->size(), "inconsistent shard size (swapParams, [{}], {} vs {})??", idx, end-begin, paramShards[idx]->size());
@@ -5,6 +5,7 @@
 #include "tensors/gpu/cuda_helpers.h"
 
 #include "common/timer.h"
+#include "common/phase_timer.h"
 
 // Generated by NCCL make files in build/nccl/include;
 // include dir has been set in CMake files. NCCL add version number etc.
@@ -220,6 +221,7 @@ public:
   }
 
   void scatterReduceAndResetGrads() const override {
+    timer::ScopedPhase phase(timer::Phase::communication);
     synchronizeAllOnNullStream();
 
     groupStart();
@@ -256,6 +258,7 @@ public:
   // @TODO: For unknown reasons, this takes longer than any other operation incl. scatterReduceAndResetGrads().
   //        But both should have the same number of data transfers of the same size.
   void allGatherParams() const override {
+    timer::ScopedPhase phase(timer::Phase::communication);
     synchronizeAllOnNullStream();
 
     groupStart();
@@ -278,6 +281,7 @@ public:
   // It is assumed that all model params() on all devices and MPI processes are identical.
   // This is used for the smoothed parameters.
   void swapParams(const std::vector<Tensor>& distributedParamShards) const override {
+    timer::ScopedPhase phase(timer::Phase::communication);
     // get everything onto the CPU
     auto distributedParams = gatherState([&](size_t localDeviceIndex) {
       std::vector<float> tmp;
@@ -21,6 +21,14 @@ public:
 
 protected:
   void updateAvgParams(Tensor paramsAvg, Tensor params, size_t batches, size_t actualBatchTrgWords = OptimizerBase::mbSizeNotProvided) {
+    float decayBy = getAvgDecay(batches, actualBatchTrgWords);
+    using namespace functional;
+    Element(_1 = ((1.f - decayBy) * _1) + (decayBy * _2), paramsAvg, params);
+  }
+
+  // factor by which the smoothed parameters move towards the current ones in this update,
+  // e.g. for OptimizerBase::update() which can apply the smoothing within its update pass
+  float getAvgDecay(size_t batches, size_t actualBatchTrgWords = OptimizerBase::mbSizeNotProvided) {
     double beta = 1. - mvDecayBy_;
     // correction term if batch size is different from what mvDecayBy_ was specified for
     if (refBatchTrgWords_) {
@@ -34,10 +42,8 @@ protected:
       batches = std::max(batches, batches * actualBatchTrgWords / refBatchTrgWords_); // @BUGBUG: Does not consider that batch size is changing
     }
     // reduce effect of decay parameter in early training stages
-    float decayBy = std::max(1.f - (float)beta,
-                             1.f - (float)(batches + 1) / (float)(batches + 10));
-    using namespace functional;
-    Element(_1 = ((1.f - decayBy) * _1) + (decayBy * _2), paramsAvg, params);
+    return std::max(1.f - (float)beta,
+                    1.f - (float)(batches + 1) / (float)(batches + 10));
   }
 
   bool mvAvg_{false};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "3rd_party/threadpool.h"
+#include "graph/expression_graph.h"
+#include "training/communicator.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace marian {
+
+/**
+ * Overlaps the gradient reduction with the backward pass.
+ *
+ * The gradients of all parameters of a graph are one contiguous tensor, which is split into
+ * buckets of equal size. A parameter's gradient is complete once the backward tape reaches the
+ * parameter node. When this holds for all parameters overlapping a bucket on all local graphs,
+ * the bucket is reduced into the gradient shards on a communication thread, while the backward
+ * pass continues with the remaining buckets.
+ *
+ * Usage per update: start(), then backward() for the last backward pass of each graph (earlier
+ * passes with delayed updates only accumulate) and finish() for each graph, then wait().
+ */
+class GradientBuckets {
+private:
+  Ptr<ICommunicator> comm_;
+  std::vector<Ptr<ExpressionGraph>> graphs_;
+  size_t bucketSize_;  // in elements
+  size_t totalSize_{0};
+  size_t numBuckets_{0};
+
+  // [localDeviceIndex] param name -> (index, first bucket, last bucket)
+  struct ParamBuckets { size_t index, first, last; };
+  std::vector<std::unordered_map<std::string, ParamBuckets>> paramBuckets_;
+  std::vector<std::vector<size_t>> paramsPerBucket_; // [localDeviceIndex][bucket]
+
+  // bookkeeping for the current update
+  std::vector<std::vector<size_t>> pendingParams_; // [localDeviceIndex][bucket] params with incomplete gradients
+  std::vector<std::vector<bool>> paramDone_;       // [localDeviceIndex][param index]
+  std::vector<size_t> readyGraphs_;                // [bucket] number of graphs that have completed it
+
+  std::mutex mutex_;
+  ThreadPool commThread_{1};
+  std::vector<std::future<void>> reductions_;
+
+  void lazyInit() {
+    if(numBuckets_ > 0)
+      return;
+    totalSize_ = graphs_[0]->params()->grads()->size();
+    numBuckets_ = (totalSize_ + bucketSize_ - 1) / bucketSize_;
+
+    for(auto graph : graphs_) {
+      auto grads = graph->params()->grads();
+      ABORT_IF(grads->size() != totalSize_, "Inconsistent gradient sizes across graphs??");
+      std::unordered_map<std::string, ParamBuckets> buckets;
+      std::vector<size_t> counts(numBuckets_, 0);
+      for(auto p : *graph->params()) {
+        size_t begin = p->grad()->data() - grads->data(); // offset into the contiguous gradient
+        size_t end = begin + p->grad()->size();
+        ParamBuckets pb{buckets.size(), begin / bucketSize_, (end - 1) / bucketSize_};
+        for(size_t b = pb.first; b <= pb.last; ++b)
+          counts[b]++;
+        buckets[p->name()] = pb;
+      }
+      paramBuckets_.push_back(buckets);
+      paramsPerBucket_.push_back(counts);
+    }
+
+    LOG(info,
+        "[training] Reducing gradients in {} buckets of {} MB, overlapping with the backward pass",
+        numBuckets_, bucketSize_ * sizeof(float) / (1024 * 1024));
+  }
+
+  void bucketReady(size_t bucket) {
+    // caller holds mutex_
+    if(++readyGraphs_[bucket] < graphs_.size())
+      return;
+    size_t begin = bucket * bucketSize_;
+    size_t end = std::min(begin + bucketSize_, totalSize_);
+    auto comm = comm_;
+    reductions_.push_back(commThread_.enqueue([comm, begin, end]() {
+      comm->scatterReduceRange(begin, end);
+    }));
+  }
+
+  void paramReady(size_t localDeviceIndex, Expr param) {
+    auto it = paramBuckets_[localDeviceIndex].find(param->name());
+    if(it == paramBuckets_[localDeviceIndex].end()) // not part of the reduced gradients
+      return;
+    const auto& pb = it->second;
+    if(paramDone_[localDeviceIndex][pb.index])
+      return;
+    paramDone_[localDeviceIndex][pb.index] = true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(size_t b = pb.first; b <= pb.last; ++b)
+      if(--pendingParams_[localDeviceIndex][b] == 0)
+        bucketReady(b);
+  }
+
+public:
+  GradientBuckets(Ptr<ICommunicator> comm,
+                  const std::vector<Ptr<ExpressionGraph>>& graphs,
+                  size_t bucketSizeMB)
+      : comm_(comm),
+        graphs_(graphs),
+        bucketSize_(std::max((size_t)1, bucketSizeMB * 1024 * 1024 / sizeof(float))) {
+    ABORT_IF(!comm_->canScatterReduceRange(),
+             "This communicator does not support reducing gradients in buckets");
+  }
+
+  // reset the bookkeeping before the backward passes of an update
+  void start() {
+    lazyInit();
+    pendingParams_ = paramsPerBucket_;
+    paramDone_.clear();
+    for(const auto& buckets : paramBuckets_)
+      paramDone_.push_back(std::vector<bool>(buckets.size(), false));
+    readyGraphs_.assign(numBuckets_, 0);
+    reductions_.clear();
+  }
+
+  // final backward pass of this graph in the current update
+  void backward(size_t localDeviceIndex) {
+    auto graph = graphs_[localDeviceIndex];
+    graph->setParamGradientCallback([this, localDeviceIndex](Expr param) {
+      paramReady(localDeviceIndex, param);
+    });
+    graph->backward(/*zero=*/false);
+    graph->setParamGradientCallback(nullptr);
+  }
+
+  // this graph does not write gradients anymore; buckets of unused params are complete now
+  void finish(size_t localDeviceIndex) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(size_t b = 0; b < numBuckets_; ++b) {
+      // (buckets without any params, e.g. in alignment padding, are only completed here)
+      if(pendingParams_[localDeviceIndex][b] > 0 || paramsPerBucket_[localDeviceIndex][b] == 0) {
+        pendingParams_[localDeviceIndex][b] = 0;
+        bucketReady(b);
+      }
+    }
+  }
+
+  // wait until all buckets are reduced into the gradient shards
+  void wait() {
+    for(auto& reduction : reductions_)
+      reduction.get();
+    ABORT_IF(reductions_.size() != numBuckets_, "Not all gradient buckets were reduced??");
+    reductions_.clear();
+  }
+};
+
+}  // namespace marian
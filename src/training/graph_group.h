@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/definitions.h"
+#include "common/hash.h"
 #include "common/options.h"
 #include "data/batch_generator.h"
 #include "graph/expression_graph.h"
@@ -58,6 +59,22 @@ public:
                                      Ptr<models::ICriterionFunction> model,
                                      const std::vector<Ptr<Vocab>>& vocabs,
                                      double multiplier = 1.) {
+    // with --mini-batch-fit-cache, reuse statistics of a previous run with identical settings
+    auto cacheMode = options_->get<std::string>("mini-batch-fit-cache", "none");
+    std::string cacheFile = options_->get<std::string>("model") + ".batchstats.yml";
+    std::string cacheKey = batchStatsKey(options_, multiplier);
+    if(cacheMode != "none") {
+      auto cached = data::BatchStats::load(cacheFile, cacheKey);
+      if(!cached)
+        LOG(info, "[batching] No matching batch statistics found in {}", cacheFile);
+      else if(cacheMode == "validate" && !validateStats(cached, graph, model, vocabs, multiplier))
+        LOG(info, "[batching] Batch statistics from {} do not fit into workspace, recollecting", cacheFile);
+      else {
+        LOG(info, "[batching] Reusing batch statistics from {}", cacheFile);
+        return cached;
+      }
+    }
+
     auto stats = New<data::BatchStats>();
 
     size_t numFiles = options_->get<std::vector<std::string>>("train-sets").size();
@@ -121,9 +138,47 @@ public:
 
       maxBatch = start;
     }
+
+    if(cacheMode != "none")
+      stats->save(cacheFile, cacheKey);
     return stats;
   }
 
+  // Key identifying the settings that batch statistics depend on. This is a hash over the
+  // full configuration (which includes model architecture, workspace, devices and
+  // precision) minus options that are known not to affect memory use, plus the multiplier.
+  // The hash is FNV-1a, so that a cache file can be used by another build of Marian.
+  static std::string batchStatsKey(Ptr<const Options> options, double multiplier) {
+    static const std::vector<std::string> ignoredKeys = {
+        "mini-batch-fit-cache", "after-epochs", "after-batches", "disp-freq", "disp-first",
+        "save-freq", "valid-freq", "log", "valid-log", "log-level", "quiet", "seed",
+        "no-restore-corpus", "overwrite", "keep-best", "tempdir", "dump-config", "config"};
+    auto config = options->cloneToYamlNode();
+    for(const auto& key : ignoredKeys)
+      config.remove(key);
+    std::stringstream ss;
+    ss << config << "\nmultiplier: " << multiplier;
+    return std::to_string(util::fnv1a64(ss.str()));
+  }
+
+  // Quick check that cached statistics still fit: build the largest cached batch for the
+  // longest and the shortest cached sentence lengths and check for reallocation.
+  bool validateStats(Ptr<data::BatchStats> stats,
+                     Ptr<ExpressionGraph> graph,
+                     Ptr<models::ICriterionFunction> model,
+                     const std::vector<Ptr<Vocab>>& vocabs,
+                     double multiplier) {
+    std::vector<data::BatchStats::const_iterator> probes = {stats->begin(), std::prev(stats->end())};
+    for(auto it : probes) {
+      size_t batchSize = std::max((size_t)1, (size_t)std::floor((double)it->second / multiplier));
+      auto batch = data::CorpusBatch::fakeBatch(it->first, vocabs, batchSize, options_);
+      auto cost = model->build(graph, batch);
+      if(!graph->fits())
+        return false;
+    }
+    return true;
+  }
+
   void setTypicalTrgBatchWords(size_t typicalTrgBatchWords) { // needed for dynamic MB scaling
     typicalTrgBatchWords_ = typicalTrgBatchWords;
   }
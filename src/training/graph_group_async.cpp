@@ -10,15 +10,33 @@ AsyncGraphGroup::AsyncGraphGroup(Ptr<Options> config, Ptr<IMPIWrapper> mpi)
       ExponentialSmoothing(options_),
       devices_{Config::getDevices(options_)},
       shardSync_(devices_.size()),
+      compressGradients_(options_->get<bool>("async-compress-gradients", false)),
+      fetchedAt_(devices_.size(), 0),
       optimizerDelay_((size_t)options_->get<double>("optimizer-delay")) {
   ABORT_IF(mpi->numMPIProcesses() != 1, "AsyncGraphGroup presently does not support multiple MPI processes");
   ABORT_IF((double)optimizerDelay_ != options_->get<double>("optimizer-delay"), "AsyncGraphGroup presently does not implement fractional values for --optimizer-delay");
   pool_.reset(new ThreadPool(devices_.size(), devices_.size()));
+  shardPool_.reset(new ThreadPool(devices_.size()));
+
+  if(compressGradients_) {
+    // initial power of 2, window and factor, independent of the cost scaling of the model (--cost-scaling)
+    float scalePower = 7.f;
+    auto scaling = options_->get<std::vector<std::string>>("async-compress-scaling", std::vector<std::string>());
+    if(scaling.size() > 0)
+      scalePower = std::stof(scaling[0]);
+    if(scaling.size() > 1)
+      compressScaleWindow_ = std::stoul(scaling[1]);
+    if(scaling.size() > 2)
+      compressScaleFactor_ = std::stof(scaling[2]);
+    compressScale_.resize(devices_.size(), std::pow(2.f, scalePower));
+    compressNoOverflow_.resize(devices_.size(), 0);
+  }
 
   for(auto device : devices_) {
     auto graph = New<ExpressionGraph>();
     graph->setDevice(device);
     graph->setCheckpointing(options_->get<bool>("gradient-checkpointing"));
+    graph->setCheckpointingBudgetMB(options_->get<size_t>("gradient-checkpointing-budget"));
     graph->getBackend()->setClip(options_->get<float>("clip-gemm"));
     graph->reserveWorkspaceMB(options_->get<size_t>("workspace"));
     graphs_.push_back(graph);
@@ -37,55 +55,99 @@ void AsyncGraphGroup::setScheduler(Ptr<Scheduler> scheduler) {
     scheduler_->registerTrainingObserver(opt);
 }
 
+void AsyncGraphGroup::foreachShard(const std::function<void(size_t, int)>& fn) {
+  std::vector<std::future<void>> tasks;
+  int pos = 0;
+  for(size_t idx = 0; idx < devices_.size(); idx++) {
+    tasks.push_back(shardPool_->enqueue(fn, idx, pos));
+    pos += shardSize_;
+  }
+  for(auto& task : tasks)
+    task.get();
+}
+
 void AsyncGraphGroup::fetchParams(Tensor oldParams,
                                   const std::vector<Tensor>& params,
                                   int /*device_id*/) {
   // @TODO read guard on parameters
-  int pos = 0;
-
-  std::vector<std::thread> threads;
-  for(int idx = 0; idx < devices_.size(); idx++) {
-    threads.emplace_back(std::thread(
-        [&](int idx, int pos) {
-          // individual mutex per-shard
-          std::lock_guard<std::mutex> guard(shardSync_[idx]);
-          oldParams->subtensor((int)pos, (int)params[idx]->size())->copyFrom(params[idx]);
-        },
-        idx,
-        pos));
+  foreachShard([&](size_t idx, int pos) {
+    // individual mutex per-shard
+    std::lock_guard<std::mutex> guard(shardSync_[idx]);
+    oldParams->subtensor(pos, (int)params[idx]->size())->copyFrom(params[idx]);
+  });
+}
 
-    pos += shardSize_;
-  }
-  for(auto&& t : threads) {
-    t.join();
+bool AsyncGraphGroup::pushGradients(Tensor newGrads,
+                                    int device_id) {
+  // with compression, send half the bytes and convert back to float32 on the shard. The gradients
+  // are scaled into the float16 range before the cast; if they overflow, the update is skipped and
+  // the scale reduced, as in mixed precision training with dynamic cost scaling.
+  float scale = 1.f;
+  if(compressGradients_) {
+    using namespace functional;
+    scale = compressScale_[device_id];
+    Element(_1 = _1 * scale, newGrads);
+    CopyCast(compressedGrads_[device_id], newGrads);
+
+    bool isNaN = false, isInf = false;
+    IsNaN(compressedGrads_[device_id], graphs_[device_id]->allocator(), isNaN, isInf);
+    if(isNaN || isInf) {
+      compressScale_[device_id] /= compressScaleFactor_;
+      compressNoOverflow_[device_id] = 0;
+      LOG(warn,
+          "[training] float16 gradients of worker {} overflowed, skipping update and reducing scale to {}",
+          device_id,
+          compressScale_[device_id]);
+      return false;
+    }
+    if(++compressNoOverflow_[device_id] == compressScaleWindow_) {
+      compressScale_[device_id] *= compressScaleFactor_;
+      compressNoOverflow_[device_id] = 0;
+    }
+    newGrads = compressedGrads_[device_id];
   }
-}
 
-void AsyncGraphGroup::pushGradients(Tensor newGrads,
-                                    int /*device_id*/) {
   // add instead of copy?
-  std::vector<std::thread> threads;
-  int pos = 0;
-  for(int idx = 0; idx < devices_.size(); idx++) {
-    threads.emplace_back(std::thread(
-        [&](int idx, int pos) {
-          // individual mutex per-shard
-          std::lock_guard<std::mutex> guard(shardSync_[idx]);
-          grads_[idx]->copyFrom(newGrads->subtensor(pos, (int)grads_[idx]->size()));
-
-          shardOpt_[idx]->update(params_[idx], grads_[idx]);
-
-          if(mvAvg_)
-            updateAvgParams(
-                paramsAvg_[idx], params_[idx], scheduler_->numberOfBatches());
-        },
-        idx,
-        pos));
+  foreachShard([&](size_t idx, int pos) {
+    auto grads = newGrads->subtensor(pos, (int)grads_[idx]->size());
+    // individual mutex per-shard
+    std::lock_guard<std::mutex> guard(shardSync_[idx]);
+    if(compressGradients_) {
+      using namespace functional;
+      compressedShards_[idx]->copyFrom(grads);
+      CopyCast(grads_[idx], compressedShards_[idx]);
+      Element(_1 = _1 * (1.f / scale), grads_[idx]);
+    } else {
+      grads_[idx]->copyFrom(grads);
+    }
 
-    pos += shardSize_;
-  }
-  for(auto&& t : threads)
-    t.join();
+    shardOpt_[idx]->update(params_[idx], grads_[idx]);
+
+    if(mvAvg_)
+      updateAvgParams(
+          paramsAvg_[idx], params_[idx], scheduler_->numberOfBatches());
+  });
+  return true;
+}
+
+void AsyncGraphGroup::recordStaleness(size_t staleness) {
+  std::lock_guard<std::mutex> lock(stalenessMutex_);
+  stalenessSum_ += staleness;
+  stalenessMax_ = std::max(stalenessMax_, staleness);
+  stalenessCount_++;
+}
+
+void AsyncGraphGroup::reportStaleness() {
+  std::lock_guard<std::mutex> lock(stalenessMutex_);
+  if(stalenessCount_ == 0)
+    return;
+  LOG(info,
+      "Staleness : avg. {:.2f} : max. {} updates between fetch and push",
+      stalenessSum_ / (double)stalenessCount_,
+      stalenessMax_);
+  stalenessSum_ = 0;
+  stalenessMax_ = 0;
+  stalenessCount_ = 0;
 }
 
 void AsyncGraphGroup::init(Ptr<data::Batch> batch) {
@@ -140,6 +202,26 @@ void AsyncGraphGroup::init(Ptr<data::Batch> batch) {
       grads_.push_back(grad);
     }
   }
+  if(compressGradients_ && compressedGrads_.empty()) {
+    int totalSize = (int)graphs_[0]->params()->vals()->size();
+    int remaining = totalSize;
+
+    for(auto graph : graphs_) {
+      int __size__ = std::min(shardSize_, remaining);
+      remaining -= __size__;
+      Tensor compressedGrad, compressedShard;
+      Ptr<TensorAllocator> allocator
+          = New<TensorAllocator>(graph->getBackend());
+
+      allocator->reserveExact({totalSize * sizeOf(Type::float16), __size__ * sizeOf(Type::float16)});
+      allocator->allocate(compressedGrad, {1, totalSize}, Type::float16);
+      allocator->allocate(compressedShard, {1, __size__}, Type::float16);
+      compressedAlloc_.push_back(allocator);
+      compressedGrads_.push_back(compressedGrad);
+      compressedShards_.push_back(compressedShard);
+    }
+    LOG(info, "[training] Sending gradients to the parameter shards as float16");
+  }
   if(mvAvg_ && paramsAvg_.empty()) {
     Ptr<ExpressionGraph> graphAvg;
     std::string name = options_->get<std::string>("model");
@@ -210,6 +292,7 @@ void AsyncGraphGroup::execute(Ptr<data::Batch> batch) {
     Ptr<RationalLoss> dynamicLoss = builder->build(graph, batch);
 
     if(t % optimizerDelay_ == 0) {
+      fetchedAt_[t_id] = updatesApplied_;
       fetchParams(graph->params()->vals(), params_, t_id);
     }
 
@@ -240,7 +323,8 @@ void AsyncGraphGroup::execute(Ptr<data::Batch> batch) {
     t++;
 
     if(t % optimizerDelay_ == 0) {
-      pushGradients(gradients, t_id);
+      if(pushGradients(gradients, t_id)) // skipped updates do not count for the staleness
+        recordStaleness(updatesApplied_++ - fetchedAt_[t_id]);
       // Reset the counter of seen target words after gradient update
       if(optimizerDelay_ > 1)
         gradients->set(0);
@@ -266,6 +350,9 @@ void AsyncGraphGroup::execute(Ptr<data::Batch> batch) {
         scheduler_->update(loss, batch);
       }
 
+      if(scheduler_->displaying())
+        reportStaleness();
+
       loss.reset();
 
       if(scheduler_->saving() || scheduler_->validating()) {
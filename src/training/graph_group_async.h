@@ -4,6 +4,8 @@
 #include "training/exponential_smoothing.h"
 #include "training/graph_group.h"
 
+#include <atomic>
+#include <functional>
 #include <future>
 #include <thread>
 
@@ -39,13 +41,42 @@ protected:
   std::vector<Ptr<TensorAllocator>> paramsAllocAvg_;
   std::unique_ptr<ThreadPool> pool_;
 
+  // persistent thread team for copying parameters and gradients from/to the shards
+  std::unique_ptr<ThreadPool> shardPool_;
+
+  // optional transfer of gradients to the shards as float16 (--async-compress-gradients)
+  bool compressGradients_{false};
+  std::vector<Tensor> compressedGrads_;  // [device] all gradients of that device's worker
+  std::vector<Tensor> compressedShards_; // [shard] receive buffer on the shard's device
+  std::vector<Ptr<TensorAllocator>> compressedAlloc_;
+  // dynamic scaling of the gradients into the float16 range, per worker (--async-compress-scaling)
+  std::vector<float> compressScale_;       // [device] current scale
+  std::vector<size_t> compressNoOverflow_; // [device] pushes since the last overflow or scale increase
+  size_t compressScaleWindow_{2000};       // increase the scale after this many pushes without overflow
+  float compressScaleFactor_{2.f};         // by this factor, and decrease it by this factor on overflow
+
+  // staleness: number of updates applied by other workers between a worker's fetch and its push
+  std::atomic<size_t> updatesApplied_{0};
+  std::vector<size_t> fetchedAt_; // [device] value of updatesApplied_ at the last fetch
+  std::mutex stalenessMutex_;
+  size_t stalenessSum_{0};
+  size_t stalenessMax_{0};
+  size_t stalenessCount_{0};
+
   size_t optimizerDelay_{1};
 
+  // run fn(idx, pos) for all shards on the shard thread team and wait for completion
+  void foreachShard(const std::function<void(size_t /*idx*/, int /*pos*/)>& fn);
+
+  void recordStaleness(size_t staleness);
+  void reportStaleness();
+
   virtual void fetchParams(Tensor oldParams,
                            const std::vector<Tensor>& params,
                            int device_id);
 
-  virtual void pushGradients(Tensor newGrads,
+  // returns false if the update was skipped
+  virtual bool pushGradients(Tensor newGrads,
                              int device_id);
 
   virtual void init(Ptr<data::Batch> batch);
@@ -17,77 +17,54 @@ void AsyncGraphGroupDrop::fetchParams(Tensor oldParams,
     return;
   }
 
-  std::vector<std::thread> threads;
-  int pos = 0;
-  for(int idx = 0; idx < devices_.size(); idx++) {
-    threads.emplace_back(std::thread(
-        [=](int idx, int pos) {
-          auto sparseGrad = sparseGrads_[device_id][idx];
-          auto sparseShard = sparseShards_[device_id][idx];
-
-          // individual mutex per-shard
-          std::lock_guard<std::mutex> guard(shardSync_[idx]);
-
-          sparseShard->gather(params[idx]);
-          sparseGrad->copyFrom(sparseShard);
-          sparseGrad->scatterUpdate(
-              oldParams->subtensor((int)pos, (int)params[idx]->size()));
-        },
-        idx,
-        pos));
-
-    pos += shardSize_;
-  }
-  for(size_t i = 0; i < threads.size(); i++)
-    threads[i].join();
+  foreachShard([=](size_t idx, int pos) {
+    auto sparseGrad = sparseGrads_[device_id][idx];
+    auto sparseShard = sparseShards_[device_id][idx];
+
+    // individual mutex per-shard
+    std::lock_guard<std::mutex> guard(shardSync_[idx]);
+
+    sparseShard->gather(params[idx]);
+    sparseGrad->copyFrom(sparseShard);
+    sparseGrad->scatterUpdate(
+        oldParams->subtensor(pos, (int)params[idx]->size()));
+  });
 }
 
-void AsyncGraphGroupDrop::pushGradients(Tensor newGrads,
+bool AsyncGraphGroupDrop::pushGradients(Tensor newGrads,
                                         int device_id) {
-  if(pushStep_[device_id]++ < dropping_warmup) {
-    AsyncGraphGroup::pushGradients(newGrads, device_id);
-    return;
-  }
+  if(pushStep_[device_id]++ < dropping_warmup)
+    return AsyncGraphGroup::pushGradients(newGrads, device_id);
 
   // add instead of copy?
-  std::vector<std::thread> threads;
-  int pos = 0;
-  for(int idx = 0; idx < devices_.size(); idx++) {
-    threads.emplace_back(std::thread(
-        [=](int idx, int pos) {
-          auto dropper = droppers_[device_id][idx];
-          auto sparseGrad = sparseGrads_[device_id][idx];
-          auto sparseShard = sparseShards_[device_id][idx];
-          auto tensor = newGrads->subtensor((int)pos, (int)grads_[idx]->size());
-          // individual mutex per-shard
-          std::lock_guard<std::mutex> guard(shardSync_[idx]);
-
-          // drop the gradients
-          dropper->dropGraph(
-              tensor, sparseGrad, droping_rate, dropping_momentum);
-
-          // send the sharded sparse tensor
-          sparseShard->copyFrom(sparseGrad);
-
-          // convert back to dense, store it in grads_[idx]
-          // sparseShard indices is equal to the indices of the sparse gradient
-          // which will be used for sparse fetching
-          sparseShard->toDense(grads_[idx]);
-
-          // optimize
-          shardOpt_[idx]->update(params_[idx], grads_[idx]);
-
-          if(mvAvg_)
-            updateAvgParams(
-                paramsAvg_[idx], params_[idx], scheduler_->numberOfBatches());
-        },
-        idx,
-        pos));
-
-    pos += shardSize_;
-  }
-  for(auto&& t : threads)
-    t.join();
+  foreachShard([=](size_t idx, int pos) {
+    auto dropper = droppers_[device_id][idx];
+    auto sparseGrad = sparseGrads_[device_id][idx];
+    auto sparseShard = sparseShards_[device_id][idx];
+    auto tensor = newGrads->subtensor(pos, (int)grads_[idx]->size());
+    // individual mutex per-shard
+    std::lock_guard<std::mutex> guard(shardSync_[idx]);
+
+    // drop the gradients
+    dropper->dropGraph(
+        tensor, sparseGrad, droping_rate, dropping_momentum);
+
+    // send the sharded sparse tensor
+    sparseShard->copyFrom(sparseGrad);
+
+    // convert back to dense, store it in grads_[idx]
+    // sparseShard indices is equal to the indices of the sparse gradient
+    // which will be used for sparse fetching
+    sparseShard->toDense(grads_[idx]);
+
+    // optimize
+    shardOpt_[idx]->update(params_[idx], grads_[idx]);
+
+    if(mvAvg_)
+      updateAvgParams(
+          paramsAvg_[idx], params_[idx], scheduler_->numberOfBatches());
+  });
+  return true;
 }
 
 void AsyncGraphGroupDrop::init(Ptr<data::Batch> batch) {
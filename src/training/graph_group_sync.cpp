@@ -1,4 +1,11 @@
 #include "training/graph_group_sync.h"
+#include "common/phase_timer.h"
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
 
 namespace marian {
 
@@ -11,6 +18,7 @@ SyncGraphGroup::SyncGraphGroup(Ptr<Options> config, Ptr<IMPIWrapper> mpi)
     auto graph = New<ExpressionGraph>();
     graph->setDevice(device);
     graph->setCheckpointing(options_->get<bool>("gradient-checkpointing"));
+    graph->setCheckpointingBudgetMB(options_->get<size_t>("gradient-checkpointing-budget"));
     graph->reserveWorkspaceMB(options_->get<size_t>("workspace"));
     graph->getBackend()->setClip(options_->get<float>("clip-gemm"));
 
@@ -29,6 +37,26 @@ SyncGraphGroup::SyncGraphGroup(Ptr<Options> config, Ptr<IMPIWrapper> mpi)
     LOG(info, "[training] Using {} {}, distributed over {} MPI processes", mpi_->numMPIProcesses() * devices_.size(), formattedDeviceType, mpi_->numMPIProcesses());
   else
     LOG(info, "[training] Using {} {}", devices_.size(), formattedDeviceType);
+
+  size_t bucketSizeMB = options_->get<size_t>("gradient-bucket-mb", 0);
+  if(bucketSizeMB > 0) {
+    if(comm_->canScatterReduceRange() && mpi_->numMPIProcesses() == 1)
+      gradBuckets_ = New<GradientBuckets>(comm_, graphs_, bucketSizeMB);
+    else
+      LOG(warn, "[training] Communicator does not support gradient buckets, reducing gradients after the backward pass");
+  }
+
+  shardedCheckpoints_ = options_->get<bool>("sharded-checkpoints", false);
+
+  maxPendingSaves_ = options_->get<size_t>("save-async", 0);
+  if(maxPendingSaves_ > 0) {
+    saveThread_.reset(new ThreadPool(1));
+    saveBuilder_ = models::createCriterionFunctionFromOptions(options_, models::usage::training);
+  }
+}
+
+SyncGraphGroup::~SyncGraphGroup() {
+  waitForPendingSaves(0);
 }
 
 void SyncGraphGroup::setScheduler(Ptr<Scheduler> scheduler) /*override*/ {
@@ -66,7 +94,7 @@ void SyncGraphGroup::initializeAvg() {
   std::string suffix = name.substr(name.size() - 4);
   ABORT_IF(suffix != ".npz" && suffix != ".bin", "Unknown model suffix {}", suffix);
 
-  if(filesystem::exists(name + ".orig" + suffix)) {
+  if(loadedParamsAvg_.empty() && filesystem::exists(name + ".orig" + suffix)) {
     // Load the averaged parameters into a temporary graph
     graphAvg = New<ExpressionGraph>();
     graphAvg->setDevice({0, DeviceType::cpu});
@@ -92,7 +120,10 @@ void SyncGraphGroup::initializeAvg() {
     paramsAllocator->allocate(paramAvg, {1, (int)size});
     paramsAvg_[localDeviceIndex] = paramAvg;
 
-    if(graphAvg)
+    if(!loadedParamsAvg_.empty()) // restored from a sharded checkpoint
+      paramAvg->set(std::vector<float>(loadedParamsAvg_.begin() + (begin - loadedParamsAvgOffset_),
+                                       loadedParamsAvg_.begin() + (end - loadedParamsAvgOffset_)));
+    else if(graphAvg)
       paramAvg->copyFrom(graphAvg  ->params()->vals()->subtensor(begin, size));
     else
       paramAvg->copyFrom(graphs_[0]->params()->vals()->subtensor(begin, size));
@@ -104,6 +135,7 @@ void SyncGraphGroup::initializeAvg() {
   paramsAllocs_.resize(graphs_.size()); // allocators
   paramsAvg_.resize(graphs_.size());    // averaged parameters (shards; distributed over MPI processes if applicable)
   comm_->foreach(init, /*parallel=*/false); // @TODO: is sequential operation necessary here? (is the allocation stuff sufficiently reentrant or thread-separated?)
+  loadedParamsAvg_ = std::vector<float>();
 }
 
 Ptr<data::BatchStats> SyncGraphGroup::collectStats(const std::vector<Ptr<Vocab>>& vocabs) {
@@ -302,12 +334,18 @@ void SyncGraphGroup::update(std::vector<Ptr<data::Batch>> subBatches, size_t num
     LOG(info, "[training] Batches are processed as {} process(es) x {} devices/process",
         mpi_->numMPIProcesses(), devices_.size());
     initialize(subBatches.front());
+    if(!shardsToLoad_.empty()) {
+      loadShards(shardsToLoad_);
+      shardsToLoad_.clear();
+    }
     if(mvAvg_ && paramsAvg_.empty())
       initializeAvg();
     first_ = false;
   }
 
   // Compute gradients
+  if(gradBuckets_)
+    gradBuckets_->start();
   std::vector<StaticLoss> localDeviceLosses(devices_.size()); // [local device index] aggregate cost for each local device
   comm_->foreach([&](size_t localDeviceIndex, size_t /*begin*/, size_t /*end*/) { // parallel across devices. Aggregate for warp > 1.
     auto graph = graphs_[localDeviceIndex];
@@ -325,9 +363,18 @@ void SyncGraphGroup::update(std::vector<Ptr<data::Batch>> subBatches, size_t num
       graph->forward();
 
       localDeviceLosses[localDeviceIndex] += *rationalLoss;
-      graph->backward(/*zero=*/false); // (gradients are reset before we get here)
+      // with gradient buckets, the last backward pass starts reducing completed buckets right away
+      bool lastWarp = !getSubBatch(warp + 1, localDeviceIndex, mpi_->myMPIRank());
+      if(gradBuckets_ && lastWarp)
+        gradBuckets_->backward(localDeviceIndex);
+      else
+        graph->backward(/*zero=*/false); // (gradients are reset before we get here)
     }
+    if(gradBuckets_)
+      gradBuckets_->finish(localDeviceIndex);
   });
+  if(gradBuckets_)
+    gradBuckets_->wait(); // gradient shards are reduced now
   // At this point, each device on each MPI process has a gradient aggregated over a subset of the sub-batches.
 
   // Update parameter shard with gradient shard
@@ -341,12 +388,13 @@ void SyncGraphGroup::update(std::vector<Ptr<data::Batch>> subBatches, size_t num
           batchTrgWords
         /*else*/:
           OptimizerBase::mbSizeNotProvided;
-    shardOpt_[idx]->update(curParam, curGrad, updateTrgWords);
-    curGrad->set(0.f);
-
+    // exponential smoothing is applied by the optimizer, within the same pass as the update
     if(mvAvg_)
-      updateAvgParams(
-          paramsAvg_[idx], curParam, scheduler_->numberOfBatches(), updateTrgWords);
+      shardOpt_[idx]->update(curParam, curGrad, updateTrgWords,
+                             paramsAvg_[idx], getAvgDecay(scheduler_->numberOfBatches(), updateTrgWords));
+    else
+      shardOpt_[idx]->update(curParam, curGrad, updateTrgWords);
+    curGrad->set(0.f);
   };
 
   // cost across all local devices (scheduler will aggregate cross-process)
@@ -356,12 +404,18 @@ void SyncGraphGroup::update(std::vector<Ptr<data::Batch>> subBatches, size_t num
 
   // model update
   if (std::isfinite(localLoss.loss) || mpi_->numMPIProcesses() > 1) { // guard against NaN (except with MPI, as this simple way could hang it)
-    comm_->scatterReduceAndResetGrads(); // reduce gradients across all devices and MPI nodes into shards
+    if(gradBuckets_)
+      comm_->resetGrads();               // gradients were reduced into shards during the backward pass
+    else
+      comm_->scatterReduceAndResetGrads(); // reduce gradients across all devices and MPI nodes into shards
     comm_->foreach(update);              // per-shard model-update
     comm_->allGatherParams();            // distribute param value shards back
   }
-  else
+  else {
     LOG(info, "[training] skipping {}-th update due to loss being {}", scheduler_->numberOfBatches(), localLoss.loss);
+    // the gradients of this update, reduced into the shards or not, must not carry over to the next
+    comm_->foreach([&](size_t idx, size_t /*begin*/, size_t /*end*/) { graphs_[idx]->params()->set_zero_adjoint(); });
+  }
 
   if(scheduler_) {
     // track and log localLoss
@@ -382,6 +436,8 @@ void SyncGraphGroup::update(std::vector<Ptr<data::Batch>> subBatches, size_t num
   }
 }
 
+static std::string shardManifestFileName(const std::string& name); // see sharded checkpoints below
+
 void SyncGraphGroup::load() /*override*/ {
   validate();
 
@@ -412,10 +468,13 @@ void SyncGraphGroup::load() /*override*/ {
       std::vector<Ptr<Backend>> backends;
       for(auto graph : graphs_)
         backends.push_back(graph->getBackend());
-      shardOpt_[0]->load(name + ".optimizer.npz", shardOpt_, backends, // keep npz suffix for optimize checkpoint
-        [&](const std::vector<float>& optimizerStateVector, const OptimizerBase::ScatterStateSetFunc& setShardFn) {
-          comm_->scatterState(optimizerStateVector, setShardFn);
-        });
+      if(shardedCheckpoints_ && filesystem::exists(shardManifestFileName(name)))
+        shardsToLoad_ = name; // the shard ranges are only known once the parameters are allocated
+      else
+        shardOpt_[0]->load(name + ".optimizer.npz", shardOpt_, backends, // keep npz suffix for optimize checkpoint
+          [&](const std::vector<float>& optimizerStateVector, const OptimizerBase::ScatterStateSetFunc& setShardFn) {
+            comm_->scatterState(optimizerStateVector, setShardFn);
+          });
       LOG(info, "[training] Model reloaded from {}", name);
     } else if(options_->hasAndNotEmpty("pretrained-model")) {
       std::string nameInit = options_->get<std::string>("pretrained-model");
@@ -431,6 +490,7 @@ void SyncGraphGroup::load() /*override*/ {
 }
 
 void SyncGraphGroup::save(bool final) /*override*/ {
+  timer::ScopedPhase phase(timer::Phase::save);
   // validate(); @TODO: get rid of this everywhere (SyncGraphGroup)
   barrier(); // (for better grouping of log messages)
   // do final validation
@@ -451,6 +511,15 @@ void SyncGraphGroup::save(bool final) /*override*/ {
   std::string suffix = name.substr(name.size() - 4);
   ABORT_IF(suffix != ".npz" && suffix != ".bin", "Unknown model suffix {}", suffix);
 
+  if(saveThread_) {
+    if(!final) {
+      saveAsync(name, suffix);
+      return;
+    }
+    // the final model is saved synchronously, after all earlier checkpoints have been written
+    waitForPendingSaves(0);
+  }
+
   barrier(); // (for better grouping of log messages)
   // if smoothing then save original (unsmoothed) parameters as well
   if(mvAvg_ && paramsAvg_.size() > 0 && isMainProcess()) // only save from one MPI process
@@ -485,15 +554,332 @@ void SyncGraphGroup::save(bool final) /*override*/ {
   barrier(); // (for better grouping of log messages)
 
   // persist optimizer state
-  shardOpt_[0]->save(name + ".optimizer.npz", shardOpt_,
-    [&](const OptimizerBase::GatherStateGetFunc& getShardFn) {
-      return comm_->gatherState(getShardFn);
-    },
-    isMainProcess());
+  if(shardedCheckpoints_) {
+    // all MPI processes write their own shard in parallel, then the main process lists them
+    size_t begin, end;
+    getLocalShardRange(begin, end);
+    auto manifest = getShardManifest(begin, end);
+    writeShard(name, getLocalShardItems(), "");
+    barrier();
+    if(isMainProcess())
+      writeShard(name, {}, manifest);
+  } else {
+    shardOpt_[0]->save(name + ".optimizer.npz", shardOpt_,
+      [&](const OptimizerBase::GatherStateGetFunc& getShardFn) {
+        return comm_->gatherState(getShardFn);
+      },
+      isMainProcess());
+  }
 
   barrier(); // (for better grouping of log messages)
 }
 
+// Snapshot-then-write checkpointing: copy the original and the smoothed parameters as well as
+// the optimizer state into CPU memory, and let training continue while saveThread_ writes them
+// in the same layout as the synchronous save() above. The snapshot still needs the barriers and
+// the parameter swaps, but not the time spent on serializing and writing files.
+void SyncGraphGroup::saveAsync(const std::string& name, const std::string& suffix) {
+  // bound the number of snapshots in memory by waiting for the oldest ones to be written
+  waitForPendingSaves(maxPendingSaves_ - 1);
+
+  barrier(); // (for better grouping of log messages)
+  auto origItems = New<std::vector<io::Item>>();
+  if(mvAvg_ && paramsAvg_.size() > 0 && isMainProcess())
+    graphs_[0]->save(*origItems);
+
+  // copy the averaged parameters; note: the swap must run on all MPI processes
+  auto items = New<std::vector<io::Item>>();
+  swapParamsAvg();
+  if(isMainProcess())
+    graphs_[0]->save(*items);
+  swapParamsAvg();
+
+  barrier(); // (for better grouping of log messages)
+
+  auto optItems = New<std::vector<io::Item>>();
+  if(shardedCheckpoints_) {
+    // the shards are written here and not on saveThread_: the manifest must not be written before
+    // all MPI processes have written their shards, and the barrier for that cannot be issued from
+    // the save threads while the training threads communicate. Each process only writes its part.
+    size_t begin, end;
+    getLocalShardRange(begin, end);
+    auto manifest = getShardManifest(begin, end);
+    writeShard(name, getLocalShardItems(), "");
+    barrier();
+    if(isMainProcess())
+      writeShard(name, {}, manifest);
+  } else {
+    *optItems = shardOpt_[0]->getStateItems(shardOpt_,
+      [&](const OptimizerBase::GatherStateGetFunc& getShardFn) {
+        return comm_->gatherState(getShardFn);
+      },
+      isMainProcess());
+  }
+
+  barrier(); // (for better grouping of log messages)
+
+  if(!isMainProcess()) // only the first MPI process writes files
+    return;
+
+  // if not overwrite then save a copy with number of updates in the model pathname
+  std::string nameOverwrite;
+  if(!options_->get<bool>("overwrite")) {
+    std::string numberOfBatches
+        = scheduler_ ? std::to_string(scheduler_->numberOfBatches())
+                     : "unknown";
+    nameOverwrite = name;
+    nameOverwrite.replace(name.size() - 4, 4, ".iter" + numberOfBatches + suffix);
+  }
+
+  // training progress is captured now, as it changes while the files are written
+  std::string optionsYaml;
+  Ptr<TrainingState> state;
+  if(scheduler_) {
+    optionsYaml = scheduler_->getOptionsAsYamlString();
+    state = New<TrainingState>(scheduler_->getTrainingState());
+  }
+
+  LOG(info, "[training] Writing checkpoint {} in the background", name);
+  auto builder = saveBuilder_;
+  pendingSaves_.push_back(saveThread_->enqueue([=]() {
+    // load into a CPU-side graph, so that the builder can apply model-specific saving functions
+    auto saveModel = [&](std::vector<io::Item>& modelItems, const std::vector<std::string>& names) {
+      auto graph = New<ExpressionGraph>();
+      graph->setDevice({0, DeviceType::cpu});
+      graph->load(modelItems, false);
+      graph->forward(); // initialize parameters
+      modelItems.clear();
+      for(const auto& modelName : names)
+        builder->save(graph, modelName, /*saveTranslatorConfig=*/modelName == names.back());
+    };
+
+    if(!origItems->empty())
+      saveModel(*origItems, {name + ".orig" + suffix});
+
+    if(nameOverwrite.empty())
+      saveModel(*items, {name});
+    else
+      saveModel(*items, {nameOverwrite, name});
+
+    if(state)
+      Scheduler::save(name, optionsYaml, *state);
+
+    if(!optItems->empty()) {
+      LOG(info, "Saving optimizer parameters to {}", name + ".optimizer.npz");
+      io::saveItems(name + ".optimizer.npz", *optItems);
+    }
+  }));
+}
+
+// Sharded checkpoints: the optimizer state and the smoothed parameters are sharded over the MPI
+// processes in memory anyway. With --sharded-checkpoints, every MPI process writes its part of
+// them to model.npz.optimizer.shard<rank>.npz, and the main process lists the shards and their
+// ranges in the parameter vector in the manifest model.npz.optimizer.shards.yml, along with
+// whether each item is sharded or replicated on all shards. No process has to hold or write the
+// full state, and the shards are written in parallel.
+
+static std::string shardFileName(const std::string& name, size_t rank) {
+  return name + ".optimizer.shard" + std::to_string(rank) + ".npz";
+}
+
+static std::string shardManifestFileName(const std::string& name) {
+  return name + ".optimizer.shards.yml";
+}
+
+// range of the parameter vector held by the local devices of this MPI process
+void SyncGraphGroup::getLocalShardRange(size_t& begin, size_t& end) {
+  begin = std::numeric_limits<size_t>::max();
+  end = 0;
+  size_t size = 0;
+  comm_->foreach([&](size_t /*localDeviceIndex*/, size_t shardBegin, size_t shardEnd) {
+    begin = std::min(begin, shardBegin);
+    end = std::max(end, shardEnd);
+    size += shardEnd - shardBegin;
+  }, /*parallel=*/false);
+  ABORT_IF(size != end - begin, "Shards of an MPI process are not contiguous??");
+}
+
+// optimizer state and smoothed parameters of the local devices, concatenated
+std::vector<io::Item> SyncGraphGroup::getLocalShardItems() {
+  auto localGather = [&](const OptimizerBase::GatherStateGetFunc& getShardFn) {
+    std::vector<float> data;
+    for(size_t localDeviceIndex = 0; localDeviceIndex < graphs_.size(); localDeviceIndex++) {
+      std::vector<float> tmp = getShardFn(localDeviceIndex);
+      data.insert(data.end(), tmp.begin(), tmp.end());
+    }
+    return data;
+  };
+  auto items = shardOpt_[0]->getStateItems(shardOpt_, localGather, /*isMainProcess=*/true);
+
+  if(mvAvg_ && paramsAvg_.size() > 0) {
+    auto vAvg = localGather([&](size_t localDeviceIndex) {
+      std::vector<float> data;
+      paramsAvg_[localDeviceIndex]->get(data);
+      return data;
+    });
+    io::Item itemAvg;
+    itemAvg.name = "exp_smoothing";
+    itemAvg.shape = Shape({1, (int)vAvg.size()});
+    itemAvg.type = Type::float32;
+    itemAvg.bytes.resize(vAvg.size() * sizeOf(itemAvg.type));
+    std::copy((char*)vAvg.data(), (char*)(vAvg.data() + vAvg.size()), itemAvg.bytes.begin());
+    items.push_back(itemAvg);
+  }
+  return items;
+}
+
+// whether the items of getLocalShardItems() are concatenated from the shards (e.g. adam_mt) or
+// replicated on all shards (e.g. adam_denoms): the optimizer builds the former from the gathered
+// shards, so they remain empty if the shards are
+std::map<std::string, bool> SyncGraphGroup::getShardedItemFlags() {
+  std::map<std::string, bool> sharded;
+  auto emptyGather = [](const OptimizerBase::GatherStateGetFunc&) { return std::vector<float>(); };
+  for(const auto& item : shardOpt_[0]->getStateItems(shardOpt_, emptyGather, /*isMainProcess=*/true))
+    sharded[item.name] = item.shape.elements() == 0;
+  if(mvAvg_ && paramsAvg_.size() > 0)
+    sharded["exp_smoothing"] = true;
+  return sharded;
+}
+
+// collects the ranges of all shards; returns the manifest on the main process, "" elsewhere
+std::string SyncGraphGroup::getShardManifest(size_t begin, size_t end) {
+  size_t numShards = mpi_->numMPIProcesses();
+  std::vector<unsigned long long> ranges(2 * numShards, 0);
+  ranges[2 * mpi_->myMPIRank()]     = begin;
+  ranges[2 * mpi_->myMPIRank() + 1] = end;
+  mpi_->allReduce(ranges.data(), ranges.data(), ranges.size(), MPI_UNSIGNED_LONG_LONG, MPI_SUM);
+  if(!isMainProcess())
+    return "";
+
+  YAML::Node manifest;
+  manifest["size"] = graphs_[0]->params()->vals()->size();
+  for(size_t rank = 0; rank < numShards; rank++) {
+    YAML::Node shard;
+    shard["rank"] = rank;
+    shard["begin"] = ranges[2 * rank];
+    shard["end"] = ranges[2 * rank + 1];
+    manifest["shards"].push_back(shard);
+  }
+  for(const auto& kv : getShardedItemFlags()) {
+    YAML::Node item;
+    item["name"] = kv.first;
+    item["sharded"] = kv.second;
+    manifest["items"].push_back(item);
+  }
+  std::stringstream ss;
+  ss << manifest;
+  return ss.str();
+}
+
+// writes this MPI process' shard, or the manifest if not empty
+void SyncGraphGroup::writeShard(const std::string& name,
+                                const std::vector<io::Item>& items,
+                                const std::string& manifest) const {
+  if(!items.empty()) {
+    auto shardName = shardFileName(name, mpi_->myMPIRank());
+    LOG(info, "Saving optimizer parameters to {}", shardName);
+    io::saveItems(shardName, items);
+  }
+  if(!manifest.empty()) {
+    auto manifestName = shardManifestFileName(name);
+    {
+      std::ofstream fout(manifestName + ".tmp");
+      fout << manifest;
+      ABORT_IF(!fout, "Error writing shard manifest to '{}'", manifestName + ".tmp");
+    }
+    ABORT_IF(std::rename((manifestName + ".tmp").c_str(), manifestName.c_str()) != 0,
+             "Error renaming '{}' to '{}'", manifestName + ".tmp", manifestName);
+  }
+}
+
+// Restores the optimizer state and the smoothed parameters from a sharded checkpoint. Each MPI
+// process reads only the shards that overlap its own range of the parameter vector, which is just
+// its own shard if the layout is unchanged. Called after initialize(), see load().
+void SyncGraphGroup::loadShards(const std::string& name) {
+  auto manifestName = shardManifestFileName(name);
+  auto manifest = YAML::LoadFile(manifestName);
+  auto shards = manifest["shards"];
+  ABORT_IF(manifest["size"].as<size_t>() != graphs_[0]->params()->vals()->size(),
+           "Sharded optimizer checkpoint {} does not match the model size", manifestName);
+  ABORT_IF(!manifest["items"], "Sharded optimizer checkpoint {} does not list its items", manifestName);
+  std::map<std::string, bool> sharded;
+  for(const auto& item : manifest["items"])
+    sharded[item["name"].as<std::string>()] = item["sharded"].as<bool>();
+
+  size_t begin, end;
+  getLocalShardRange(begin, end);
+
+  // the items of the overlapping shards, restricted to [begin, end)
+  std::vector<io::Item> items;
+  std::map<std::string, size_t> itemIndex;
+  size_t shardBegin = 0;
+  for(size_t i = 0; i < shards.size(); i++) {
+    ABORT_IF(shards[i]["begin"].as<size_t>() != shardBegin, "Shards in {} are not contiguous", manifestName);
+    size_t shardEnd = shards[i]["end"].as<size_t>();
+    size_t overlapBegin = std::max(shardBegin, begin), overlapEnd = std::min(shardEnd, end);
+    if(overlapBegin < overlapEnd) {
+      auto shardName = shardFileName(name, shards[i]["rank"].as<size_t>());
+      LOG(info, "Loading optimizer parameters from {}", shardName);
+      for(auto& item : io::loadItems(shardName)) {
+        auto flag = sharded.find(item.name);
+        ABORT_IF(flag == sharded.end(), "Item {} of {} is not listed in {}", item.name, shardName, manifestName);
+        auto it = itemIndex.find(item.name);
+        if(!flag->second) { // replicated, the same in all shards
+          if(it == itemIndex.end()) {
+            itemIndex[item.name] = items.size();
+            items.push_back(item);
+          }
+          continue;
+        }
+        ABORT_IF((size_t)item.shape.elements() != shardEnd - shardBegin,
+                 "Item {} of {} does not match the shard size", item.name, shardName);
+        if(it == itemIndex.end()) {
+          itemIndex[item.name] = items.size();
+          items.push_back(io::Item());
+          items.back().name = item.name;
+          items.back().type = item.type;
+          it = itemIndex.find(item.name);
+        }
+        auto& part = items[it->second];
+        size_t elementSize = sizeOf(item.type);
+        part.bytes.insert(part.bytes.end(),
+                          item.bytes.begin() + (overlapBegin - shardBegin) * elementSize,
+                          item.bytes.begin() + (overlapEnd - shardBegin) * elementSize);
+        part.shape = Shape({1, (int)(part.bytes.size() / elementSize)});
+      }
+    }
+    shardBegin = shardEnd;
+  }
+  ABORT_IF(shardBegin != manifest["size"].as<size_t>(), "Shards in {} do not cover the model", manifestName);
+
+  auto scatterFn = [&](const std::vector<float>& data, const OptimizerBase::ScatterStateSetFunc& setShardFn) {
+    ABORT_IF(data.size() != end - begin, "Optimizer state does not match the local shards??");
+    comm_->foreach([&](size_t localDeviceIndex, size_t deviceBegin, size_t deviceEnd) {
+      setShardFn(localDeviceIndex, data.begin() + (deviceBegin - begin), data.begin() + (deviceEnd - begin));
+    }, /*parallel=*/false);
+  };
+  loadedParamsAvgOffset_ = begin;
+
+  for(const auto& item : items) {
+    if(item.name == "exp_smoothing" && mvAvg_) {
+      loadedParamsAvg_.resize(item.shape.elements());
+      std::copy((float*)item.data(), ((float*)item.data()) + item.shape.elements(), loadedParamsAvg_.begin());
+    }
+  }
+
+  std::vector<Ptr<Backend>> backends;
+  for(auto graph : graphs_)
+    backends.push_back(graph->getBackend());
+  shardOpt_[0]->setStateItems(items, shardOpt_, backends, scatterFn);
+}
+
+void SyncGraphGroup::waitForPendingSaves(size_t maxPending) {
+  while(pendingSaves_.size() > maxPending) {
+    pendingSaves_.front().get();
+    pendingSaves_.pop_front();
+  }
+}
+
 void SyncGraphGroup::finalize() /*override*/ {
   validate();
   Base::finalize();
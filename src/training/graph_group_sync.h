@@ -3,6 +3,11 @@
 #include "training/graph_group.h"
 #include "training/communicator.h"
 #include "training/exponential_smoothing.h"
+#include "training/gradient_buckets.h"
+
+#include "3rd_party/threadpool.h"
+
+#include <deque>
 
 namespace marian {
 
@@ -28,6 +33,20 @@ class SyncGraphGroup : public GraphGroup, public ExponentialSmoothing {
   std::vector<Ptr<data::Batch>> pendingBatches_; // in case of dynamic MB-size scaling, we temporarly buffer up batches across update() calls until enough
   double updateMultiplier_{1};                  // multiplier not applied in collectStats() (no multiplier if not mini-batch-fit)
 
+  Ptr<GradientBuckets> gradBuckets_; // [may be null] reduces gradients during the backward pass (--gradient-bucket-mb)
+
+  // state for saveAsync()
+  size_t maxPendingSaves_{0};                   // max number of checkpoints being written in the background (0: save synchronously)
+  UPtr<ThreadPool> saveThread_;                 // writes checkpoints from CPU-side snapshots
+  std::deque<std::future<void>> pendingSaves_;  // oldest first
+  Ptr<models::ICriterionFunction> saveBuilder_; // only used by saveThread_
+
+  // state for sharded checkpoints (--sharded-checkpoints)
+  bool shardedCheckpoints_{false};     // each MPI process saves and loads only its own shard of the optimizer state
+  std::vector<float> loadedParamsAvg_; // smoothed parameters restored from shard files, consumed by initializeAvg()
+  size_t loadedParamsAvgOffset_{0};    // position of loadedParamsAvg_ in the full parameter vector
+  std::string shardsToLoad_;           // checkpoint restored by loadShards() once the parameters are allocated
+
   void initialize(const Ptr<data::Batch>& exampleBatch);
   void initializeAvg();
 
@@ -38,8 +57,19 @@ class SyncGraphGroup : public GraphGroup, public ExponentialSmoothing {
   bool tryGetSubBatches(Ptr<data::Batch> newBatch, std::vector<Ptr<data::Batch>>& subBatches, size_t& numReadBatches);
   void update(std::vector<Ptr<data::Batch>> subBatches, size_t numReadBatches);
 
+  void saveAsync(const std::string& name, const std::string& suffix);
+  void waitForPendingSaves(size_t maxPending);
+
+  void getLocalShardRange(size_t& begin, size_t& end);
+  std::vector<io::Item> getLocalShardItems();
+  std::map<std::string, bool> getShardedItemFlags();
+  std::string getShardManifest(size_t begin, size_t end);
+  void writeShard(const std::string& name, const std::vector<io::Item>& items, const std::string& manifest) const;
+  void loadShards(const std::string& name);
+
 public:
   SyncGraphGroup(Ptr<Options> config, Ptr<IMPIWrapper> mpi);
+  ~SyncGraphGroup() override;
 
   void setScheduler(Ptr<Scheduler> scheduler) override;
 
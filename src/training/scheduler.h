@@ -1,6 +1,8 @@
 #pragma once
 
 #include "common/options.h"
+#include "common/phase_timer.h"
+#include "graph/op_profiler.h"
 #include "training/training_state.h"
 #include "training/validator.h"
 #include "training/communicator.h"
@@ -22,6 +24,94 @@ private:
   timer::Timer timer_;
   timer::Timer heartBeatTimer_;
 
+  // background validation (--valid-async)
+  struct ValidationResult {
+    std::string type;
+    float value;
+    float lastBest;
+    size_t stalled;
+    size_t stalledPrev;
+  };
+
+  size_t validAsyncGraphs_{0};                   // number of CPU graphs holding the parameter snapshot
+  std::vector<Ptr<ExpressionGraph>> validGraphs_; // only used by the validation thread
+  std::future<std::vector<ValidationResult>> pendingValidation_;
+  size_t pendingEpochs_{0};
+  size_t pendingBatches_{0};
+
+  std::vector<ValidationResult> runValidators(const std::vector<Ptr<ExpressionGraph>>& graphs,
+                                              Ptr<const TrainingState> state) {
+    std::vector<ValidationResult> results;
+    for(auto validator : validators_) {
+      if(!validator)
+        continue;
+      size_t stalledPrev = validator->stalled();
+      float value = validator->validate(graphs, state);
+      results.push_back({validator->type(), value, validator->lastBest(), validator->stalled(), stalledPrev});
+    }
+    return results;
+  }
+
+  void applyValidation(const std::vector<ValidationResult>& results, size_t epochs, size_t batches) {
+    bool firstValidator = true;
+    for(const auto& result : results) {
+      if(result.stalled > 0) {
+        LOG_VALID(info,
+                  "Ep. {} : Up. {} : {} : {} : stalled {} times (last best: {})",
+                  epochs,
+                  batches,
+                  result.type,
+                  result.value,
+                  result.stalled, result.lastBest);
+      } else {
+        LOG_VALID(info,
+                  "Ep. {} : Up. {} : {} : {} : new best",
+                  epochs,
+                  batches,
+                  result.type,
+                  result.value);
+
+        if(firstValidator)
+          state_->validBest = result.value;
+      }
+
+      state_->validators[result.type]["last-best"] = result.lastBest;
+      state_->validators[result.type]["stalled"] = result.stalled;
+
+      // notify training observers if the first validator did not improve
+      if(firstValidator && result.stalled > result.stalledPrev)
+        state_->newStalled(result.stalled);
+      firstValidator = false;
+    }
+  }
+
+  // Copies the current parameters to the CPU and returns a function, to be called on the
+  // validation thread, that loads them into the CPU graphs used for validation
+  std::function<std::vector<Ptr<ExpressionGraph>>()> snapshotParams(
+      const std::vector<Ptr<ExpressionGraph>>& graphs) {
+    auto items = New<std::vector<io::Item>>();
+    graphs[0]->save(*items);
+    return [this, items]() {
+      if(validGraphs_.empty()) {
+        for(size_t i = 0; i < validAsyncGraphs_; ++i) {
+          auto graph = New<ExpressionGraph>();
+          graph->setDevice({i, DeviceType::cpu});
+          graph->reserveWorkspaceMB(512); // grows as needed
+          graph->load(*items);
+          validGraphs_.push_back(graph);
+        }
+      } else {
+        for(auto graph : validGraphs_)
+          for(const auto& item : *items)
+            graph->get(item.name)->val()->set(item);
+      }
+      return validGraphs_;
+    };
+  }
+
+  // declared last so that a running validation finishes before the members above are destroyed
+  UPtr<ThreadPool> validThread_;
+
   // determine scheduled LR decay factor (--lr-decay-inv-sqrt option)
   float getScheduledLRDecayFactor(const TrainingState& state) const {
     auto args = options_->get<std::vector<std::string>>("lr-decay-inv-sqrt");
@@ -150,6 +240,7 @@ public:
     ABORT_IF(state_->factor != 1, "state.factor unexpectedly not 1 at this point??");
     updateLearningRate(*state);
     installSignalHandlers();
+    validAsyncGraphs_ = options_->get<size_t>("valid-async", 0);
   }
 
   bool keepGoing() {
@@ -184,6 +275,7 @@ public:
 
   void started() { LOG(info, "Training started"); }
   void finished() {
+    finishValidation(/*wait=*/true);
     if (getSigtermFlag())
       LOG(info, "Training interrupted (SIGTERM).");
     else
@@ -213,6 +305,12 @@ public:
     return state_->enteredNewPeriodOf(options_->get<std::string>("save-freq"));
   }
 
+  // true if the last update printed the training progress (--disp-freq, --disp-first)
+  bool displaying() {
+    return state_->enteredNewPeriodOf(options_->get<std::string>("disp-freq"))
+           || state_->batches <= options_->get<size_t>("disp-first");
+  }
+
   void validate(const std::vector<Ptr<ExpressionGraph>>& graphs,
                 bool isFinal = false) {
     // Do not validate if already validated (for instance, after the model is
@@ -222,50 +320,52 @@ public:
        || (!state_->enteredNewPeriodOf(options_->get<std::string>("valid-freq")) && !isFinal)) // not now
       return;
 
-    bool firstValidator = true;
-    for(auto validator : validators_) {
-      if(!validator)
-        continue;
-
-      size_t stalledPrev = validator->stalled();
-      float value = validator->validate(graphs, state_);
-      if(validator->stalled() > 0) {
-        LOG_VALID(info,
-                  "Ep. {} : Up. {} : {} : {} : stalled {} times (last best: {})",
-                  state_->epochs,
-                  state_->batches,
-                  validator->type(),
-                  value,
-                  validator->stalled(), validator->lastBest());
+    timer::ScopedPhase phase(timer::Phase::validation);
+    if(validAsyncGraphs_ == 0) {
+      applyValidation(runValidators(graphs, state_), state_->epochs, state_->batches);
+    } else {
+      // at most one validation in flight; the final one runs synchronously on the snapshot
+      finishValidation(/*wait=*/true);
+      auto snapshot = snapshotParams(graphs);
+      auto stateCopy = New<TrainingState>(*state_);
+      auto task = [this, snapshot, stateCopy]() {
+        return runValidators(snapshot(), stateCopy);
+      };
+      if(isFinal) {
+        applyValidation(task(), state_->epochs, state_->batches);
       } else {
-        LOG_VALID(info,
-                  "Ep. {} : Up. {} : {} : {} : new best",
-                  state_->epochs,
-                  state_->batches,
-                  validator->type(),
-                  value);
-
-        if(firstValidator)
-          state_->validBest = value;
+        if(!validThread_)
+          validThread_.reset(new ThreadPool(1));
+        pendingValidation_ = validThread_->enqueue(task);
+        pendingEpochs_ = state_->epochs;
+        pendingBatches_ = state_->batches;
       }
-
-      state_->validators[validator->type()]["last-best"]
-          = validator->lastBest();
-      state_->validators[validator->type()]["stalled"] = validator->stalled();
-
-      // notify training observers if the first validator did not improve
-      if(firstValidator && validator->stalled() > stalledPrev)
-        state_->newStalled(validator->stalled());
-      firstValidator = false;
     }
 
     state_->validated = true;
   }
 
+  // Apply the results of a background validation (--valid-async) to the training state if it has
+  // completed, or wait for it to complete
+  void finishValidation(bool wait) {
+    if(!pendingValidation_.valid())
+      return;
+    if(!wait && pendingValidation_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return;
+    applyValidation(pendingValidation_.get(), pendingEpochs_, pendingBatches_);
+  }
+
   size_t stalled() {
     if(!validators_.empty())
-      if(validators_[0])
+      if(validators_[0]) {
+        // with background validation, the validator may be ahead of the training state; a resumed
+        // state has no entry for a new validator until its first validation has been applied
+        if(validAsyncGraphs_ > 0) {
+          auto stalled = state_->validators[validators_[0]->type()]["stalled"];
+          return stalled.IsScalar() ? stalled.as<size_t>() : 0;
+        }
         return validators_[0]->stalled();
+      }
     return 0;
   }
 
@@ -285,6 +385,8 @@ public:
                                          // -freq parameters do not support epoch units
     state_->validated = false;
 
+    finishValidation(/*wait=*/false);
+
     // Since batchLabels is counted across all MPI processes, we also should temporarily
     // extrapolate cost across MPI processes, to have numbers in the right range.
     // When doing the actual log, we then aggregate across MPI processes to get the accurate number.
@@ -309,8 +411,7 @@ public:
     auto lossType = options_->get<std::string>("cost-type");
     auto dispLabelCounts = options_->get<bool>("disp-label-counts");  // if true then show as "cost per label * number of labels"
 
-    if(state_->enteredNewPeriodOf(options_->get<std::string>("disp-freq")) ||
-       state_->batches <= options_->get<size_t>("disp-first")) {
+    if(displaying()) {
       // if MPI then aggregate precise cost across workers
       if(mpi) {
         state_->costSum /= mpi->numMPIProcesses(); // undo the extra scaling
@@ -340,6 +441,13 @@ public:
             state_->wordsDisp / timer_.elapsed());
       }
 
+      if(timer::PhaseTimers::enabled()) {
+        auto phases = timer::PhaseTimers::report();
+        if(!mpi || mpi->myMPIRank() == 0)
+          LOG(info, "Phases : {}", phases);
+      }
+      if(OpProfiler::enabled() && (!mpi || mpi->myMPIRank() == 0))
+        OpProfiler::logPeriod();
 
       timer_.start();
       state_->costSum      = 0;
@@ -391,13 +499,22 @@ public:
   }
 
   void save(const std::string& name) {
+    save(name, options_->asYamlString(), *state_);
+  }
+
+  // Write config options and a copy of the training progress taken earlier, e.g. from a
+  // background thread while training continues
+  static void save(const std::string& name, const std::string& optionsYaml, const TrainingState& state) {
     // Save config options
     std::ofstream fout(name + ".yml");
-    fout << options_->asYamlString();
+    fout << optionsYaml;
     // Save training progress
-    state_->save(name + ".progress.yml");
+    state.save(name + ".progress.yml");
   }
 
+  std::string getOptionsAsYamlString() const { return options_->asYamlString(); }
+  const TrainingState& getTrainingState() const { return *state_; }
+
   size_t numberOfBatches() { return state_->batches; }
 
   void registerTrainingObserver(Ptr<TrainingObserver> observer) {
@@ -76,6 +76,18 @@ public:
     bool restored = !options_->get<bool>("no-restore-corpus")
                     && batchGenerator->restore(trainState);
 
+    auto phaseTrace = options_->get<std::string>("phase-trace", "");
+    if(!phaseTrace.empty() && mpi && mpi->numMPIProcesses() > 1)
+      phaseTrace += ".rank" + std::to_string(mpi->myMPIRank());
+    if(options_->get<bool>("phase-timers", false) || !phaseTrace.empty())
+      timer::PhaseTimers::enable(phaseTrace);
+
+    auto opTrace = options_->get<std::string>("profile-ops-trace", "");
+    if(!opTrace.empty() && mpi && mpi->numMPIProcesses() > 1)
+      opTrace += ".rank" + std::to_string(mpi->myMPIRank());
+    if(options_->get<bool>("profile-ops", false) || !opTrace.empty())
+      OpProfiler::enable(opTrace);
+
     // -- main training loop
     scheduler->started();
     while(scheduler->keepGoing()) {
@@ -100,6 +112,8 @@ public:
     // Avoid saving the model twice if it has been loaded and training did not progress
     if(!trainState->loaded)
       model->save(true);
+    timer::PhaseTimers::disable();
+    OpProfiler::disable();
 
     // Signal success to a potential MPI runner
     model = nullptr; // release any reference to MPI that model may hold
@@ -370,7 +370,8 @@ float TranslationValidator::validate(const std::vector<Ptr<ExpressionGraph>>& gr
 
   timer::Timer timer;
   {
-    auto printer = New<OutputPrinter>(options_, vocabs_.back());
+    DecodeConfig decodeConfig(options_); // resolved once for all batches
+    auto printer = New<OutputPrinter>(decodeConfig, vocabs_.back());
     // @TODO: This can be simplified. If there is no "valid-translation-output", fileName already
     // contains the name of temporary file that should be used?
     auto collector = options_->hasAndNotEmpty("valid-translation-output")
@@ -399,7 +400,7 @@ float TranslationValidator::validate(const std::vector<Ptr<ExpressionGraph>>& gr
         scorerQueue.pop_front();
       }
 
-      auto search = New<BeamSearch>(options_, std::vector<Ptr<Scorer>>{scorer}, vocabs_.back());
+      auto search = New<BeamSearch>(decodeConfig, std::vector<Ptr<Scorer>>{scorer}, vocabs_.back());
       auto histories = search->search(graph, batch);
 
       for(auto history : histories) {
@@ -407,15 +408,20 @@ float TranslationValidator::validate(const std::vector<Ptr<ExpressionGraph>>& gr
         std::stringstream bestn;
         printer->print(history, best1, bestn);
         collector->Write(
-            (long)history->getLineNum(), best1.str(), bestn.str(), options_->get<bool>("n-best"));
+            (long)history->getLineNum(), best1.str(), bestn.str(), decodeConfig.nBest);
       }
     };
 
     threadPool_.reserve(graphs.size());
-    TaskBarrier taskBarrier;
-    for(auto batch : *batchGenerator_)
-      taskBarrier.push_back(threadPool_.enqueue(task, batch));
-    // ~TaskBarrier waits until all are done
+    {
+      TaskBarrier taskBarrier;
+      for(auto batch : *batchGenerator_)
+        taskBarrier.push_back(threadPool_.enqueue(task, batch));
+      // ~TaskBarrier waits until all are done
+    }
+    // the pool may still hold copies of the task and thus of the collector, so do not wait for its
+    // destruction to complete the file that is passed to the validation script
+    collector->close();
   }
 
   if(!quiet_)
@@ -495,7 +501,8 @@ float BleuValidator::validate(const std::vector<Ptr<ExpressionGraph>>& graphs,
 
   timer::Timer timer;
   {
-    auto printer = New<OutputPrinter>(options_, vocabs_.back());
+    DecodeConfig decodeConfig(options_); // resolved once for all batches
+    auto printer = New<OutputPrinter>(decodeConfig, vocabs_.back());
 
     Ptr<OutputCollector> collector;
     if(options_->hasAndNotEmpty("valid-translation-output")) {
@@ -529,7 +536,7 @@ float BleuValidator::validate(const std::vector<Ptr<ExpressionGraph>>& graphs,
         scorerQueue.pop_front();
       }
 
-      auto search = New<BeamSearch>(options_, std::vector<Ptr<Scorer>>{scorer}, vocabs_.back());
+      auto search = New<BeamSearch>(decodeConfig, std::vector<Ptr<Scorer>>{scorer}, vocabs_.back());
       auto histories = search->search(graph, batch);
 
       size_t no = 0;
@@ -551,10 +558,13 @@ float BleuValidator::validate(const std::vector<Ptr<ExpressionGraph>>& graphs,
     };
 
     threadPool_.reserve(graphs.size());
-    TaskBarrier taskBarrier;
-    for(auto batch : *batchGenerator_)
-      taskBarrier.push_back(threadPool_.enqueue(task, batch));
-    // ~TaskBarrier waits until all are done
+    {
+      TaskBarrier taskBarrier;
+      for(auto batch : *batchGenerator_)
+        taskBarrier.push_back(threadPool_.enqueue(task, batch));
+      // ~TaskBarrier waits until all are done
+    }
+    collector->close();
   }
 
   if(!quiet_)
@@ -2,6 +2,7 @@
 #include <algorithm>
 
 #include "marian.h"
+#include "translator/decode_config.h"
 #include "translator/history.h"
 #include "translator/scorers.h"
 #include "data/factored_vocab.h"
@@ -13,7 +14,7 @@ namespace marian {
 
 class BeamSearch {
 private:
-  Ptr<Options> options_;
+  DecodeConfig config_;
   std::vector<Ptr<Scorer>> scorers_;
   size_t beamSize_;
   Ptr<const Vocab> trgVocab_;
@@ -22,27 +23,33 @@ private:
   const bool PURGE_BATCH = true; // @TODO: diagnostic, to-be-removed once confirmed there are no issues.
 
 public:
-  BeamSearch(Ptr<Options> options,
+  BeamSearch(const DecodeConfig& config,
              const std::vector<Ptr<Scorer>>& scorers,
              const Ptr<const Vocab> trgVocab)
-      : options_(options),
+      : config_(config),
         scorers_(scorers),
-        beamSize_(options_->get<size_t>("beam-size")),
+        beamSize_(config_.beamSize),
         trgVocab_(trgVocab) {}
 
+  BeamSearch(Ptr<Options> options,
+             const std::vector<Ptr<Scorer>>& scorers,
+             const Ptr<const Vocab> trgVocab)
+      : BeamSearch(DecodeConfig(options), scorers, trgVocab) {}
+
   // combine new expandedPathScores and previous beams into new set of beams
   Beams toHyps(const std::vector<unsigned int>& nBestKeys, // [currentDimBatch, beamSize] flattened -> ((batchIdx, beamHypIdx) flattened, word idx) flattened
                const std::vector<float>& nBestPathScores,  // [currentDimBatch, beamSize] flattened
                const size_t nBestBeamSize, // for interpretation of nBestKeys
                const size_t vocabSize,     // ditto.
                const Beams& beams,
+               HypothesisArena& arena, // new hypotheses are appended here
                const std::vector<Ptr<ScorerState /*const*/>>& states,
                Ptr<data::CorpusBatch /*const*/> batch, // for alignments only
                Ptr<FactoredVocab/*const*/> factoredVocab, size_t factorGroup,
                const std::vector<bool>& dropBatchEntries, // [origDimBatch] - empty source batch entries are marked with true, should be cleared after first use.
                const std::vector<IndexType>& batchIdxMap) const { // [origBatchIdx -> currentBatchIdx]
     std::vector<float> align; // collects alignment information from the last executed time step
-    if(options_->hasAndNotEmpty("alignment") && factorGroup == 0)
+    if(!config_.alignment.empty() && factorGroup == 0)
       align = scorers_[0]->getAlignment(); // [beam depth * max src length * current batch size] -> P(s|t); use alignments from the first scorer, even if ensemble,
 
     const auto origDimBatch = beams.size(); // see function search for definition of origDimBatch and currentDimBatch etc.
@@ -120,21 +127,21 @@ public:
           word = factoredVocab->lemma2Word(shortlist ? shortlist->reverseMap(wordIdx) : wordIdx); // @BUGBUG: reverseMap is only correct if factoredVocab_->getGroupRange(0).first == 0
           std::vector<size_t> factorIndices; factoredVocab->word2factors(word, factorIndices);
           //LOG(info, "{} + {} ({}) -> {} -> {}",
-          //    factoredVocab->decode(prevHyp->tracebackWords()),
-          //    factoredVocab->word2string(word), factorIndices[0], prevHyp->getPathScore(), pathScore);
+          //    factoredVocab->decode(prevHyp.tracebackWords()),
+          //    factoredVocab->word2string(word), factorIndices[0], prevHyp.getPathScore(), pathScore);
         }
         else {
           //LOG(info, "{} |{} ({}) = {} ({}) -> {} -> {}",
-          //    factoredVocab->decodeForDiagnostics(beam[beamHypIdx]->tracebackWords()),
+          //    factoredVocab->decodeForDiagnostics(beam[beamHypIdx].tracebackWords()),
           //    factoredVocab->getFactorGroupPrefix(factorGroup), factorGroup,
           //    factoredVocab->getFactorName(factorGroup, wordIdx), wordIdx,
-          //    prevHyp->getPathScore(), pathScore);
-          word = beam[beamHypIdx]->getWord();
+          //    prevHyp.getPathScore(), pathScore);
+          word = beam[beamHypIdx].getWord();
           ABORT_IF(!factoredVocab->canExpandFactoredWord(word, factorGroup),
                    "A word without this factor snuck through to here??");
           word = factoredVocab->expandFactoredWord(word, factorGroup, wordIdx);
-          prevBeamHypIdx = prevHyp->getPrevStateIndex();
-          prevHyp = prevHyp->getPrevHyp(); // short-circuit the backpointer, so that the traceback does not contain partially factored words
+          prevBeamHypIdx = prevHyp.getPrevStateIndex();
+          prevHyp = prevHyp.getPrevHyp(); // short-circuit the backpointer, so that the traceback does not contain partially factored words
         }
       }
       else if (shortlist)
@@ -142,14 +149,14 @@ public:
       else
         word = Word::fromWordIndex(wordIdx);
 
-      auto hyp = Hypothesis::New(prevHyp, word, prevBeamHypIdx, pathScore);
+      auto hypIdx = arena.add(prevHyp.getIndex(), word, prevBeamHypIdx, pathScore);
 
       // Set score breakdown for n-best lists
-      if(options_->get<bool>("n-best")) {
-        auto breakDown = beam[beamHypIdx]->getScoreBreakdown();
+      if(arena.numScores() > 0) {
         ABORT_IF(factoredVocab && factorGroup > 0 && !factoredVocab->canExpandFactoredWord(word, factorGroup),
                  "A word without this factor snuck through to here??");
-        breakDown.resize(states.size(), 0); // at start, this is empty, so this will set the initial score to 0
+        float* breakDown = arena.scoreBreakdown(hypIdx);
+        const float* prevBreakDown = arena.scoreBreakdown(beam[beamHypIdx].getIndex()); // all zeros for the start hypothesis
         for(size_t j = 0; j < states.size(); ++j) {
           auto lval = states[j]->getLogProbs().getFactoredLogitsTensor(factorGroup); // [maxBeamSize, 1, currentDimBatch, dimFactorVocab]
           // The flatting happens based on actual (current) batch size and batch index computed with batch-pruning as we are looking into the pruned tensor
@@ -160,18 +167,17 @@ public:
                    (beamHypIdx == 0 && lval->shape() != Shape({1, 1, (int)currentDimBatch, (int)vocabSize})),
                    "Unexpected shape of logits?? {} != {}", lval->shape(), Shape({(int)nBestBeamSize, 1, (int)currentDimBatch, (int)vocabSize}));
 
-          breakDown[j] += lval->get(flattenedLogitIndex);
+          breakDown[j] = prevBreakDown[j] + lval->get(flattenedLogitIndex);
         }
-        hyp->setScoreBreakdown(breakDown);
       }
 
       // Set alignments
       if(!align.empty())
-        hyp->setAlignment(getAlignmentsForHypothesis(align, batch, (int)beamHypIdx, (int)currentBatchIdx, (int)origBatchIdx, (int)currentDimBatch));
-      else // not first factor: just copy
-        hyp->setAlignment(beam[beamHypIdx]->getAlignment());
+        arena.setAlignment(hypIdx, getAlignmentsForHypothesis(align, batch, (int)beamHypIdx, (int)currentBatchIdx, (int)origBatchIdx, (int)currentDimBatch));
+      else // not first factor: just refer to the previous one
+        arena.shareAlignment(hypIdx, beam[beamHypIdx].getIndex());
 
-      newBeam.push_back(hyp);
+      newBeam.emplace_back(&arena, hypIdx);
     }
 
     // if factored vocab and this is not the first factor, we need to
@@ -181,7 +187,7 @@ public:
         const auto& beam = beams[batchIdx];
         auto& newBeam = newBeams[batchIdx];
         for (const auto& beamHyp : beam) {
-          auto word = beamHyp->getWord();
+          auto word = beamHyp.getWord();
           //LOG(info, "Checking {}", factoredVocab->word2string(word));
           if (factoredVocab->canExpandFactoredWord(word, factorGroup)) // handled above
             continue;
@@ -190,8 +196,8 @@ public:
         }
         if (newBeam.size() > beam.size()) {
           //LOG(info, "Size {}, sorting...", newBeam.size());
-          std::nth_element(newBeam.begin(), newBeam.begin() + beam.size(), newBeam.end(), [](Hypothesis::PtrType a, Hypothesis::PtrType b) {
-            return a->getPathScore() > b->getPathScore(); // (sort highest score first)
+          std::nth_element(newBeam.begin(), newBeam.begin() + beam.size(), newBeam.end(), [](const Hypothesis& a, const Hypothesis& b) {
+            return a.getPathScore() > b.getPathScore(); // (sort highest score first)
           });
           //LOG(info, "Size {}, sorted...", newBeam.size());
           newBeam.resize(beam.size());
@@ -246,6 +252,49 @@ public:
     return align;
   }
 
+  // Expand the hypotheses with all factors of a secondary factor group and find the N best for each
+  // batch entry. The factor logits were computed in the graph pass of the lemma step, so this
+  // happens on the host without another pass. They are only downloaded for groups that some
+  // hypothesis expands, and only the rows of such hypotheses are normalized (by their maximum).
+  // Returns the number of factors in the group.
+  size_t getFactorNBestList(const std::vector<Tensor>& factorLogits,  // [scorer] -> [maxBeamSize or 1, 1, currentDimBatch, dimFactor] unnormalized
+                            const std::vector<float>& weights,        // [scorer]
+                            const std::vector<IndexType>& hypIndices, // [maxBeamSize, 1, currentDimBatch, 1] (flattened) row of factorLogits of each hyp
+                            const std::vector<float>& prevScores,     // [maxBeamSize, 1, currentDimBatch, 1] (flattened)
+                            size_t maxBeamSize,
+                            size_t currentDimBatch,
+                            std::vector<float>& nBestPathScores,
+                            std::vector<unsigned int>& nBestKeys) const {
+    ABORT_IF(prevScores.size() != maxBeamSize * currentDimBatch || hypIndices.size() != prevScores.size(),
+             "Unexpected number of hypotheses for factor expansion??");
+    ABORT_IF(factorLogits.size() != weights.size(), "Factor logits and weights of different sizes??");
+    size_t dimFactor = factorLogits.front()->shape()[-1];
+    std::vector<std::vector<float>> values(factorLogits.size());
+    for(size_t i = 0; i < factorLogits.size(); ++i)
+      factorLogits[i]->get(values[i]);
+
+    // same layout as the swapped axes of the lemma step: [currentDimBatch, 1, maxBeamSize, dimFactor]
+    std::vector<float> expandedPathScores(currentDimBatch * maxBeamSize * dimFactor);
+    for(size_t beamHypIdx = 0; beamHypIdx < maxBeamSize; ++beamHypIdx) {
+      for(size_t batchIdx = 0; batchIdx < currentDimBatch; ++batchIdx) {
+        size_t hypIdx = beamHypIdx * currentDimBatch + batchIdx;
+        float* scores = expandedPathScores.data() + (batchIdx * maxBeamSize + beamHypIdx) * dimFactor;
+        std::fill(scores, scores + dimFactor, prevScores[hypIdx]);
+        if(prevScores[hypIdx] == INVALID_PATH_SCORE) // dummy slot or word without this factor, must stay exactly invalid
+          continue;
+        for(size_t i = 0; i < values.size(); ++i) {
+          ABORT_IF((hypIndices[hypIdx] + 1) * dimFactor > values[i].size(), "Factor logits row out of bounds??");
+          const float* logits = values[i].data() + hypIndices[hypIdx] * dimFactor;
+          float maxLogit = *std::max_element(logits, logits + dimFactor);
+          for(size_t f = 0; f < dimFactor; ++f)
+            scores[f] += weights[i] * (logits[f] - maxLogit);
+        }
+      }
+    }
+    getNBestListCPU(expandedPathScores.data(), currentDimBatch, maxBeamSize, dimFactor, /*N=*/maxBeamSize, nBestPathScores, nBestKeys);
+    return dimFactor;
+  }
+
   // remove all beam entries that have reached EOS
   Beams purgeBeams(const Beams& beams, /*in/out=*/std::vector<IndexType>& batchIdxMap) {
     const auto trgEosId = trgVocab_->getEosId();
@@ -254,7 +303,7 @@ public:
     for(auto beam : beams) {
       Beam newBeam; // a beam of surviving hyps
       for(auto hyp : beam)
-        if(hyp->getWord() != trgEosId) // if this hyp is not finished,
+        if(hyp.getWord() != trgEosId) // if this hyp is not finished,
           newBeam.push_back(hyp);      // move over to beam of surviving hyps
 
       if(PURGE_BATCH)
@@ -292,12 +341,17 @@ public:
       scorer->clear(graph);
     }
 
+    // all hypotheses of this search, row 0 is the sentence-start hypothesis
+    auto arena = New<HypothesisArena>(config_.nBest ? scorers_.size() : 0);
+    arena->reserve(origDimBatch * beamSize_ * (batch->front()->batchWidth() + 1));
+
     Histories histories(origDimBatch);
     for(int i = 0; i < origDimBatch; ++i) {
       size_t sentId = batch->getSentenceIds()[i];
       histories[i] = New<History>(sentId,
-                                  options_->get<float>("normalize"),
-                                  options_->get<float>("word-penalty"));
+                                  arena,
+                                  config_.normalize,
+                                  config_.wordPenalty);
     }
 
     // start states
@@ -307,7 +361,7 @@ public:
     }
 
     // create one beam per batch entry with sentence-start hypothesis
-    Beams beams(origDimBatch, Beam(beamSize_, Hypothesis::New())); // array [origDimBatch] of array [maxBeamSize] of Hypothesis, keeps full size through search.
+    Beams beams(origDimBatch, Beam(beamSize_, Hypothesis(arena.get(), 0))); // array [origDimBatch] of array [maxBeamSize] of Hypothesis, keeps full size through search.
                                                                    // batch purging is determined from an empty sub-beam.
     std::vector<IndexType> batchIdxMap(origDimBatch); // Record at which batch entry a beam is looking.
                                                       // By default that corresponds to position in array,
@@ -326,7 +380,7 @@ public:
 
     // determine index of UNK in the log prob vectors if we want to suppress it in the decoding process
     int unkColId = -1;
-    if (trgUnkId != Word::NONE && !options_->get<bool>("allow-unk", false)) { // do we need to suppress unk?
+    if (trgUnkId != Word::NONE && !config_.allowUnk) { // do we need to suppress unk?
       unkColId = factoredVocab ? factoredVocab->getUnkIndex() : trgUnkId.toWordIndex(); // what's the raw index of unk in the log prob vector?
       auto shortlist = scorers_[0]->getShortlist();      // first shortlist is generally ok, @TODO: make sure they are the same across scorers?
       if (shortlist)
@@ -345,6 +399,7 @@ public:
 
     IndexType currentDimBatch = origDimBatch;
     auto prevBatchIdxMap = batchIdxMap; // [origBatchIdx -> currentBatchIdx] but shifted by one time step
+    const float maxLength = config_.maxLengthFactor * batch->front()->batchWidth(); // histories reaching this many steps are finished
     // main loop over output time steps
     for (size_t t = 0; ; t++) {
       ABORT_IF(origDimBatch != beams.size(), "Lost a batch entry??");
@@ -369,7 +424,8 @@ public:
         std::vector<IndexType> batchIndices;    // [1,           1, currentDimBatch, 1] indices of currently used batch indices with regard to current, actual tensors
         std::vector<IndexType> hypIndices;      // [maxBeamSize, 1, currentDimBatch, 1] (flattened) tensor index ((beamHypIdx, batchIdx), flattened) of prev hyp that a hyp originated from
         std::vector<Word> prevWords;            // [maxBeamSize, 1, currentDimBatch, 1] (flattened) word that a hyp ended in, for advancing the decoder-model's history
-        Expr prevPathScores;                    // [maxBeamSize, 1, currentDimBatch, 1], path score that a hyp ended in (last axis will broadcast into vocab size when adding expandedPathScores)
+        std::vector<float> prevScores;          // [maxBeamSize, 1, currentDimBatch, 1] (flattened) path score that a hyp ended in
+        Expr prevPathScores;                    // prevScores as a constant for factorGroup == 0 (last axis will broadcast into vocab size when adding expandedPathScores)
 
         bool anyCanExpand = false; // stays false if all hyps are invalid factor expansions
         if(t == 0 && factorGroup == 0) { // no scores yet
@@ -385,15 +441,14 @@ public:
               if(!beams[currentBatchIdx].empty() || !PURGE_BATCH)                           // for each beam check
                 batchIndices.push_back(prevBatchIdxMap[currentBatchIdx]);                   // which batch entries were active in previous step
 
-          std::vector<float> prevScores;
           for(size_t beamHypIdx = 0; beamHypIdx < maxBeamSize; ++beamHypIdx) { // loop over globally maximal beam-size (maxBeamSize)
             for(int origBatchIdx = 0; origBatchIdx < origDimBatch; ++origBatchIdx) { // loop over all batch entries (active and inactive)
               auto& beam = beams[origBatchIdx];
               if(beamHypIdx < beam.size()) {
-                auto hyp = beam[beamHypIdx];
-                auto word = hyp->getWord();
-                auto canExpand = (!factoredVocab || factoredVocab->canExpandFactoredWord(hyp->getWord(), factorGroup));
-                //LOG(info, "[{}, {}] Can expand {} with {} -> {}", batchIdx, beamHypIdx, (*batch->back()->vocab())[hyp->getWord()], factorGroup, canExpand);
+                const auto& hyp = beam[beamHypIdx];
+                auto word = hyp.getWord();
+                auto canExpand = (!factoredVocab || factoredVocab->canExpandFactoredWord(word, factorGroup));
+                //LOG(info, "[{}, {}] Can expand {} with {} -> {}", batchIdx, beamHypIdx, (*batch->back()->vocab())[hyp.getWord()], factorGroup, canExpand);
                 anyCanExpand |= canExpand;
 
                 auto currentBatchIdx = origBatchIdx;
@@ -406,11 +461,11 @@ public:
                                                                      // happened for factorGroup == 0
                 }
 
-                auto hypIndex = (IndexType)(hyp->getPrevStateIndex() * currentDimBatch + currentBatchIdx); // (beamHypIdx, batchIdx), flattened, for index_select() operation
+                auto hypIndex = (IndexType)(hyp.getPrevStateIndex() * currentDimBatch + currentBatchIdx); // (beamHypIdx, batchIdx), flattened, for index_select() operation
 
                 hypIndices.push_back(hypIndex); // (beamHypIdx, batchIdx), flattened as said above.
                 prevWords .push_back(word);
-                prevScores.push_back(canExpand ? hyp->getPathScore() : INVALID_PATH_SCORE);
+                prevScores.push_back(canExpand ? hyp.getPathScore() : INVALID_PATH_SCORE);
               } else {  // pad to maxBeamSize (dummy hypothesis)
                 if(!PURGE_BATCH || !beam.empty()) { // but only if we are not pruning and the beam is not deactivated yet
                   hypIndices.push_back(0);
@@ -420,19 +475,44 @@ public:
               }
             }
           }
-          if(factorGroup == 0)
+          if(factorGroup == 0) {
             currentDimBatch = (IndexType) batchIndices.size(); // keep batch size constant for all factor groups in a time step
-          prevPathScores = graph->constant({(int)maxBeamSize, 1, (int)currentDimBatch, 1}, inits::fromVector(prevScores));
+            prevPathScores = graph->constant({(int)maxBeamSize, 1, (int)currentDimBatch, 1}, inits::fromVector(prevScores));
+          }
         }
         if (!anyCanExpand) // all words cannot expand this factor: skip
           continue;
 
-        //**********************************************************************
-        // compute expanded path scores with word prediction probs from all scorers
-        auto expandedPathScores = prevPathScores; // will become [maxBeamSize, 1, currDimBatch, dimVocab]
-        Expr logProbs;
-        for(size_t i = 0; i < scorers_.size(); ++i) {
-          if (factorGroup == 0) {
+        std::vector<unsigned int> nBestKeys; // [currentDimBatch, maxBeamSize] flattened -> (batchIdx, beamHypIdx, word idx) flattened
+        std::vector<float> nBestPathScores;  // [currentDimBatch, maxBeamSize] flattened
+        size_t nBestBeamSize, vocabSize;     // used for interpretation of keys
+
+        if (factorGroup > 0) {
+          // add secondary factors
+          // For those, we don't update the decoder-model state in any way.
+          // Instead, we just keep expanding with the factors.
+          // We will have temporary Word entries in hyps with some factors set to FACTOR_NOT_SPECIFIED.
+          // For some lemmas, a factor is not applicable. For those, the factor score is the same (zero)
+          // for all factor values. This would thus unnecessarily pollute the beam with identical copies,
+          // and push out other hypotheses. Hence, we exclude those here by setting the path score to
+          // INVALID_PATH_SCORE. Instead, toHyps() explicitly propagates those hyps by simply copying the
+          // previous hypothesis.
+          // The factor logits are already computed, so this step does not run the graph.
+          std::vector<Tensor> factorLogits;
+          std::vector<float> weights;
+          for(size_t i = 0; i < scorers_.size(); ++i) {
+            factorLogits.push_back(states[i]->getLogProbs().getFactoredLogitsTensor(factorGroup)); // [maxBeamSize, 1, currentDimBatch, dimFactor]
+            weights.push_back(scorers_[i]->getWeight());
+          }
+          nBestBeamSize = maxBeamSize;
+          vocabSize = getFactorNBestList(factorLogits, weights, hypIndices, prevScores, maxBeamSize, currentDimBatch,
+                                         /*out*/ nBestPathScores, /*out*/ nBestKeys);
+        } else {
+          //**********************************************************************
+          // compute expanded path scores with word prediction probs from all scorers
+          auto expandedPathScores = prevPathScores; // will become [maxBeamSize, 1, currDimBatch, dimVocab]
+          Expr logProbs;
+          for(size_t i = 0; i < scorers_.size(); ++i) {
             // compute output probabilities for current output time step
             //  - uses hypIndices[index in beam, 1, batch index, 1] to reorder scorer state to reflect the top-N in beams[][]
             //  - adds prevWords [index in beam, 1, batch index, 1] to the scorer's target history
@@ -452,57 +532,46 @@ public:
               auto shortlist = scorers_[i]->getShortlist();
               logProbs = states[i]->getLogProbs().getFactoredLogits(factorGroup, shortlist); // [maxBeamSize, 1, currentDimBatch, dimVocab]
             }
+            // expand all hypotheses, [maxBeamSize, 1, currentDimBatch, 1] -> [maxBeamSize, 1, currentDimBatch, dimVocab]
+            expandedPathScores = expandedPathScores + scorers_[i]->getWeight() * logProbs;
           }
-          else {
-            // add secondary factors
-            // For those, we don't update the decoder-model state in any way.
-            // Instead, we just keep expanding with the factors.
-            // We will have temporary Word entries in hyps with some factors set to FACTOR_NOT_SPECIFIED.
-            // For some lemmas, a factor is not applicable. For those, the factor score is the same (zero)
-            // for all factor values. This would thus unnecessarily pollute the beam with identical copies,
-            // and push out other hypotheses. Hence, we exclude those here by setting the path score to
-            // INVALID_PATH_SCORE. Instead, toHyps() explicitly propagates those hyps by simply copying the
-            // previous hypothesis.
-            logProbs = states[i]->getLogProbs().getFactoredLogits(factorGroup, /*shortlist=*/ nullptr, hypIndices, maxBeamSize); // [maxBeamSize, 1, currentDimBatch, dimVocab]
-          }
-          // expand all hypotheses, [maxBeamSize, 1, currentDimBatch, 1] -> [maxBeamSize, 1, currentDimBatch, dimVocab]
-          expandedPathScores = expandedPathScores + scorers_[i]->getWeight() * logProbs;
-        }
-
-        // make beams continuous
-        expandedPathScores = swapAxes(expandedPathScores, 0, 2); // -> [currentDimBatch, 1, maxBeamSize, dimVocab]
-
-        // perform NN computation
-        if(t == 0 && factorGroup == 0)
-          graph->forward();
-        else
-          graph->forwardNext();
 
-        //**********************************************************************
-        // suppress specific symbols if not at right positions
-        if(unkColId != -1 && factorGroup == 0)
-          suppressWord(expandedPathScores, unkColId);
-        for(auto state : states)
-          state->blacklist(expandedPathScores, batch);
-
-        //**********************************************************************
-        // perform beam search
-
-        // find N best amongst the (maxBeamSize * dimVocab) hypotheses
-        std::vector<unsigned int> nBestKeys; // [currentDimBatch, maxBeamSize] flattened -> (batchIdx, beamHypIdx, word idx) flattened
-        std::vector<float> nBestPathScores;  // [currentDimBatch, maxBeamSize] flattened
-        getNBestList(/*in*/ expandedPathScores->val(), // [currentDimBatch, 1, maxBeamSize, dimVocab or dimShortlist]
-                    /*N=*/ maxBeamSize,              // desired beam size
-                    /*out*/ nBestPathScores, /*out*/ nBestKeys,
-                    /*first=*/t == 0 && factorGroup == 0); // @TODO: this is only used for checking presently, and should be removed altogether
-        // Now, nBestPathScores contain N-best expandedPathScores for each batch and beam,
-        // and nBestKeys for each their original location (batchIdx, beamHypIdx, word).
+          // make beams continuous
+          expandedPathScores = swapAxes(expandedPathScores, 0, 2); // -> [currentDimBatch, 1, maxBeamSize, dimVocab]
+
+          // perform NN computation
+          if(t == 0)
+            graph->forward();
+          else
+            graph->forwardNext();
+
+          //**********************************************************************
+          // suppress specific symbols if not at right positions
+          if(unkColId != -1)
+            suppressWord(expandedPathScores, unkColId);
+          for(auto state : states)
+            state->blacklist(expandedPathScores, batch);
+
+          //**********************************************************************
+          // perform beam search
+
+          // find N best amongst the (maxBeamSize * dimVocab) hypotheses
+          getNBestList(/*in*/ expandedPathScores->val(), // [currentDimBatch, 1, maxBeamSize, dimVocab or dimShortlist]
+                      /*N=*/ maxBeamSize,              // desired beam size
+                      /*out*/ nBestPathScores, /*out*/ nBestKeys,
+                      /*first=*/t == 0); // @TODO: this is only used for checking presently, and should be removed altogether
+          // Now, nBestPathScores contain N-best expandedPathScores for each batch and beam,
+          // and nBestKeys for each their original location (batchIdx, beamHypIdx, word).
+          nBestBeamSize = expandedPathScores->shape()[-2];
+          vocabSize = expandedPathScores->shape()[-1];
+        }
 
         // combine N-best sets with existing search space (beams) to updated search space
         beams = toHyps(nBestKeys, nBestPathScores,
-                       /*nBestBeamSize*/expandedPathScores->shape()[-2], // used for interpretation of keys
-                       /*vocabSize=*/expandedPathScores->shape()[-1],    // used for interpretation of keys
+                       nBestBeamSize,
+                       vocabSize,
                        beams,
+                       *arena,    // storage of the new hypotheses
                        states,    // used for keeping track of per-ensemble-member path score
                        batch,     // only used for propagating alignment info
                        factoredVocab, factorGroup,
@@ -522,7 +591,7 @@ public:
       for(int batchIdx = 0; batchIdx < origDimBatch; ++batchIdx) {
         // if this batch entry has surviving hyps then add them to the traceback grid
         if(!beams[batchIdx].empty()) { // if the beam is not empty expand the history object associated with the beam
-          if (histories[batchIdx]->size() >= options_->get<float>("max-length-factor") * batch->front()->batchWidth())
+          if (histories[batchIdx]->size() >= maxLength)
             maxLengthReached = true;
           histories[batchIdx]->add(beams[batchIdx], trgEosId, purgedNewBeams[batchIdx].empty() || maxLengthReached);
         }
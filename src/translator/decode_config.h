@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common/options.h"
+
+#include <string>
+
+namespace marian {
+
+// Decoding options used by BeamSearch and OutputPrinter, resolved once from the Options. The
+// search reads some of them in every time step and for every sentence, where looking them up by
+// name in the Options is a measurable share of the CPU time for small batches. Options are also
+// not thread-safe, while a DecodeConfig can be shared by all translation threads.
+struct DecodeConfig {
+  size_t beamSize{12};
+  float normalize{0.f};        // length normalization exponent of the final sentence scores
+  float wordPenalty{0.f};      // subtracted from the final sentence score for each word
+  float maxLengthFactor{3.f};  // maximum target length as source length times factor
+  bool allowUnk{false};
+  bool nBest{false};
+  std::string alignment;       // type of word alignment, empty if none
+  bool rightLeft{false};       // right-to-left model that needs reversed word order on output
+  bool wordScores{false};
+
+  DecodeConfig() {}
+  explicit DecodeConfig(Ptr<const Options> options)
+      : beamSize(options->get<size_t>("beam-size")),
+        normalize(options->get<float>("normalize")),
+        wordPenalty(options->get<float>("word-penalty")),
+        maxLengthFactor(options->get<float>("max-length-factor")),
+        allowUnk(options->get<bool>("allow-unk", false)),
+        nBest(options->get<bool>("n-best", false)),
+        alignment(options->get<std::string>("alignment", "")),
+        rightLeft(options->get<bool>("right-left", false)),
+        wordScores(options->get<bool>("word-scores", false)) {}
+};
+
+}  // namespace marian
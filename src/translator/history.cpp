@@ -2,6 +2,6 @@
 
 namespace marian {
 
-History::History(size_t lineNo, float alpha, float wp)
-    : lineNo_(lineNo), alpha_(alpha), wp_(wp) {}
+History::History(size_t lineNo, Ptr<const HypothesisArena> arena, float alpha, float wp)
+    : arena_(arena), lineNo_(lineNo), alpha_(alpha), wp_(wp) {}
 }  // namespace marian
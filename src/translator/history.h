@@ -22,13 +22,14 @@ private:
   float lengthPenalty(size_t length) { return std::pow((float)length, alpha_); }
   float wordPenalty(size_t length) { return wp_ * (float)length; }
 public:
-  History(size_t lineNo, float alpha = 1.f, float wp_ = 0.f);
+  // arena holds the hypotheses added to this history, it may be shared with other histories of the same search
+  History(size_t lineNo, Ptr<const HypothesisArena> arena, float alpha = 1.f, float wp_ = 0.f);
 
   void add(const Beam& beam, Word trgEosId, bool last = false) {
-    if(beam.back()->getPrevHyp() != nullptr) { // if not start hyp do
+    if(beam.back().getPrevHyp()) { // if not start hyp do
       for(size_t beamIdx = 0; beamIdx < beam.size(); ++beamIdx)
-        if(beam[beamIdx]->getWord() == trgEosId || last) { // if this is a final hyp do
-          float pathScore = (beam[beamIdx]->getPathScore() - wordPenalty(history_.size())) / lengthPenalty(history_.size()); // get and normalize path score
+        if(beam[beamIdx].getWord() == trgEosId || last) { // if this is a final hyp do
+          float pathScore = (beam[beamIdx].getPathScore() - wordPenalty(history_.size())) / lengthPenalty(history_.size()); // get and normalize path score
           topHyps_.push({history_.size(), beamIdx, pathScore}); // push final hyp on queue of scored hyps
         }
     }
@@ -44,12 +45,12 @@ public:
 
       const size_t timeStepIdx = bestHypCoord.timeStepIdx; // last time step of this hypothesis
       const size_t beamIdx     = bestHypCoord.beamIdx;     // which beam entry
-      Hypothesis::PtrType bestHyp = history_[timeStepIdx][beamIdx];
+      Hypothesis bestHyp = history_[timeStepIdx][beamIdx];
 
       // trace back best path
-      Words targetWords = bestHyp->tracebackWords();
+      Words targetWords = bestHyp.tracebackWords();
 
-      // note: bestHyp->getPathScore() is not normalized, while bestHypCoord.normalizedPathScore is
+      // note: bestHyp.getPathScore() is not normalized, while bestHypCoord.normalizedPathScore is
       nbest.emplace_back(targetWords, bestHyp, bestHypCoord.normalizedPathScore);
     }
     return nbest;
@@ -64,6 +65,7 @@ public:
   size_t getLineNum() const { return lineNo_; }
 
 private:
+  Ptr<const HypothesisArena> arena_; // storage of the hypotheses in history_, which are only handles
   std::vector<Beam> history_; // [time step][index into beam] search grid @TODO: simplify as this is currently an expensive length count
   std::priority_queue<SentenceHypothesisCoord> topHyps_; // all sentence hypotheses (those that reached eos), sorted by score
   size_t lineNo_;
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <limits>
 #include <memory>
 
 #include "common/definitions.h"
@@ -6,66 +8,136 @@
 
 namespace marian {
 
+// Storage for all hypotheses created during one call of BeamSearch::search(), as a structure of
+// arrays indexed by hypothesis. Expanding a hypothesis appends one row, so the search does not
+// allocate and reference-count one object per hypothesis; back pointers are row indices.
+// Score breakdowns (n-best lists) have a fixed number of entries per row and are only stored if
+// numScores > 0; alignments are appended to one buffer and referenced by offset and length, so
+// hypotheses that keep the alignment of their predecessor share it.
+class HypothesisArena {
+public:
+  static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+  // creates the arena with the sentence-start hypothesis in row 0
+  HypothesisArena(size_t numScores = 0) : numScores_(numScores) { add(NONE, Word::ZERO, 0, 0.f); }
+
+  void reserve(size_t rows) {
+    words_.reserve(rows);
+    prevIndices_.reserve(rows);
+    prevBeamHypIndices_.reserve(rows);
+    pathScores_.reserve(rows);
+    alignOffsets_.reserve(rows);
+    alignLengths_.reserve(rows);
+    scoreBreakdowns_.reserve(rows * numScores_);
+  }
+
+  // appends a hypothesis with an all-zero score breakdown and no alignment, returns its index
+  uint32_t add(uint32_t prevIndex, Word word, size_t prevBeamHypIdx, float pathScore) {
+    ABORT_IF(words_.size() >= NONE, "Too many hypotheses in one search");
+    words_.push_back(word);
+    prevIndices_.push_back(prevIndex);
+    prevBeamHypIndices_.push_back((uint32_t)prevBeamHypIdx);
+    pathScores_.push_back(pathScore);
+    alignOffsets_.push_back(0);
+    alignLengths_.push_back(0);
+    scoreBreakdowns_.resize(scoreBreakdowns_.size() + numScores_, 0.f);
+    return (uint32_t)(words_.size() - 1);
+  }
+
+  size_t size() const { return words_.size(); }
+  size_t numScores() const { return numScores_; }
+
+  uint32_t getPrevIndex(uint32_t i) const { return prevIndices_[i]; }
+  Word getWord(uint32_t i) const { return words_[i]; }
+  size_t getPrevBeamHypIdx(uint32_t i) const { return prevBeamHypIndices_[i]; }
+  float getPathScore(uint32_t i) const { return pathScores_[i]; }
+
+  // [numScores] entries, invalidated by add()
+  float* scoreBreakdown(uint32_t i) { return scoreBreakdowns_.data() + i * numScores_; }
+  const float* scoreBreakdown(uint32_t i) const { return scoreBreakdowns_.data() + i * numScores_; }
+
+  void setAlignment(uint32_t i, const std::vector<float>& align) {
+    alignOffsets_[i] = alignments_.size();
+    alignLengths_[i] = (uint32_t)align.size();
+    alignments_.insert(alignments_.end(), align.begin(), align.end());
+  }
+  // lets hypothesis i refer to the alignment of hypothesis from, without copying it
+  void shareAlignment(uint32_t i, uint32_t from) {
+    alignOffsets_[i] = alignOffsets_[from];
+    alignLengths_[i] = alignLengths_[from];
+  }
+  std::vector<float> getAlignment(uint32_t i) const {
+    auto begin = alignments_.begin() + alignOffsets_[i];
+    return std::vector<float>(begin, begin + alignLengths_[i]);
+  }
+
+private:
+  size_t numScores_;
+
+  std::vector<Word> words_;                 // the word that the hypothesis ends with
+  std::vector<uint32_t> prevIndices_;       // row of the previous hypothesis, NONE for the start
+  std::vector<uint32_t> prevBeamHypIndices_; // beam-hyp index that the hypothesis originated from
+  std::vector<float> pathScores_;           // aggregate score up to and including the word
+  std::vector<size_t> alignOffsets_;        // into alignments_
+  std::vector<uint32_t> alignLengths_;
+
+  std::vector<float> scoreBreakdowns_; // [rows, numScores] flattened
+  std::vector<float> alignments_;      // P(s|t) of all hypotheses, concatenated
+};
+
 // one single (partial or full) hypothesis in beam search
 // key elements:
 //  - the word that this hyp ends with
 //  - the aggregate score up to and including the word
 //  - back pointer to previous hypothesis for traceback
+// A Hypothesis is a cheap handle to a row of a HypothesisArena and is only valid as long as the
+// arena is, which is kept alive by the Histories returned from the search.
 class Hypothesis {
-public:
-  typedef IPtr<Hypothesis> PtrType;
-
 private:
-  // Constructors are private, use Hypothesis::New(...)
+  const HypothesisArena* arena_{nullptr};
+  uint32_t index_{HypothesisArena::NONE};
 
-  Hypothesis() : prevHyp_(nullptr), prevBeamHypIdx_(0), word_(Word::ZERO), pathScore_(0.0) {}
+public:
+  Hypothesis() {}
+  Hypothesis(const HypothesisArena* arena, uint32_t index) : arena_(arena), index_(index) {}
 
-  Hypothesis(const PtrType prevHyp,
-             Word word,
-             size_t prevBeamHypIdx, // beam-hyp index that this hypothesis originated from
-             float pathScore)
-      : prevHyp_(prevHyp), prevBeamHypIdx_(prevBeamHypIdx), word_(word), pathScore_(pathScore) {}
+  // false for the empty handle, e.g. the result of getPrevHyp() on a sentence-start hypothesis
+  explicit operator bool() const { return index_ != HypothesisArena::NONE; }
 
-public:
- // Use this whenever creating a pointer to MemoryPiece
- template <class ...Args>
- static PtrType New(Args&& ...args) {
-   return PtrType(new Hypothesis(std::forward<Args>(args)...));
- }
+  uint32_t getIndex() const { return index_; }
 
-  const PtrType getPrevHyp() const { return prevHyp_; }
+  Hypothesis getPrevHyp() const { return Hypothesis(arena_, arena_->getPrevIndex(index_)); }
 
-  Word getWord() const { return word_; }
+  Word getWord() const { return arena_->getWord(index_); }
 
-  size_t getPrevStateIndex() const { return prevBeamHypIdx_; }
+  size_t getPrevStateIndex() const { return arena_->getPrevBeamHypIdx(index_); }
 
-  float getPathScore() const { return pathScore_; }
+  float getPathScore() const { return arena_->getPathScore(index_); }
 
-  const std::vector<float>& getScoreBreakdown() { return scoreBreakdown_; }
-  void setScoreBreakdown(const std::vector<float>& scoreBreakdown) { scoreBreakdown_ = scoreBreakdown; }
+  std::vector<float> getScoreBreakdown() const {
+    const float* scores = arena_->scoreBreakdown(index_);
+    return std::vector<float>(scores, scores + arena_->numScores());
+  }
 
-  const std::vector<float>& getAlignment() { return alignment_; }
-  void setAlignment(const std::vector<float>& align) { alignment_ = align; };
+  std::vector<float> getAlignment() const { return arena_->getAlignment(index_); }
 
   // trace back paths referenced from this hypothesis
-  Words tracebackWords() {
+  Words tracebackWords() const {
     Words targetWords;
-    for(auto hyp = this; hyp->getPrevHyp(); hyp = hyp->getPrevHyp().get()) {
-      targetWords.push_back(hyp->getWord());
-    }
+    for(auto i = index_; arena_->getPrevIndex(i) != HypothesisArena::NONE; i = arena_->getPrevIndex(i))
+      targetWords.push_back(arena_->getWord(i));
     std::reverse(targetWords.begin(), targetWords.end());
     return targetWords;
   }
 
   // calculate word-level scores for each target word by de-aggregating the path score
-  std::vector<float> tracebackWordScores() {
+  std::vector<float> tracebackWordScores() const {
     std::vector<float> scores;
     // traverse hypotheses backward
-    for(auto hyp = this; hyp->getPrevHyp(); hyp = hyp->getPrevHyp().get()) {
+    for(auto i = index_; arena_->getPrevIndex(i) != HypothesisArena::NONE; i = arena_->getPrevIndex(i)) {
       // a path score is a cumulative score including scores from all preceding hypotheses (words),
       // so calculate a word-level score by subtracting the previous path score from the current path score
-      auto prevPathScore = hyp->getPrevHyp() ? hyp->getPrevHyp().get()->pathScore_ : 0.f;
-      scores.push_back(hyp->pathScore_ - prevPathScore);
+      scores.push_back(arena_->getPathScore(i) - arena_->getPathScore(arena_->getPrevIndex(i)));
     }
     std::reverse(scores.begin(), scores.end());
     return scores;
@@ -73,29 +145,17 @@ public:
 
   // get soft alignments [t][s] -> P(s|t) for each target word starting from the hyp one
   typedef data::SoftAlignment SoftAlignment;
-  SoftAlignment tracebackAlignment() {
+  SoftAlignment tracebackAlignment() const {
     SoftAlignment align;
-    for(auto hyp = this; hyp->getPrevHyp(); hyp = hyp->getPrevHyp().get()) {
-      align.push_back(hyp->getAlignment());
-    }
+    for(auto i = index_; arena_->getPrevIndex(i) != HypothesisArena::NONE; i = arena_->getPrevIndex(i))
+      align.push_back(arena_->getAlignment(i));
     std::reverse(align.begin(), align.end());
     return align;  // [t][s] -> P(s|t)
   }
-
-private:
-  const PtrType prevHyp_;
-  const size_t prevBeamHypIdx_;
-  const Word word_;
-  const float pathScore_;
-
-  std::vector<float> scoreBreakdown_; // [num scorers]
-  std::vector<float> alignment_;
-
-  ENABLE_INTRUSIVE_PTR(Hypothesis)
 };
 
-typedef std::vector<IPtr<Hypothesis>> Beam;                // Beam = vector [beamSize] of hypotheses
-typedef std::vector<Beam> Beams;                          // Beams = vector [batchDim] of vector [beamSize] of hypotheses
-typedef std::tuple<Words, IPtr<Hypothesis>, float> Result; // (word ids for hyp, hyp, normalized sentence score for hyp)
-typedef std::vector<Result> NBestList;                    // sorted vector of (word ids, hyp, sent score) tuples
+typedef std::vector<Hypothesis> Beam;                 // Beam = vector [beamSize] of hypotheses
+typedef std::vector<Beam> Beams;                      // Beams = vector [batchDim] of vector [beamSize] of hypotheses
+typedef std::tuple<Words, Hypothesis, float> Result;  // (word ids for hyp, hyp, normalized sentence score for hyp)
+typedef std::vector<Result> NBestList;                // sorted vector of (word ids, hyp, sent score) tuples
 }  // namespace marian
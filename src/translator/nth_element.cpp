@@ -31,8 +31,17 @@ public:
     const auto inputN    = scores->shape()[-2];
     const auto dimBatch  = scores->shape()[-4];
     ABORT_IF(inputN != (isFirst ? 1 : N), "Input tensor has wrong beam dim??"); // @TODO: Remove isFirst argument altogether
-    const float* scoresData = scores->data();
+    getNBestList(scores->data(), dimBatch, inputN, vocabSize, N, outPathScores, outKeys);
+  }
 
+  // same for scores in host memory
+  void getNBestList(const float* scoresData, // [dimBatch, 1, inputN, vocabSize]
+                    size_t dimBatch,
+                    size_t inputN,
+                    size_t vocabSize,
+                    size_t N,
+                    std::vector<float>& outPathScores,
+                    std::vector<unsigned>& outKeys) {
     size_t maxSize = N * dimBatch;
     h_res.resize(maxSize);
     h_res_idx.resize(maxSize);
@@ -102,4 +111,15 @@ GetNBestListFn createGetNBestListFn(size_t beamSize, size_t dimBatch, DeviceId d
   };
 }
 
+void getNBestListCPU(const float* scores,
+                    size_t dimBatch,
+                    size_t beamSize,
+                    size_t vocabSize,
+                    size_t N,
+                    std::vector<float>& outPathScores,
+                    std::vector<unsigned>& outKeys) {
+  thread_local NthElementCPU nth;
+  nth.getNBestList(scores, dimBatch, beamSize, vocabSize, N, outPathScores, outKeys);
+}
+
 }  // namespace marian
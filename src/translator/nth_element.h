@@ -17,4 +17,14 @@ typedef std::function<void(Tensor logProbs,
                            const bool isFirst)> GetNBestListFn;
 
 GetNBestListFn createGetNBestListFn(size_t beamSize, size_t dimBatch, DeviceId deviceId);
+
+// Same as the CPU version of the above for scores that are already in host memory, e.g. because they
+// were computed on the host. Keys are positions in scores [dimBatch, 1, beamSize, vocabSize].
+void getNBestListCPU(const float* scores,
+                    size_t dimBatch,
+                    size_t beamSize,
+                    size_t vocabSize,
+                    size_t N,
+                    std::vector<float>& outPathScores,
+                    std::vector<unsigned>& outKeys);
 }  // namespace marian
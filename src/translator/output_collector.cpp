@@ -2,80 +2,138 @@
 #include "common/file_stream.h"
 #include "common/logging.h"
 
-#include <cassert>
 
 namespace marian {
 
+// the writer thread hands its buffer to the stream at this size even if more outputs are ready
+static const size_t WRITE_BLOCK_BYTES = 1 << 20;
+
 OutputCollector::OutputCollector()
-  : nextId_(0),
-    printing_(new DefaultPrinting()) {}
+  : printing_(new DefaultPrinting()) {
+  start(DEFAULT_WINDOW_SIZE);
+}
 
-OutputCollector::OutputCollector(std::string outFile)
-  : nextId_(0),
-    outStrm_(new std::ostream(std::cout.rdbuf())),
+OutputCollector::OutputCollector(std::string outFile, size_t windowSize)
+  : outStrm_(new std::ostream(std::cout.rdbuf())),
     printing_(new DefaultPrinting()) {
   if (outFile != "stdout")
     outStrm_.reset(new io::OutputFileStream(outFile));
+  start(windowSize);
+}
+
+OutputCollector::~OutputCollector() {
+  close();
+}
+
+void OutputCollector::close() {
+  if(!writer_.joinable()) // already closed
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  ready_.notify_one();
+  writer_.join();
+  outStrm_.reset();
+}
+
+void OutputCollector::start(size_t windowSize) {
+  ABORT_IF(windowSize == 0, "Output collector needs a window of at least one output");
+  windowSize_ = windowSize;
+  slots_.reset(new Slot[windowSize_]);
+  writer_ = std::thread([this]() { writeLoop(); });
 }
 
 void OutputCollector::Write(long sourceId,
                             const std::string& best1,
                             const std::string& bestn,
                             bool nbest) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  if(sourceId == nextId_) {
-    if(printing_->shouldBePrinted(sourceId))
-      LOG(info, "Best translation {} : {}", sourceId, best1);
-
-    if(outStrm_) {
-      if(nbest)
-        *outStrm_ << bestn << std::endl;
-      else
-        *outStrm_ << best1 << std::endl;
-    }
+  // nextId_ only grows, so a stale value can only send an output to the overflow map unnecessarily;
+  // the slot of an id within the window has been released by the writer before nextId_ was advanced
+  if(sourceId - nextId_.load(std::memory_order_acquire) < (long)windowSize_) {
+    auto& slot = slots_[sourceId % windowSize_];
+    slot.best1 = best1; // reuses the memory of earlier outputs in this slot
+    slot.bestn = bestn;
+    slot.nbest = nbest;
+    slot.id.store(sourceId); // publish
+  } else {
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    overflow_[sourceId] = std::make_pair(best1, nbest ? bestn : best1);
+    overflowSize_ = overflow_.size();
+  }
 
-    ++nextId_;
-
-    Outputs::const_iterator iter, iterNext;
-    iter = outputs_.begin();
-    while(iter != outputs_.end()) {
-      long currId = iter->first;
-
-      if(currId == nextId_) {
-        // 1st element in the map is the next
-        const auto& currOutput = iter->second;
-        if(printing_->shouldBePrinted(currId))
-          LOG(info, "Best translation {} : {}", currId, currOutput.first);
-
-        if(outStrm_) {
-          if(nbest)
-            *outStrm_ << currOutput.second << std::endl;
-          else
-            *outStrm_ << currOutput.first << std::endl;
-        }
-
-        ++nextId_;
-
-        // delete current record, move iter on 1
-        iterNext = iter;
-        ++iterNext;
-        outputs_.erase(iter);
-        iter = iterNext;
-      } else {
-        // not the next. stop iterating
-        assert(nextId_ < currId);
-        break;
-      }
-    }
+  // paired with the writer setting writerWaiting_ before it checks for ready outputs under mutex_
+  if(writerWaiting_.load()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.notify_one();
+  }
+}
 
-    // for 1-best, flush stdout so that we can consume this immediately from an
-    // external process
-    if(outStrm_ && !nbest)
-      *outStrm_ << std::flush;
+bool OutputCollector::isNextReady() {
+  long id = nextId_.load(std::memory_order_relaxed);
+  if(slots_[id % windowSize_].id.load() == id)
+    return true;
+  if(overflowSize_.load() == 0)
+    return false;
+  std::lock_guard<std::mutex> lock(overflowMutex_);
+  return overflow_.count(id) > 0;
+}
 
+bool OutputCollector::takeNext(std::string& buffer) {
+  long id = nextId_.load(std::memory_order_relaxed); // only this thread changes it
+  auto& slot = slots_[id % windowSize_];
+  if(slot.id.load(std::memory_order_acquire) == id) {
+    append(buffer, id, slot.best1, slot.nbest ? slot.bestn : slot.best1);
+    slot.id.store(-1, std::memory_order_release);
   } else {
-    // save for later
-    outputs_[sourceId] = std::make_pair(best1, bestn);
+    if(overflowSize_.load() == 0)
+      return false;
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    auto it = overflow_.find(id);
+    if(it == overflow_.end())
+      return false;
+    append(buffer, id, it->second.first, it->second.second);
+    overflow_.erase(it);
+    overflowSize_ = overflow_.size();
+  }
+  nextId_.store(id + 1, std::memory_order_release);
+  return true;
+}
+
+void OutputCollector::append(std::string& buffer, long id, const std::string& best1, const std::string& text) {
+  if(printing_->shouldBePrinted(id))
+    LOG(info, "Best translation {} : {}", id, best1);
+  if(outStrm_) {
+    buffer += text;
+    buffer += '\n';
+  }
+}
+
+void OutputCollector::flush(std::string& buffer) {
+  if(outStrm_ && !buffer.empty()) {
+    outStrm_->write(buffer.data(), buffer.size());
+    // flush so that outputs can be consumed immediately from an external process
+    outStrm_->flush();
+  }
+  buffer.clear();
+}
+
+void OutputCollector::writeLoop() {
+  std::string buffer;
+  for(;;) {
+    if(takeNext(buffer)) {
+      if(buffer.size() >= WRITE_BLOCK_BYTES)
+        flush(buffer);
+      continue;
+    }
+
+    flush(buffer); // caught up with the translators
+    std::unique_lock<std::mutex> lock(mutex_);
+    writerWaiting_.store(true);
+    ready_.wait(lock, [this]() { return done_ || isNextReady(); });
+    writerWaiting_.store(false);
+    if(done_ && !isNextReady())
+      break;
   }
 }
 
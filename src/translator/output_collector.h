@@ -3,9 +3,12 @@
 #include "common/definitions.h"
 #include "common/file_stream.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <iostream>
 #include <map>
+#include <thread>
 
 namespace marian {
 
@@ -44,16 +47,31 @@ private:
   long next_{10};
 };
 
+// Writes translations in the order of their source ids while they arrive in any order from the
+// translation threads. Outputs are handed over through a preallocated ring of slots indexed by
+// source id, without taking a lock; a dedicated writer thread takes them out in order and writes
+// them in large blocks, flushing the stream whenever it has caught up with the translators.
+// Outputs too far ahead of the next id to be written go to a map that is protected by a mutex.
 class OutputCollector {
 public:
   OutputCollector();
-  OutputCollector(std::string outFile);
+  OutputCollector(std::string outFile, size_t windowSize = DEFAULT_WINDOW_SIZE);
 
   template <class T>
-  OutputCollector(T&& arg) : nextId_(0), outStrm_(new io::OutputFileStream(arg)) {}
+  OutputCollector(T&& arg) : outStrm_(new io::OutputFileStream(arg)), printing_(new DefaultPrinting()) {
+    start(DEFAULT_WINDOW_SIZE);
+  }
 
   OutputCollector(const OutputCollector&) = delete;
 
+  // calls close() if it has not been called yet
+  ~OutputCollector();
+
+  // writes all outputs up to the first missing source id, ends the writer thread and closes the
+  // output, so that the file is complete while other owners may still hold the collector. Outputs
+  // that arrive after this are not written.
+  void close();
+
   void Write(long sourceId,
              const std::string& best1,
              const std::string& bestn,
@@ -63,13 +81,41 @@ public:
     printing_ = strategy;
   }
 
+  static const size_t DEFAULT_WINDOW_SIZE = 4096;
+
 protected:
+  struct Slot {
+    std::atomic<long> id{-1}; // source id of the output in this slot once it is complete, -1 if free
+    std::string best1;
+    std::string bestn;
+    bool nbest{false};
+  };
+
   typedef std::map<long, std::pair<std::string, std::string>> Outputs;
-  Outputs outputs_;
-  long nextId_;
+
+  void start(size_t windowSize);
+  void writeLoop();
+  bool isNextReady();
+  bool takeNext(std::string& buffer);
+  void append(std::string& buffer, long id, const std::string& best1, const std::string& text);
+  void flush(std::string& buffer);
+
   UPtr<std::ostream> outStrm_;
   Ptr<PrintingStrategy> printing_;
-  std::mutex mutex_;
+
+  size_t windowSize_{0};
+  UPtr<Slot[]> slots_;            // [windowSize_], output with source id i goes to slot i % windowSize_
+  std::atomic<long> nextId_{0};   // next source id to write, only advanced by the writer thread
+
+  Outputs overflow_;              // outputs with ids beyond the window
+  std::atomic<size_t> overflowSize_{0};
+  std::mutex overflowMutex_;
+
+  std::thread writer_;
+  std::mutex mutex_;              // for sleeping and waking up the writer only
+  std::condition_variable ready_;
+  std::atomic<bool> writerWaiting_{false};
+  bool done_{false};
 };
 
 class StringCollector {
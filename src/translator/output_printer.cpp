@@ -4,17 +4,9 @@
 
 namespace marian {
 
-std::string OutputPrinter::getAlignment(const Hypothesis::PtrType& hyp) {
-  data::SoftAlignment align;
-  auto last = hyp;
-  // get soft alignments for each target word starting from the last one
-  while(last->getPrevHyp().get() != nullptr) {
-    align.push_back(last->getAlignment());
-    last = last->getPrevHyp();
-  }
-
-  // reverse alignments
-  std::reverse(align.begin(), align.end());
+std::string OutputPrinter::getAlignment(const Hypothesis& hyp) {
+  // get soft alignments for each target word
+  data::SoftAlignment align = hyp.tracebackAlignment();
 
   if(alignment_ == "soft") {
     return data::SoftAlignToString(align);
@@ -27,10 +19,10 @@ std::string OutputPrinter::getAlignment(const Hypothesis::PtrType& hyp) {
   }
 }
 
-std::string OutputPrinter::getWordScores(const Hypothesis::PtrType& hyp) {
+std::string OutputPrinter::getWordScores(const Hypothesis& hyp) {
   std::ostringstream scores;
   scores.precision(5);
-  for(const auto& score : hyp->tracebackWordScores())
+  for(const auto& score : hyp.tracebackWordScores())
     scores << " " << std::fixed << score;
   return scores.str();
 }
@@ -6,6 +6,7 @@
 #include "common/utils.h"
 #include "data/alignment.h"
 #include "data/vocab.h"
+#include "translator/decode_config.h"
 #include "translator/history.h"
 #include "translator/hypothesis.h"
 
@@ -13,15 +14,16 @@ namespace marian {
 
 class OutputPrinter {
 public:
-  OutputPrinter(Ptr<const Options> options, Ptr<const Vocab> vocab)
+  OutputPrinter(const DecodeConfig& config, Ptr<const Vocab> vocab)
       : vocab_(vocab),
-        reverse_(options->get<bool>("right-left")),
-        nbest_(options->get<bool>("n-best", false)
-                   ? options->get<size_t>("beam-size")
-                   : 0),
-        alignment_(options->get<std::string>("alignment", "")),
+        reverse_(config.rightLeft),
+        nbest_(config.nBest ? config.beamSize : 0),
+        alignment_(config.alignment),
         alignmentThreshold_(getAlignmentThreshold(alignment_)),
-        wordScores_(options->get<bool>("word-scores")) {}
+        wordScores_(config.wordScores) {}
+
+  OutputPrinter(Ptr<const Options> options, Ptr<const Vocab> vocab)
+      : OutputPrinter(DecodeConfig(options), vocab) {}
 
   template <class OStream>
   void print(Ptr<const History> history, OStream& best1, OStream& bestn) {
@@ -46,11 +48,12 @@ public:
         bestn << " ||| WordScores=" << getWordScores(hypo);
 
       bestn << " |||";
-      if(hypo->getScoreBreakdown().empty()) {
-        bestn << " F0=" << hypo->getPathScore();
+      auto scoreBreakdown = hypo.getScoreBreakdown();
+      if(scoreBreakdown.empty()) {
+        bestn << " F0=" << hypo.getPathScore();
       } else {
-        for(size_t j = 0; j < hypo->getScoreBreakdown().size(); ++j) {
-          bestn << " F" << j << "= " << hypo->getScoreBreakdown()[j];
+        for(size_t j = 0; j < scoreBreakdown.size(); ++j) {
+          bestn << " F" << j << "= " << scoreBreakdown[j];
         }
       }
 
@@ -94,9 +97,9 @@ private:
   bool wordScores_{false};         // Whether to print word-level scores or not
 
   // Get word alignment pairs or soft alignment
-  std::string getAlignment(const Hypothesis::PtrType& hyp);
+  std::string getAlignment(const Hypothesis& hyp);
   // Get word-level scores
-  std::string getWordScores(const Hypothesis::PtrType& hyp);
+  std::string getWordScores(const Hypothesis& hyp);
 
   float getAlignmentThreshold(const std::string& str) {
     try {
@@ -7,6 +7,8 @@
 
 #include "3rd_party/threadpool.h"
 
+#include "graph/op_profiler.h"
+#include "translator/decode_config.h"
 #include "translator/history.h"
 #include "translator/output_collector.h"
 #include "translator/output_printer.h"
@@ -14,6 +16,8 @@
 #include "models/model_task.h"
 #include "translator/scorers.h"
 
+#include <atomic>
+
 // currently for diagnostics only, will try to mmap files ending in *.bin suffix when enabled.
 // @TODO: add this as an actual feature.
 #define MMAP 0
@@ -28,6 +32,7 @@ template <class Search>
 class Translate : public ModelTask {
 private:
   Ptr<Options> options_;
+  DecodeConfig decodeConfig_; // decoding options, resolved once and shared by all threads
   std::vector<Ptr<ExpressionGraph>> graphs_;
   std::vector<std::vector<Ptr<Scorer>>> scorers_;
 
@@ -49,6 +54,7 @@ public:
 
     options_->set("inference", true,
                   "shuffle", "none");
+    decodeConfig_ = DecodeConfig(options_);
 
     corpus_ = New<data::Corpus>(options_, true);
 
@@ -90,6 +96,8 @@ public:
           graph->getBackend()->setOptimized(options_->get<bool>("optimize"));
         }
         graph->reserveWorkspaceMB(options_->get<size_t>("workspace"));
+        graph->setMemoryPlanning(options_->get<bool>("memory-planning", false));
+        graph->setElementwiseFusion(options_->get<bool>("fuse-elementwise", false));
         graphs_[id] = graph;
 
 #if MMAP
@@ -123,35 +131,49 @@ public:
   }
 
   void run() override {
+    auto opTrace = options_->get<std::string>("profile-ops-trace", "");
+    if(options_->get<bool>("profile-ops", false) || !opTrace.empty())
+      OpProfiler::enable(opTrace);
+
     data::BatchGenerator<data::Corpus> bg(corpus_, options_);
 
     ThreadPool threadPool(numDevices_, numDevices_);
 
     size_t batchId = 0;
     auto collector = New<OutputCollector>(options_->get<std::string>("output"));
-    auto printer = New<OutputPrinter>(options_, trgVocab_);
+    auto printer = New<OutputPrinter>(decodeConfig_, trgVocab_);
     if(options_->get<bool>("quiet-translation"))
       collector->setPrintingStrategy(New<QuietPrinting>());
 
     bg.prepare();
 
-    bool doNbest = options_->get<bool>("n-best");
+    // identifies this call among all calls of run() of any translator, so that the threads do not
+    // reuse the graph, scorers and search of another translator or an earlier call
+    static std::atomic<size_t> runs{0};
+    size_t runId = ++runs;
+
+    bool doNbest = decodeConfig_.nBest;
     for(auto batch : bg) {
       auto task = [=](size_t id) {
+        thread_local size_t searchRunId = 0;
         thread_local Ptr<ExpressionGraph> graph;
         thread_local std::vector<Ptr<Scorer>> scorers;
+        thread_local Ptr<Search> search; // holds no per-batch state, reused for all batches of this thread in this run
 
-        if(!graph) {
+        if(searchRunId != runId) {
           graph = graphs_[id % numDevices_];
           scorers = scorers_[id % numDevices_];
+          search = New<Search>(decodeConfig_, scorers, trgVocab_);
+          searchRunId = runId;
         }
 
-        auto search = New<Search>(options_, scorers, trgVocab_);
         auto histories = search->search(graph, batch);
 
+        thread_local std::stringstream best1; // reused for all outputs of this thread
+        thread_local std::stringstream bestn;
         for(auto history : histories) {
-          std::stringstream best1;
-          std::stringstream bestn;
+          best1.str(std::string());
+          bestn.str(std::string());
           printer->print(history, best1, bestn);
           collector->Write((long)history->getLineNum(),
                            best1.str(),
@@ -174,6 +196,10 @@ public:
       threadPool.enqueue(task, batchId++);
 
     }
+
+    threadPool.join_all(); // all batches are translated
+    collector->close();
+    OpProfiler::disable();
   }
 };
 
@@ -181,6 +207,7 @@ template <class Search>
 class TranslateService : public ModelServiceTask {
 private:
   Ptr<Options> options_;
+  DecodeConfig decodeConfig_; // decoding options, resolved once and shared by all threads
   std::vector<Ptr<ExpressionGraph>> graphs_;
   std::vector<std::vector<Ptr<Scorer>>> scorers_;
 
@@ -198,6 +225,7 @@ public:
     // initialize vocabs
     options_->set("inference", true);
     options_->set("shuffle", "none");
+    decodeConfig_ = DecodeConfig(options_);
 
     auto vocabPaths = options_->get<std::vector<std::string>>("vocabs");
     std::vector<int> maxVocabs = options_->get<std::vector<int>>("dim-vocabs");
@@ -232,6 +260,8 @@ public:
         graph->getBackend()->setOptimized(options_->get<bool>("optimize"));
       }
       graph->reserveWorkspaceMB(options_->get<size_t>("workspace"));
+      graph->setMemoryPlanning(options_->get<bool>("memory-planning", false));
+      graph->setElementwiseFusion(options_->get<bool>("fuse-elementwise", false));
       graphs_.push_back(graph);
 
       auto scorers = createScorers(options_);
@@ -249,7 +279,7 @@ public:
     data::BatchGenerator<data::TextInput> batchGenerator(corpus_, options_);
 
     auto collector = New<StringCollector>();
-    auto printer = New<OutputPrinter>(options_, trgVocab_);
+    auto printer = New<OutputPrinter>(decodeConfig_, trgVocab_);
     size_t batchId = 0;
 
     batchGenerator.prepare();
@@ -262,13 +292,14 @@ public:
         auto task = [=](size_t id) {
           thread_local Ptr<ExpressionGraph> graph;
           thread_local std::vector<Ptr<Scorer>> scorers;
+          thread_local Ptr<Search> search;
 
           if(!graph) {
             graph = graphs_[id % numDevices_];
             scorers = scorers_[id % numDevices_];
+            search = New<Search>(decodeConfig_, scorers, trgVocab_);
           }
 
-          auto search = New<Search>(options_, scorers, trgVocab_);
           auto histories = search->search(graph, batch);
 
           for(auto history : histories) {
@@ -284,7 +315,7 @@ public:
       }
     }
 
-    auto translations = collector->collect(options_->get<bool>("n-best"));
+    auto translations = collector->collect(decodeConfig_.nBest);
     return utils::join(translations, "\n");
   }
 };